@@ -1,25 +1,136 @@
 #include "Adafruit_LvGL_Glue.h"
 #include <lvgl.h>
 
-// ARCHITECTURE-SPECIFIC TIMER STUFF ---------------------------------------
+// ARCHITECTURE-SPECIFIC TASK STUFF ----------------------------------------
+
+// LittlevGL keeps time through lv_tick_callback() (millis()), so no timer
+// interrupt is needed. LittlevGL itself and (on ESP32) the GUI task and lock
+// are shared by every glue instance: the first begin() starts them and they
+// then run for good. Each instance has its own display, input device,
+// buffers and flush state.
+static bool lv_task_running = false;
+
+#if LVGL_COMMAND_QUEUE
+// Widget updates posted by other tasks (postText() etc.), applied by the GUI
+// task between frames so neither side waits for the other. A bounded
+// lock-free queue: producers claim a slot by advancing lv_command_head with
+// compare-and-swap, and each slot's sequence number says whether it is free
+// (== its position), filled (position + 1), or not yet reached.
+typedef enum { LV_CMD_TEXT, LV_CMD_VALUE, LV_CMD_INVALIDATE } lv_command_type_t;
+
+typedef struct {
+  std::atomic<uint32_t> seq;
+  lv_command_type_t type;
+  lv_obj_t *obj;
+  int32_t value;
+  char text[LVGL_COMMAND_TEXT];
+} lv_command_t;
+
+static lv_command_t lv_commands[LVGL_COMMAND_QUEUE];
+static std::atomic<uint32_t> lv_command_head; // Next slot to claim
+static uint32_t lv_command_tail; // Next slot to apply; GUI task only
+
+// Empty the queue, before any task can post
+static void lv_commands_init(void) {
+  for (uint32_t i = 0; i < LVGL_COMMAND_QUEUE; i++) {
+    lv_commands[i].seq.store(i, std::memory_order_relaxed);
+  }
+  lv_command_head.store(0, std::memory_order_relaxed);
+  lv_command_tail = 0;
+}
 
-// Tick interval for LittlevGL internal timekeeping; 1 to 10 ms recommended
-static const int lv_tick_interval_ms = 10;
+// Claims the next free slot for a producer, or NULL if the queue is full.
+// The slot is the producer's until lv_command_done().
+static lv_command_t *lv_command_claim(void) {
+  uint32_t pos = lv_command_head.load(std::memory_order_relaxed);
+  while (1) {
+    lv_command_t *cmd = &lv_commands[pos % LVGL_COMMAND_QUEUE];
+    int32_t lag = (int32_t)(cmd->seq.load(std::memory_order_acquire) - pos);
+    if (!lag) { // Free; take it unless another producer got there first
+      if (lv_command_head.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+        return cmd;
+      } // else pos is now the head's latest value
+    } else if (lag < 0) {
+      return NULL; // Still holds a command from the lap before: full
+    } else {
+      pos = lv_command_head.load(std::memory_order_relaxed); // Claimed
+    }
+  }
+}
 
-#if defined(ARDUINO_ARCH_SAMD) // --------------------------------------
+// Hands a filled slot to the GUI task
+static void lv_command_done(lv_command_t *cmd) {
+  uint32_t pos = cmd->seq.load(std::memory_order_relaxed);
+  cmd->seq.store(pos + 1, std::memory_order_release);
+}
 
-// Because of the way timer/counters are paired, and because parallel TFT
-// uses timer 2 for write strobe, this needs to use timer 4 or above...
-#define TIMER_NUM 4
-#define TIMER_ISR TC4_Handler
+// Applies one command, if its object still exists
+static void lv_command_apply(lv_command_t *cmd) {
+  lv_obj_t *obj = cmd->obj;
+  if (!lv_obj_is_valid(obj)) {
+    return; // Deleted since it was posted
+  }
+  switch (cmd->type) {
+  case LV_CMD_TEXT:
+#if LV_USE_TEXTAREA
+    if (lv_obj_has_class(obj, &lv_textarea_class)) {
+      lv_textarea_set_text(obj, cmd->text);
+      break;
+    }
+#endif
+#if LV_USE_LABEL
+    if (lv_obj_has_class(obj, &lv_label_class)) {
+      lv_label_set_text(obj, cmd->text);
+    }
+#endif
+    break;
+  case LV_CMD_VALUE:
+#if LV_USE_BAR
+    if (lv_obj_has_class(obj, &lv_bar_class)) { // Sliders too
+      lv_bar_set_value(obj, cmd->value, LV_ANIM_OFF);
+      break;
+    }
+#endif
+#if LV_USE_ARC
+    if (lv_obj_has_class(obj, &lv_arc_class)) {
+      lv_arc_set_value(obj, cmd->value);
+    }
+#endif
+    break;
+  case LV_CMD_INVALIDATE:
+    lv_obj_invalidate(obj);
+    break;
+  }
+}
 
-// Interrupt service routine for zerotimer object
-void TIMER_ISR(void) { Adafruit_ZeroTimer::timerHandler(TIMER_NUM); }
+// Applies the commands waiting, at most one queue's worth so producers
+// can't hold up the next frame. Returns true if more are waiting.
+static bool lv_commands_apply(void) {
+  for (uint32_t n = 0; n < LVGL_COMMAND_QUEUE; n++) {
+    lv_command_t *cmd = &lv_commands[lv_command_tail % LVGL_COMMAND_QUEUE];
+    if (cmd->seq.load(std::memory_order_acquire) != lv_command_tail + 1) {
+      return false; // Empty, or the next one is still being filled
+    }
+    lv_command_apply(cmd);
+    // Free the slot for the producer that's a lap ahead
+    cmd->seq.store(lv_command_tail + LVGL_COMMAND_QUEUE,
+                   std::memory_order_release);
+    lv_command_tail++;
+  }
+  uint32_t next = lv_command_tail % LVGL_COMMAND_QUEUE;
+  return lv_commands[next].seq.load(std::memory_order_acquire) ==
+         lv_command_tail + 1;
+}
 
-// Timer compare match 0 callback -- invokes LittlevGL timekeeper.
-static void timerCallback0(void) { lv_tick_inc(lv_tick_interval_ms); }
+#if !defined(ESP32)
+// Without a GUI task, posted commands are applied from an LvGL timer, i.e.
+// within the sketch's lv_task_handler() calls
+static void lv_command_timer(lv_timer_t *timer) { lv_commands_apply(); }
+#endif
+#endif // LVGL_COMMAND_QUEUE
 
-#elif defined(ESP32) // ------------------------------------------------
+#if defined(ESP32) // --------------------------------------------------
 // The following preprocessor code segments are based around the LVGL example
 // project for ESP32:
 // https://github.com/lvgl/lv_port_esp32/blob/master/main/main.c
@@ -31,25 +142,113 @@ static void timerCallback0(void) { lv_tick_inc(lv_tick_interval_ms); }
 static SemaphoreHandle_t xGuiSemaphore = NULL;
 static TaskHandle_t g_lvgl_task_handle;
 
-// Periodic timer handler
-// NOTE: We use the IRAM_ATTR here to place this code into RAM rather than flash
-static void IRAM_ATTR lv_tick_handler(void *arg) {
-  (void)arg;
-  lv_tick_inc(lv_tick_interval_ms);
+// Longest the GUI task sleeps with no LittlevGL timer due. Changes made
+// through lvgl_release() or that invalidate the screen wake it sooner; this
+// only bounds the delay for a sketch that creates timers without the lock.
+#define LV_IDLE_MAX_MS 1000
+
+static void touchscreen_read(lv_indev_t *indev_drv, lv_indev_data_t *data);
+
+// Whether a change made by task 'from' wakes the GUI task ahead of its
+// next deadline. Changes from other tasks do: lvgl_release(), invalidating
+// without the lock (see lv_invalidate_callback()) and touch samples queued
+// (see touch_task_poll()). The GUI task's own changes don't, since its
+// lv_timer_handler() sees them, nor does anything before it exists.
+static bool lv_wake_needed(TaskHandle_t from) {
+  return g_lvgl_task_handle && (from != g_lvgl_task_handle);
 }
 
-// Pinned task used to update the GUI, called by FreeRTOS
-static void gui_task(void *args) {
-  while (1) {
-    // Delay 1 tick (follows lv_tick_interval_ms)
-    vTaskDelay(pdMS_TO_TICKS(lv_tick_interval_ms));
+// Wakes the GUI task, if lv_wake_needed() for the calling task
+static void lv_wake(void) {
+  if (lv_wake_needed(xTaskGetCurrentTaskHandle())) {
+    xTaskNotifyGive(g_lvgl_task_handle);
+  }
+}
+
+// GUI task defaults, unless overridden through LvGLConfig
+#define LV_GUI_PRIORITY 5
+#define LV_GUI_STACK_BYTES (1024 * 8)
+// Touch sampling task defaults, see touch_task_fn()
+#define LV_TOUCH_PRIORITY 5
+#define LV_TOUCH_STACK_BYTES (1024 * 4)
+
+// A run starting more than this after LittlevGL's deadline counts as missed.
+// Sleeps are whole RTOS ticks, so up to a tick late is on time.
+#define LV_GUI_SLACK_MS (portTICK_PERIOD_MS + 1)
+
+// GUI task counters, see getTaskStats(). Written only by the GUI task,
+// while it holds the lock.
+static LvGLTaskStats lv_task_stats;
+
+// What lv_timer_handler() last returned, and millis() at which LittlevGL
+// wanted the next run. GUI task only.
+static uint32_t lv_gui_wait = LV_NO_TIMER_READY;
+static uint32_t lv_gui_due_ms;
+
+// Adds one GUI task run to stats, from micros() when it asked for the
+// lock, got it and was done with lv_timer_handler(), and how many ms after
+// LittlevGL's deadline it started (0 or less if on time, or woken early)
+static void lv_task_account(LvGLTaskStats *stats, uint32_t ask_us,
+                            uint32_t got_us, uint32_t done_us,
+                            int32_t late_ms) {
+  uint32_t wait_us = got_us - ask_us, run_us = done_us - got_us;
+  stats->runs++;
+  stats->lock_wait_us += wait_us;
+  stats->lock_wait_max_us = max(stats->lock_wait_max_us, wait_us);
+  stats->handler_us += run_us;
+  stats->handler_max_us = max(stats->handler_max_us, run_us);
+  stats->missed += (late_ms > (int32_t)LV_GUI_SLACK_MS);
+}
+
+// RTOS ticks for the GUI task to sleep after a run, unless lv_wake()
+// comes first: until LittlevGL's next timer is due (wait, from
+// lv_timer_handler()), but no longer than LV_IDLE_MAX_MS. Always at least
+// one tick, even with posted commands still waiting (more), so a timer
+// that's already due or a flood of commands can't starve lower priority
+// tasks.
+static TickType_t lv_gui_sleep_ticks(uint32_t wait, bool more) {
+  TickType_t ticks =
+      more ? 0 : pdMS_TO_TICKS(min(wait, (uint32_t)LV_IDLE_MAX_MS));
+  return max(ticks, (TickType_t)1);
+}
 
-    // Try to take the semaphore, call lvgl task handler function on success
-    if (pdTRUE == xSemaphoreTake(xGuiSemaphore, portMAX_DELAY)) {
-      lv_task_handler();
-      xSemaphoreGive(xGuiSemaphore);
+// One run of the GUI task: posted commands, sampled touch and whatever
+// LittlevGL has due. Returns the ticks to sleep until the next.
+static TickType_t lv_gui_run(void) {
+  uint32_t ask_us = micros();
+  xSemaphoreTake(xGuiSemaphore, portMAX_DELAY);
+  uint32_t got_us = micros();
+  int32_t late_ms = (lv_gui_wait == LV_NO_TIMER_READY)
+                        ? 0
+                        : (int32_t)(millis() - lv_gui_due_ms);
+#if LVGL_COMMAND_QUEUE
+  bool more = lv_commands_apply();
+#else
+  bool more = false;
+#endif
+  // Sampled touchscreens are read on demand (LV_INDEV_MODE_EVENT), not
+  // from an input timer; see touch_task_fn()
+  for (lv_indev_t *indev = lv_indev_get_next(NULL); indev;
+       indev = lv_indev_get_next(indev)) {
+    if ((lv_indev_get_mode(indev) == LV_INDEV_MODE_EVENT) &&
+        (lv_indev_get_read_cb(indev) == touchscreen_read)) {
+      lv_indev_read(indev);
     }
   }
+  lv_gui_wait = lv_timer_handler(); // LV_NO_TIMER_READY if nothing's due
+  lv_gui_due_ms = millis() + lv_gui_wait;
+  lv_task_account(&lv_task_stats, ask_us, got_us, micros(), late_ms);
+  xSemaphoreGive(xGuiSemaphore);
+  return lv_gui_sleep_ticks(lv_gui_wait, more);
+}
+
+// Pinned task used to update the GUI, called by FreeRTOS. Rather than
+// waking on a fixed tick, it sleeps until LittlevGL's next timer is due or
+// until lv_wake(), so an idle UI costs (almost) no wakeups.
+static void gui_task(void *args) {
+  while (1) {
+    ulTaskNotifyTake(pdTRUE, lv_gui_run());
+  }
 }
 
 /**
@@ -64,38 +263,23 @@ void Adafruit_LvGL_Glue::lvgl_acquire(void) {
 }
 
 /**
- * @brief Unlocks LVGL resource to prevent memory corrupton on ESP32.
+ * @brief Unlocks LVGL resource to prevent memory corrupton on ESP32, and
+ * wakes the GUI task to act on any changes made meanwhile.
  * NOTE: This function MUST be called in application code AFTER lvgl_acquire()
  */
 void Adafruit_LvGL_Glue::lvgl_release(void) {
   TaskHandle_t task = xTaskGetCurrentTaskHandle();
   if (g_lvgl_task_handle != task) {
     xSemaphoreGive(xGuiSemaphore);
+    lv_wake();
   }
 }
 
-#elif defined(NRF52_SERIES) // -----------------------------------------
-
-#define TIMER_ID NRF_TIMER4
-#define TIMER_IRQN TIMER4_IRQn
-#define TIMER_ISR TIMER4_IRQHandler
-#define TIMER_FREQ 16000000
-
-extern "C" {
-// Timer interrupt service routine
-void TIMER_ISR(void) {
-  if (TIMER_ID->EVENTS_COMPARE[0]) {
-    TIMER_ID->EVENTS_COMPARE[0] = 0;
-  }
-  lv_tick_inc(lv_tick_interval_ms);
-}
-}
-
 #endif
 
 // TOUCHSCREEN STUFF -------------------------------------------------------
 
-// STMPE610 calibration for raw touch data
+// Built-in STMPE610 calibration: range of raw readings across the panel
 #define TS_MINX 100
 #define TS_MAXX 3800
 #define TS_MINY 100
@@ -107,108 +291,464 @@ void TIMER_ISR(void) {
 #define ADC_YMIN 240
 #define ADC_YMAX 840
 
-static void touchscreen_read( lv_indev_t *indev_drv,  lv_indev_data_t *data) {
-  static lv_coord_t last_x = 0, last_y = 0;
-  static uint8_t release_count = 0;
+// Sets one row of a Q16 calibration matrix to map raw readings on one
+// axis (0 = raw X, 1 = raw Y) linearly from 'from' onto pixel 0 and from
+// 'to' onto pixel 'last'
+static void touch_axis(int32_t *row, uint8_t axis, int32_t from, int32_t to,
+                       int32_t last) {
+  row[0] = row[1] = 0;
+  row[axis] = ((int64_t)last << 16) / (to - from);
+  row[2] = -row[axis] * from;
+}
 
-  // Get pointer to glue object from indev user data
-  Adafruit_LvGL_Glue *glue = static_cast<Adafruit_LvGL_Glue*>(lv_indev_get_user_data(indev_drv));
-  Adafruit_SPITFT *disp = glue->display;
+// Native (GFX rotation 0) size of the glue's display
+static void touch_panel_size(Adafruit_LvGL_Glue *glue, int32_t *w,
+                             int32_t *h) {
+  bool turned = glue->display->getRotation() & 1;
+  *w = turned ? glue->display->height() : glue->display->width();
+  *h = turned ? glue->display->width() : glue->display->height();
+}
+
+// The built-in calibration for the glue's touchscreen, from the raw ranges
+// above. The STMPE610's X axis is flipped on 480x320 panels (the big TFT
+// FeatherWing).
+static void touch_default_calibration(Adafruit_LvGL_Glue *glue,
+                                      LvGLTouchCalibration *cal) {
+  int32_t w, h;
+  touch_panel_size(glue, &w, &h);
+  cal->magic = LVGL_TOUCH_CAL_MAGIC;
+  cal->width = w;
+  cal->height = h;
+  if (glue->is_adc_touch) {
+    touch_axis(&cal->matrix[0], 0, ADC_XMIN, ADC_XMAX, w - 1);
+    touch_axis(&cal->matrix[3], 1, ADC_YMAX, ADC_YMIN, h - 1);
+  } else {
+    if ((w == 480) || (h == 480)) {
+      touch_axis(&cal->matrix[0], 0, TS_MINX, TS_MAXX, w - 1);
+    } else {
+      touch_axis(&cal->matrix[0], 0, TS_MAXX, TS_MINX, w - 1);
+    }
+    touch_axis(&cal->matrix[3], 1, TS_MINY, TS_MAXY, h - 1);
+  }
+}
+
+// Turns a Q16 calibration matrix 'turns' quarter turns clockwise, the same
+// way GFX setRotation() turns coordinates: from a w x h space to the
+// coordinates of the turned one.
+static void touch_turn(int32_t *m, uint8_t turns, int32_t w, int32_t h) {
+  int32_t x[3] = {m[0], m[1], m[2]}, y[3] = {m[3], m[4], m[5]};
+  for (uint8_t i = 0; i < 3; i++) {
+    int32_t one = (i == 2) ? 65536 : 0; // Constant term gets the offset
+    switch (turns & 3) {
+    case 1:
+      m[i] = y[i];
+      m[i + 3] = (w - 1) * one - x[i];
+      break;
+    case 2:
+      m[i] = (w - 1) * one - x[i];
+      m[i + 3] = (h - 1) * one - y[i];
+      break;
+    case 3:
+      m[i] = (h - 1) * one - y[i];
+      m[i + 3] = x[i];
+      break;
+    }
+  }
+}
+
+// Works out touch_matrix, taking raw readings straight to the coordinates
+// LvGL works in: the calibration (raw to panel pixels), turned for the
+// display's GFX rotation and then for the glue's own rotation -- the
+// inverse of what lv_flush_area() does to pixels. Done once per rotation,
+// so each reading costs just a few multiply-adds.
+static void touch_update_matrix(Adafruit_LvGL_Glue *glue) {
+  int32_t w, h;
+  touch_panel_size(glue, &w, &h);
+  uint8_t turns = glue->display->getRotation();
+  memcpy(glue->touch_matrix, glue->touch_cal.matrix,
+         sizeof(glue->touch_matrix));
+  touch_turn(glue->touch_matrix, turns, w, h);
+  touch_turn(glue->touch_matrix, glue->rotation, glue->display->width(),
+             glue->display->height());
+  glue->touch_matrix_rotation = turns;
+}
 
+// Maps a raw reading to LvGL coordinates
+static void touch_map(Adafruit_LvGL_Glue *glue, int32_t rx, int32_t ry,
+                      lv_coord_t *x, lv_coord_t *y) {
+  if (glue->display->getRotation() != glue->touch_matrix_rotation) {
+    touch_update_matrix(glue); // Display was turned since last time
+  }
+  const int32_t *m = glue->touch_matrix;
+  *x = (m[0] * rx + m[1] * ry + m[2] + 32768) >> 16;
+  *y = (m[3] * rx + m[4] * ry + m[5] + 32768) >> 16;
+}
+
+// True if cal is a profile for the glue's panel, small enough for
+// touch_map() to work in 32 bits with readings of up to 12 bits
+static bool touch_cal_valid(Adafruit_LvGL_Glue *glue,
+                            const LvGLTouchCalibration *cal) {
+  int32_t w, h;
+  touch_panel_size(glue, &w, &h);
+  if ((cal->magic != LVGL_TOUCH_CAL_MAGIC) || (cal->width != w) ||
+      (cal->height != h)) {
+    return false;
+  }
+  for (uint8_t i = 0; i < 6; i++) {
+    int32_t limit = (i % 3 == 2) ? (1L << 28) : (1L << 17);
+    if ((cal->matrix[i] >= limit) || (cal->matrix[i] <= -limit)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Puts a calibration profile in use, if it's valid for the glue's panel
+static bool touch_set_cal(Adafruit_LvGL_Glue *glue,
+                          const LvGLTouchCalibration *cal) {
+  if (!touch_cal_valid(glue, cal)) {
+    return false;
+  }
+  glue->touch_cal = *cal;
+  touch_update_matrix(glue);
+  return true;
+}
+
+// One raw reading, for calibration. Returns false if not touched.
+static bool touch_raw(Adafruit_LvGL_Glue *glue, int32_t *x, int32_t *y) {
   if (glue->is_adc_touch) {
     TouchScreen *touch = (TouchScreen *)glue->touchscreen;
     TSPoint p = touch->getPoint();
-    // Serial.printf("%d %d %d\r\n", p.x, p.y, p.z);
-    // Having an issue with spurious z=0 results from TouchScreen lib.
-    // Since touch is polled periodically, workaround is to watch for
-    // several successive z=0 results, and only then regard it as
-    // a release event (otherwise still touched).
-    if (p.z < touch->pressureThreshhold) { // A zero-ish value
-      release_count += (release_count < 255);
-      if (release_count >= 4) {
-        
-        data->state = LV_INDEV_STATE_REL; // Is REALLY RELEASED
-      } else {
-        data->state = LV_INDEV_STATE_PR; // Is STILL PRESSED
-      }
-    } else {
-      release_count = 0;               // Reset release counter
-      data->state = LV_INDEV_STATE_PR; // Is PRESSED
-      switch (glue->display->getRotation()) {
-      case 0:
-        last_x = map(p.x, ADC_XMIN, ADC_XMAX, 0, disp->width() - 1);
-        last_y = map(p.y, ADC_YMAX, ADC_YMIN, 0, disp->height() - 1);
-        break;
-      case 1:
-        last_x = map(p.y, ADC_YMAX, ADC_YMIN, 0, disp->width() - 1);
-        last_y = map(p.x, ADC_XMAX, ADC_XMIN, 0, disp->height() - 1);
-        break;
-      case 2:
-        last_x = map(p.x, ADC_XMAX, ADC_XMIN, 0, disp->width() - 1);
-        last_y = map(p.y, ADC_YMIN, ADC_YMAX, 0, disp->height() - 1);
-        break;
-      case 3:
-        last_x = map(p.y, ADC_YMIN, ADC_YMAX, 0, disp->width() - 1);
-        last_y = map(p.x, ADC_XMIN, ADC_XMAX, 0, disp->height() - 1);
-        break;
-      }
+    if (p.z < touch->pressureThreshhold) {
+      return false;
     }
-    data->point.x = last_x; // Last-pressed coordinates
-    data->point.y = last_y;
-    data->continue_reading = false; // No buffering of ADC touch data
-  } else {
-    uint8_t fifo; // Number of points in touchscreen FIFO
-    bool more = false;
-    Adafruit_STMPE610 *touch = (Adafruit_STMPE610 *)glue->touchscreen;
-    // Before accessing SPI touchscreen, wait on any in-progress
-    // DMA screen transfer to finish (shared bus).
-    disp->dmaWait();
-    disp->endWrite();
-    if ((fifo = touch->bufferSize())) { // 1 or more points await
-      data->state = LV_INDEV_STATE_PR;  // Is PRESSED
-      TS_Point p = touch->getPoint();
-      // Serial.printf("%d %d %d\r\n", p.x, p.y, p.z);
-      // On big TFT FeatherWing, raw X axis is flipped??
-      if ((glue->display->width() == 480) || (glue->display->height() == 480)) {
-        p.x = (TS_MINX + TS_MAXX) - p.x;
-      }
-      switch (glue->display->getRotation()) {
-      case 0:
-        last_x = map(p.x, TS_MAXX, TS_MINX, 0, disp->width() - 1);
-        last_y = map(p.y, TS_MINY, TS_MAXY, 0, disp->height() - 1);
-        break;
-      case 1:
-        last_x = map(p.y, TS_MINY, TS_MAXY, 0, disp->width() - 1);
-        last_y = map(p.x, TS_MINX, TS_MAXX, 0, disp->height() - 1);
-        break;
-      case 2:
-        last_x = map(p.x, TS_MINX, TS_MAXX, 0, disp->width() - 1);
-        last_y = map(p.y, TS_MAXY, TS_MINY, 0, disp->height() - 1);
-        break;
-      case 3:
-        last_x = map(p.y, TS_MAXY, TS_MINY, 0, disp->width() - 1);
-        last_y = map(p.x, TS_MAXX, TS_MINX, 0, disp->height() - 1);
-        break;
+    *x = p.x;
+    *y = p.y;
+    return true;
+  }
+  Adafruit_STMPE610 *touch = (Adafruit_STMPE610 *)glue->touchscreen;
+  if (!touch->bufferSize()) {
+    return false;
+  }
+  TS_Point p = touch->getPoint();
+  *x = p.x;
+  *y = p.y;
+  return true;
+}
+
+// Raw readings averaged per calibration touch, and no-touch readings in a
+// row that make a release
+#define TOUCH_CAL_SAMPLES 16
+
+// Waits for a touch, averages its first few raw readings into raw[0] (X)
+// and raw[1] (Y), then waits for the release. False on timeout.
+static bool touch_raw_average(Adafruit_LvGL_Glue *glue, int32_t *raw,
+                              uint32_t timeout_ms) {
+  int32_t x, y, n = 0, idle = 0;
+  uint32_t start = millis();
+  raw[0] = raw[1] = 0;
+  while (idle < TOUCH_CAL_SAMPLES) {
+    if (millis() - start > timeout_ms) {
+      return false;
+    }
+    if (touch_raw(glue, &x, &y)) {
+      if (n < TOUCH_CAL_SAMPLES) {
+        raw[0] += x;
+        raw[1] += y;
+        n++;
       }
-      more = (fifo > 1); // true if more in FIFO, false if last point
+      idle = 0;
+    } else if (n == TOUCH_CAL_SAMPLES) {
+      idle++;
+    }
+    delay(2);
+  }
+  raw[0] /= n;
+  raw[1] /= n;
+  return true;
+}
+
+// Solves for the Q16 matrix taking three raw readings to three target
+// points. False if the readings are in a line, or too far apart from the
+// targets to make sense.
+static bool touch_solve(const int32_t raw[3][2], const int32_t target[3][2],
+                        int32_t *m) {
+  int64_t x0 = raw[0][0] - raw[2][0], y0 = raw[0][1] - raw[2][1];
+  int64_t x1 = raw[1][0] - raw[2][0], y1 = raw[1][1] - raw[2][1];
+  int64_t det = x0 * y1 - x1 * y0;
+  if (!det) {
+    return false;
+  }
+  for (uint8_t i = 0; i < 2; i++, m += 3) {
+    int64_t t0 = target[0][i] - target[2][i];
+    int64_t t1 = target[1][i] - target[2][i];
+    int64_t a = (t0 * y1 - t1 * y0) * 65536 / det;
+    int64_t b = (x0 * t1 - x1 * t0) * 65536 / det;
+    int64_t c = (int64_t)target[2][i] * 65536 - a * raw[2][0] - b * raw[2][1];
+    if ((a != (int32_t)a) || (b != (int32_t)b) || (c != (int32_t)c)) {
+      return false;
+    }
+    m[0] = a;
+    m[1] = b;
+    m[2] = c;
+  }
+  return true;
+}
+
+// Consecutive STMPE610 polls that may be put off while DMA uses the bus
+#define LV_TOUCH_MAX_DEFER 2
+
+// Default untouched readings in a row that make a release. The ADC
+// touchscreen library gives spurious z=0 results now and then, and nRF
+// doesn't always poll the STMPE610's FIFO size correctly, so a single
+// empty reading there isn't trusted either.
+#define ADC_RELEASE_COUNT 4
 #if defined(NRF52_SERIES)
-      // Not sure what's up here, but nRF doesn't seem to always poll
-      // the FIFO size correctly, causing false release events. If it
-      // looks like we've read the last point from the FIFO, pause
-      // briefly to allow any more FIFO events to pile up. This
-      // doesn't seem to be necessary on SAMD or ESP32. ???
-      if (!more) {
-        delay(50);
-      }
+#define STMPE_RELEASE_COUNT 2
+#else
+#define STMPE_RELEASE_COUNT 1
+#endif
+
+// Median of the first n values of v (n <= LVGL_TOUCH_MEDIAN_MAX), the
+// lower middle one if n is even
+static lv_coord_t touch_median(const lv_coord_t *v, uint8_t n) {
+  lv_coord_t sorted[LVGL_TOUCH_MEDIAN_MAX];
+  for (uint8_t i = 0; i < n; i++) { // Insertion sort, n is tiny
+    uint8_t j = i;
+    for (; j && (sorted[j - 1] > v[i]); j--) {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = v[i];
+  }
+  return sorted[(n - 1) / 2];
+}
+
+// Runs one reading through the touch filter into the glue's touch state:
+// press/release hysteresis, then median and exponential smoothing of the
+// mapped point, then the velocity estimate. Readings that come in a batch
+// (from the STMPE610's FIFO) share a millis() value; velocity is updated
+// over the time between batches.
+static void touch_filter_add(Adafruit_LvGL_Glue *glue, bool touched,
+                             int32_t rx, int32_t ry) {
+  LvGLTouchFilter *f = &glue->touch_filter;
+  if (!touched) {
+    f->touched = 0;
+    glue->release_count += (glue->release_count < 255);
+    if (glue->release_count >= f->release_count) {
+      glue->touch_pressed = false; // Is RELEASED
+    }
+    return;
+  }
+  glue->release_count = 0;
+  if (f->touched < f->press_count) {
+    f->touched++;
+  }
+  if (!glue->touch_pressed && (f->touched < f->press_count)) {
+    return; // Not a press yet
+  }
+
+  lv_coord_t x, y;
+  uint32_t now = millis();
+  touch_map(glue, rx, ry, &x, &y);
+  if (!glue->touch_pressed) {
+    // New touch: start the filters afresh from this point
+    glue->touch_pressed = true; // Is PRESSED
+    f->hist_len = f->hist_next = 0;
+    f->ema_x = (int32_t)x << 8;
+    f->ema_y = (int32_t)y << 8;
+    f->ref_x = x;
+    f->ref_y = y;
+    f->ref_ms = now;
+    f->vx = f->vy = 0;
+  }
+  if (f->median > 1) {
+    f->hist_x[f->hist_next] = x;
+    f->hist_y[f->hist_next] = y;
+    f->hist_next = (f->hist_next + 1) % f->median;
+    if (f->hist_len < f->median) {
+      f->hist_len++;
+    }
+    x = touch_median(f->hist_x, f->hist_len);
+    y = touch_median(f->hist_y, f->hist_len);
+  }
+  if (f->smooth) {
+    f->ema_x += (((int32_t)x << 8) - f->ema_x) * (256 - f->smooth) >> 8;
+    f->ema_y += (((int32_t)y << 8) - f->ema_y) * (256 - f->smooth) >> 8;
+    x = (f->ema_x + 128) >> 8;
+    y = (f->ema_y + 128) >> 8;
+  }
+  glue->touch_x = x;
+  glue->touch_y = y;
+
+  uint32_t dt = now - f->ref_ms;
+  if (dt) {
+    // Average the latest stretch's speed into the estimate
+    f->vx = (f->vx + (x - f->ref_x) * 1000 / (int32_t)dt) / 2;
+    f->vy = (f->vy + (y - f->ref_y) * 1000 / (int32_t)dt) / 2;
+    f->ref_x = x;
+    f->ref_y = y;
+    f->ref_ms = now;
+  }
+}
+
+// Reads the next point, if any, from the STMPE610's FIFO into the glue's
+// touch state. The caller must have claimed the bus.
+static void stmpe_read(Adafruit_LvGL_Glue *glue) {
+  uint8_t fifo; // Number of points in touchscreen FIFO
+  Adafruit_STMPE610 *touch = (Adafruit_STMPE610 *)glue->touchscreen;
+  glue->touch_pending = false;
+  glue->touch_deferred = 0;
+  glue->touch_more = false;
+  if ((fifo = touch->bufferSize())) { // 1 or more points await
+    TS_Point p = touch->getPoint();
+    // Serial.printf("%d %d %d\r\n", p.x, p.y, p.z);
+    touch_filter_add(glue, true, p.x, p.y);
+    glue->touch_more = (fifo > 1); // true if more in FIFO, false if last point
+  } else {                         // FIFO empty
+    touch_filter_add(glue, false, 0, 0);
+  }
+}
+
+// Reads the ADC touchscreen into the glue's touch state
+static void adc_read(Adafruit_LvGL_Glue *glue) {
+  TouchScreen *touch = (TouchScreen *)glue->touchscreen;
+  TSPoint p = touch->getPoint();
+  // Serial.printf("%d %d %d\r\n", p.x, p.y, p.z);
+  touch_filter_add(glue, p.z >= touch->pressureThreshhold, p.x, p.y);
+}
+
+// Queues the glue's touch state in its ring for LvGL. Touches are always
+// queued, a release only once (again later if the ring was full). This is
+// the only writer of touch_head, and only reads touch_tail, so it needs no
+// lock against touchscreen_read(). Returns false if the ring is full.
+static bool touch_push(Adafruit_LvGL_Glue *glue) {
+  if (!glue->touch_pressed && !glue->touch_queued_pressed) {
+    return true; // Release already queued
+  }
+  uint8_t head = glue->touch_head.load(std::memory_order_relaxed);
+  if ((uint8_t)(head - glue->touch_tail.load(std::memory_order_acquire)) >=
+      LVGL_TOUCH_RING) {
+    glue->touch_dropped++;
+    return false;
+  }
+  LvGLTouchSample *sample = &glue->touch_ring[head % LVGL_TOUCH_RING];
+  sample->x = glue->touch_x;
+  sample->y = glue->touch_y;
+  sample->pressed = glue->touch_pressed;
+  glue->touch_head.store(head + 1, std::memory_order_release);
+  glue->touch_queued_pressed = glue->touch_pressed;
+  return true;
+}
+
+// Samples the touchscreen into the ring: one ADC reading, or every point
+// waiting in the STMPE610's FIFO (as far as there's room)
+static void touch_poll(Adafruit_LvGL_Glue *glue) {
+  if (glue->is_adc_touch) {
+    adc_read(glue);
+    touch_push(glue);
+  } else {
+    glue->claimBus(LVGL_BUS_TOUCH);
+    do {
+      stmpe_read(glue);
+    } while (touch_push(glue) && glue->touch_more);
+  }
+}
+
+#if defined(ESP32)
+// The touch task samples an ADC touchscreen without the LvGL lock, so
+// whatever reads it or changes its calibration under that lock also takes
+// touch_lock, to keep the task out meanwhile
+static void touch_hold(Adafruit_LvGL_Glue *glue) {
+  if (glue->touch_lock) {
+    xSemaphoreTake(glue->touch_lock, portMAX_DELAY);
+  }
+}
+
+static void touch_unhold(Adafruit_LvGL_Glue *glue) {
+  if (glue->touch_lock) {
+    xSemaphoreGive(glue->touch_lock);
+  }
+}
+
+// One poll of the touch task. The GUI task is only woken when a sample was
+// queued, so an untouched screen doesn't wake it every poll.
+static void touch_task_poll(Adafruit_LvGL_Glue *glue) {
+  uint8_t head = glue->touch_head.load(std::memory_order_relaxed);
+  if (glue->is_adc_touch) {
+    // Analog pins only: the GUI task can go on rendering meanwhile
+    touch_hold(glue);
+    touch_poll(glue);
+    touch_unhold(glue);
+  } else {
+    // The STMPE610's bus belongs to the GUI task's flushes. Not
+    // lvgl_release(), which would wake the GUI task every time.
+    xSemaphoreTake(xGuiSemaphore, portMAX_DELAY);
+    touch_poll(glue);
+    xSemaphoreGive(xGuiSemaphore);
+  }
+  if (glue->touch_head.load(std::memory_order_relaxed) != head) {
+    lv_wake();
+  }
+}
+
+// Task sampling one glue's touchscreen, see LvGLConfig::touch_poll_ms
+static void touch_task_fn(void *arg) {
+  Adafruit_LvGL_Glue *glue = (Adafruit_LvGL_Glue *)arg;
+  while (1) {
+    vTaskDelay(pdMS_TO_TICKS(glue->touch_poll_ms));
+    touch_task_poll(glue);
+  }
+}
 #endif
-    } else {                            // FIFO empty
-      data->state = LV_INDEV_STATE_REL; // Is RELEASED
+
+static void touchscreen_read( lv_indev_t *indev_drv,  lv_indev_data_t *data) {
+  // Get pointer to glue object from indev user data
+  Adafruit_LvGL_Glue *glue = static_cast<Adafruit_LvGL_Glue*>(lv_indev_get_user_data(indev_drv));
+
+  if (glue->touch_poll_ms) {
+    // Sampled elsewhere; take the next sample from the ring, if any. This
+    // is the only writer of touch_tail.
+    LvGLTouchSample *sample = &glue->touch_sample;
+    uint8_t tail = glue->touch_tail.load(std::memory_order_relaxed);
+    uint8_t head = glue->touch_head.load(std::memory_order_acquire);
+    if (tail != head) {
+      *sample = glue->touch_ring[tail % LVGL_TOUCH_RING];
+      glue->touch_tail.store(++tail, std::memory_order_release);
     }
+    data->state = sample->pressed ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+    data->point.x = sample->x;
+    data->point.y = sample->y;
+    data->continue_reading = (tail != head);
+    return;
+  }
 
-    data->point.x = last_x; // Last-pressed coordinates
-    data->point.y = last_y;
-    data->continue_reading = more;
+  if (glue->is_adc_touch) {
+    adc_read(glue);
+    data->continue_reading = false; // No buffering of ADC touch data
+  } else {
+    // The touch controller shares the display's SPI bus. Rather than stall
+    // a DMA transfer to the display, put the read off; finishFlush() does
+    // it as soon as the transfer ends. Only a couple of polls in a row are
+    // put off, so touch can't starve behind a long redraw.
+    if (glue->touch_fresh) {
+      glue->touch_fresh = false; // Already read, at the end of a transfer
+    } else if (glue->dma_busy && glue->display->dmaBusy() &&
+               (glue->touch_deferred < LV_TOUCH_MAX_DEFER)) {
+      if (!glue->touch_deferred++) {
+        glue->touch_request_us = micros();
+      }
+      glue->touch_pending = true;
+      glue->bus_stats.deferred++;
+    } else {
+      glue->touch_pending = false; // Reading it here, not in finishFlush()
+      glue->claimBus(LVGL_BUS_TOUCH);
+      stmpe_read(glue);
+    }
+    data->continue_reading = glue->touch_more;
   }
+  data->state = glue->touch_pressed ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+  data->point.x = glue->touch_x; // Last-pressed coordinates
+  data->point.y = glue->touch_y;
 }
 
 // OTHER LITTLEVGL VITALS --------------------------------------------------
@@ -221,7 +761,8 @@ static void touchscreen_read( lv_indev_t *indev_drv,  lv_indev_data_t *data) {
 //  #pragma message("Set LV_COLOR_16_SWAP to 0 for best display performance")
 //#endif
 
-// Actual RAM usage will be 2X these figures, since using 2 DMA buffers...
+// Default draw buffer height, unless overridden through LvGLConfig. Actual
+// RAM usage will be 2X these figures when using 2 DMA buffers...
 #ifdef _SAMD21_
 #define LV_BUFFER_ROWS 4 // Don't hog all the RAM on SAMD21
 #else
@@ -235,6 +776,246 @@ static uint32_t lv_tick_callback(void)
 }
 
 
+// Counts a duration in a histogram of LVGL_FLUSH_HIST_BUCKETS log2 buckets
+static void lv_hist_add(uint32_t *hist, uint32_t us) {
+  uint8_t bucket = 0;
+  while ((bucket < LVGL_FLUSH_HIST_BUCKETS - 1) && (us >> bucket)) {
+    bucket++;
+  }
+  hist[bucket]++;
+}
+
+// Adds the flush started at stats->start_us to the latency figures, once
+// its last pixel has left the buffer.
+static void lv_flush_done(LvGLFlushStats *stats) {
+  uint32_t us = micros() - stats->start_us;
+  lv_hist_add(stats->latency_hist, us);
+  stats->flush_us += us;
+}
+
+// Points the display's address window at columns x1-x2, from row y1 on,
+// opening the SPI transaction first if needed. Areas of one refresh share
+// a single transaction, and an area that starts on the row right below
+// the previous one, with the same columns, just keeps writing into the
+// open window -- this is how LvGL hands over a tall area one buffer-full
+// of rows at a time.
+static void lv_flush_window(Adafruit_LvGL_Glue *glue, int32_t x1, int32_t x2,
+                            int32_t y1, int32_t y2) {
+  Adafruit_SPITFT *display = glue->display;
+  LvGLFlushStats *stats = &glue->flush_stats;
+  lv_area_t *window = &glue->flush_window;
+  bool continued = false;
+  if (!glue->in_transaction) {
+    display->startWrite();
+    glue->in_transaction = true;
+    stats->transactions++;
+  } else {
+    continued = (x1 == window->x1) && (x2 == window->x2) && (y1 == window->y1);
+  }
+  if (continued) {
+    stats->windows_saved++;
+  } else {
+    // The previous area (e.g. an earlier frame-diff run of this flush) may
+    // still be going out by DMA, into the window about to be replaced.
+    // Open the new one down to the bottom of the screen so a following
+    // area can continue it.
+    display->dmaWait();
+    display->setAddrWindow(x1, y1, x2 - x1 + 1, display->height() - y1);
+    stats->addr_windows++;
+  }
+  window->x1 = x1;
+  window->x2 = x2;
+  window->y1 = y2 + 1;
+}
+
+// Sends a block of pixels that sits in a buffer 'stride' pixels wide.
+// With DMA, the last (or only) transfer is still running on return. Each
+// write waits for the one before: GFX sends short writes by PIO, which
+// mustn't start while a transfer runs, and not every port waits itself.
+// Outside of direct mode, LvGL redraws the buffer before its next use, so
+// pixels are byte-swapped for the display in place here. GFX can then DMA
+// straight out of the buffer, rather than swapping through a bounce
+// buffer (SAMD) or swapping and un-swapping the whole buffer (nRF52).
+static void lv_flush_pixels(Adafruit_LvGL_Glue *glue, uint16_t *pixels,
+                            uint32_t width, uint32_t height, uint32_t stride) {
+  Adafruit_SPITFT *display = glue->display;
+  bool swap = !glue->direct_mode;
+  glue->flush_stats.pixels += width * height;
+  glue->flush_stats.bytes += width * height * sizeof(uint16_t);
+  if (stride != width) {
+    // Rows aren't contiguous, send all but the last one row by row
+    for (; height > 1; height--, pixels += stride) {
+      if (swap) {
+        Adafruit_LvGL_Glue::swapPixels(pixels, pixels, width);
+      }
+      display->dmaWait(); // Swapped while the previous row went out
+      display->writePixels(pixels, width, false, swap);
+    }
+  }
+  if (swap) {
+    Adafruit_LvGL_Glue::swapPixels(pixels, pixels, width * height);
+  }
+  display->dmaWait();
+  display->writePixels(pixels, width * height, false, swap);
+}
+
+// Pixels are rotated in square blocks this many pixels wide, so that the
+// rows being read and the columns being written both stay in cache
+#define LV_ROTATE_BLOCK 16
+
+// Copies a width x height block of pixels (in a buffer 'stride' pixels
+// wide) to dest, turned 'rotation' quarter turns clockwise. dest is left
+// contiguous, height pixels wide for rotations 1 and 3.
+static void lv_rotate_pixels(uint16_t *dest, const uint16_t *src,
+                             uint32_t width, uint32_t height, uint32_t stride,
+                             uint8_t rotation) {
+  if (rotation == 2) {
+    // Half turn: each row goes, reversed, to the mirrored row
+    uint16_t *d = dest + width * height;
+    for (; height; height--, src += stride) {
+      for (uint32_t x = 0; x < width; x++) {
+        *--d = src[x];
+      }
+    }
+    return;
+  }
+  // Quarter turns: source rows become destination columns
+  for (uint32_t yb = 0; yb < height; yb += LV_ROTATE_BLOCK) {
+    uint32_t yend = min(yb + LV_ROTATE_BLOCK, height);
+    for (uint32_t xb = 0; xb < width; xb += LV_ROTATE_BLOCK) {
+      uint32_t xend = min(xb + LV_ROTATE_BLOCK, width);
+      for (uint32_t x = xb; x < xend; x++) {
+        const uint16_t *s = src + yb * stride + x;
+        if (rotation == 1) {
+          uint16_t *d = dest + x * height + (height - 1 - yb);
+          for (uint32_t y = yb; y < yend; y++, s += stride) {
+            *d-- = *s;
+          }
+        } else {
+          uint16_t *d = dest + (width - 1 - x) * height + yb;
+          for (uint32_t y = yb; y < yend; y++, s += stride) {
+            *d++ = *s;
+          }
+        }
+      }
+    }
+  }
+}
+
+// Sends the pixels for LvGL's area x1-x2, y1-y2 (in a buffer 'stride'
+// pixels wide). With glue rotation, the pixels are first turned into the
+// scratch buffer and the area mapped to display coordinates.
+static void lv_flush_area(Adafruit_LvGL_Glue *glue, int32_t x1, int32_t x2,
+                          int32_t y1, int32_t y2, uint16_t *pixels,
+                          uint32_t stride) {
+  uint32_t width = x2 - x1 + 1;
+  uint32_t height = y2 - y1 + 1;
+  if (glue->rotation) {
+    Adafruit_SPITFT *display = glue->display;
+    int32_t nw = display->width(), nh = display->height();
+    int32_t nx1, nx2, ny1, ny2;
+    switch (glue->rotation) {
+    case 1:
+      nx1 = nw - 1 - y2, nx2 = nw - 1 - y1, ny1 = x1, ny2 = x2;
+      break;
+    case 2:
+      nx1 = nw - 1 - x2, nx2 = nw - 1 - x1;
+      ny1 = nh - 1 - y2, ny2 = nh - 1 - y1;
+      break;
+    default:
+      nx1 = y1, nx2 = y2, ny1 = nh - 1 - x2, ny2 = nh - 1 - x1;
+      break;
+    }
+    // A frame-diff flush sends several runs; the previous one may still
+    // be going out of the scratch buffer by DMA
+    display->dmaWait();
+    lv_rotate_pixels(glue->rotate_buf, pixels, width, height, stride,
+                     glue->rotation);
+    lv_flush_window(glue, nx1, nx2, ny1, ny2);
+    lv_flush_pixels(glue, glue->rotate_buf, nx2 - nx1 + 1, ny2 - ny1 + 1,
+                    nx2 - nx1 + 1);
+  } else {
+    lv_flush_window(glue, x1, x2, y1, y2);
+    lv_flush_pixels(glue, pixels, width, height, stride);
+  }
+}
+
+// Hash of one tile's pixels for frame-diff flush suppression. Never 0,
+// which marks a tile whose screen content is unknown.
+static uint32_t lv_tile_hash(const uint16_t *pixels, uint32_t width,
+                             uint32_t height, uint32_t stride) {
+  uint32_t hash = 2166136261UL; // FNV-1a
+  for (; height; height--, pixels += stride) {
+    for (uint32_t x = 0; x < width; x++) {
+      hash = (hash ^ pixels[x]) * 16777619UL;
+    }
+  }
+  return hash ? hash : 1;
+}
+
+// Sends columns x1-x2 of a band of rows that starts at screen row y
+static void lv_flush_run(Adafruit_LvGL_Glue *glue, const lv_area_t *area,
+                         uint16_t *row, int32_t x1, int32_t x2, int32_t y,
+                         int32_t height, uint32_t stride) {
+  lv_flush_area(glue, x1, x2, y, y + height - 1, row + (x1 - area->x1),
+                stride);
+}
+
+// Frame-diff flush: compare each tile of the area against the hash of what
+// the screen already shows and send only runs of changed tiles. Returns
+// false (and forgets the tiles' hashes) if the area doesn't line up with
+// the tile grid, in which case the caller sends it whole.
+static bool lv_flush_tiles(Adafruit_LvGL_Glue *glue, lv_display_t *disp,
+                           const lv_area_t *area, uint16_t *pixels,
+                           uint32_t stride) {
+  LvGLFlushStats *stats = &glue->flush_stats;
+  int32_t tile = glue->tile_size;
+  int32_t hor_res = lv_display_get_horizontal_resolution(disp);
+  int32_t ver_res = lv_display_get_vertical_resolution(disp);
+  uint32_t *hash = glue->tile_hash + (area->y1 / tile) * glue->tiles_x +
+                   area->x1 / tile;
+  uint32_t tiles_w = area->x2 / tile - area->x1 / tile + 1;
+
+  if ((area->x1 % tile) || (area->y1 % tile) ||
+      (((area->x2 + 1) % tile) && (area->x2 + 1 < hor_res)) ||
+      (((area->y2 + 1) % tile) && (area->y2 + 1 < ver_res))) {
+    for (int32_t y = area->y1 / tile; y <= area->y2 / tile; y++) {
+      memset(hash, 0, tiles_w * sizeof(uint32_t));
+      hash += glue->tiles_x;
+    }
+    return false;
+  }
+
+  for (int32_t y = area->y1; y <= area->y2; y += tile) {
+    int32_t height = min(tile, area->y2 - y + 1);
+    uint16_t *row = pixels + (y - area->y1) * stride;
+    int32_t run = -1; // Left edge of the current run of changed tiles
+    for (int32_t x = area->x1; x <= area->x2; x += tile) {
+      int32_t width = min(tile, area->x2 - x + 1);
+      uint32_t h = lv_tile_hash(row + (x - area->x1), width, height, stride);
+      uint32_t *known = &hash[(x - area->x1) / tile];
+      if (h != *known) {
+        *known = h;
+        stats->tiles_sent++;
+        if (run < 0) {
+          run = x;
+        }
+      } else {
+        stats->tiles_skipped++;
+        if (run >= 0) {
+          lv_flush_run(glue, area, row, run, x - 1, y, height, stride);
+          run = -1;
+        }
+      }
+    }
+    if (run >= 0) {
+      lv_flush_run(glue, area, row, run, area->x2, y, height, stride);
+    }
+    hash += glue->tiles_x;
+  }
+  return true;
+}
+
 // This is the flush function required for LittlevGL screen updates.
 // It receives a bounding rect and an array of pixel data (conveniently
 // already in 565 format, so the Earth was lucky there).
@@ -242,22 +1023,93 @@ static void lv_flush_callback(lv_display_t *display_drv, const lv_area_t *area,
   // Get pointer to glue object from indev user data
   Adafruit_LvGL_Glue *glue = static_cast<Adafruit_LvGL_Glue*>(lv_display_get_user_data(display_drv));
 
-  Adafruit_SPITFT *display = glue->display;
+  uint16_t *pixels = reinterpret_cast<uint16_t*>(data);
+  uint32_t stride = lv_area_get_width(area);
+  if (glue->direct_mode) {
+    // LvGL passes the whole frame; pick the area out of it
+    stride = lv_display_get_horizontal_resolution(display_drv);
+    pixels += area->y1 * stride + area->x1;
+  }
+  LvGLFlushStats *stats = &glue->flush_stats;
+  stats->start_us = micros();
+  stats->flushes++;
+  glue->flush_last = lv_display_flush_is_last(display_drv);
+
+  if (glue->capture && glue->capture_ok) {
+    // captureFrame() is running: hand the area over before it's swapped
+    // or rotated for the display
+    glue->capture_ok = glue->capture->write(area, pixels, stride);
+  }
 
-  if (!glue->first_frame) {
-    display->dmaWait();  // Wait for prior DMA transfer to complete
-    display->endWrite(); // End transaction from any prior call
-  } else {
-    glue->first_frame = false;
+  uint32_t sent = stats->pixels;
+  if (!glue->tile_hash || !lv_flush_tiles(glue, display_drv, area, pixels, stride)) {
+    lv_flush_area(glue, area->x1, area->x2, area->y1, area->y2, pixels,
+                  stride);
+  }
+
+#if defined(USE_SPI_DMA)
+  if (stats->pixels != sent) {
+    // Return while the transfer runs. LvGL renders the next area into
+    // the other half of the pixel buffer meanwhile, and only calls
+    // lv_flush_wait_callback() once it needs this half back.
+    glue->dma_busy = true;
+    if (glue->capture) {
+      // Not while capturing: the sink may write to the SD card, on this
+      // bus, from within the next flush. Finishing each area here means
+      // it always finds the bus free, rather than ending this transfer and
+      // telling LvGL so partway through that flush.
+      glue->waitForFlush();
+    }
+    return;
+  }
+#else
+  (void)sent;
+#endif
+  lv_flush_done(stats);
+  if (glue->flush_last || glue->capture) {
+    glue->waitForFlush(); // End transaction
   }
-  uint32_t width = lv_area_get_width(area);
-  uint32_t height = lv_area_get_height(area);
-  display->startWrite();
-  display->setAddrWindow(area->x1, area->y1, width, height);
-  display->writePixels(reinterpret_cast<uint16_t*>(data), width * height, false, LV_BIG_ENDIAN_SYSTEM);
   lv_disp_flush_ready(display_drv);
 }
 
+#if defined(USE_SPI_DMA)
+// Called by LvGL before it reuses a buffer that was handed to
+// lv_flush_callback(), or before the next flush in single-buffer mode.
+static void lv_flush_wait_callback(lv_display_t *display_drv) {
+  Adafruit_LvGL_Glue *glue = static_cast<Adafruit_LvGL_Glue*>(lv_display_get_user_data(display_drv));
+  glue->finishFlush();
+}
+#endif
+
+// LvGL is about to mark an area for redraw. If widening it to full rows
+// costs fewer pixels than an extra address window, do that: full-width
+// areas stacked on top of each other then flush as one window. With
+// frame-diff enabled, also round the area out to whole tiles; LvGL then
+// sizes its render bands to match, so every flush is made of whole tiles.
+static void lv_invalidate_callback(lv_event_t *e) {
+  Adafruit_LvGL_Glue *glue = static_cast<Adafruit_LvGL_Glue*>(lv_event_get_user_data(e));
+#if defined(ESP32)
+  lv_wake(); // Redraw soon, even if changed without lvgl_acquire()
+#endif
+  lv_display_t *disp = static_cast<lv_display_t *>(lv_event_get_target(e));
+  lv_area_t *area = static_cast<lv_area_t *>(lv_event_get_param(e));
+  int32_t hor_res = lv_display_get_horizontal_resolution(disp);
+  int32_t ver_res = lv_display_get_vertical_resolution(disp);
+  uint32_t extra = (hor_res - lv_area_get_width(area)) *
+                   lv_area_get_height(area);
+  if (extra && (extra < glue->window_cost)) {
+    area->x1 = 0;
+    area->x2 = hor_res - 1;
+  }
+  if (glue->tile_hash) {
+    int32_t tile = glue->tile_size;
+    area->x1 -= area->x1 % tile;
+    area->y1 -= area->y1 % tile;
+    area->x2 = min(area->x2 - area->x2 % tile + tile, hor_res) - 1;
+    area->y2 = min(area->y2 - area->y2 % tile + tile, ver_res) - 1;
+  }
+}
+
 #if (LV_USE_LOG)
 // Optional LittlevGL debug print function, writes to Serial if debug is
 // enabled when calling glue begin() function.
@@ -272,9 +1124,24 @@ static void lv_debug(lv_log_level_t level, const char *buf) { (void) level;  Ser
  * initializing minimal variables
  *
  */
-Adafruit_LvGL_Glue::Adafruit_LvGL_Glue(void) : first_frame(true) {
-#if defined(ARDUINO_ARCH_SAMD)
-  zerotimer = NULL;
+Adafruit_LvGL_Glue::Adafruit_LvGL_Glue(void)
+    : display(NULL), touch_x(0), touch_y(0), release_count(0),
+      touch_filter(),
+      touch_pressed(false), touch_more(false), touch_pending(false),
+      touch_fresh(false), touch_deferred(0), touch_request_us(0),
+      touch_poll_ms(0), touch_poll_last(0), touch_head(0), touch_tail(0),
+      touch_sample(), touch_queued_pressed(false), touch_dropped(0),
+      touch_cal(), touch_matrix(), touch_matrix_rotation(0),
+      dma_busy(false), bus_stats(), in_transaction(false), flush_last(false),
+      flush_window(), window_cost(0), tile_hash(NULL),
+      tile_size(0), tiles_x(0), tiles_y(0), flush_stats(), direct_mode(false),
+      buffer_count(0),
+      rotation(0), rotate_buf(NULL), capture(NULL), capture_ok(false),
+      lv_display(NULL), lv_touchscreen(NULL),
+      lv_pixel_buf(NULL), lv_pixel_buf_owned(false) {
+#ifdef ESP32
+  touch_lock = NULL;
+  touch_task = NULL;
 #endif
 }
 
@@ -285,39 +1152,428 @@ Adafruit_LvGL_Glue::Adafruit_LvGL_Glue(void) : first_frame(true) {
  *
  */
 Adafruit_LvGL_Glue::~Adafruit_LvGL_Glue(void) {
-#if defined(ARDUINO_ARCH_SAMD)
-  delete zerotimer;
+  if (lv_display) {
+    // Take this instance's display and touch out of LvGL, which outlives it
+#ifdef ESP32
+    lvgl_acquire();
+#endif
+    waitForFlush();
+#ifdef ESP32
+    touch_hold(this);
+    if (touch_task) {
+      vTaskDelete(touch_task); // Can't be mid-poll, this holds the lock
+    }
+    if (touch_lock) {
+      xSemaphoreGive(touch_lock);
+      vSemaphoreDelete(touch_lock);
+      touch_lock = NULL;
+    }
+#endif
+    if (lv_touchscreen) {
+      lv_indev_delete(lv_touchscreen);
+    }
+    lv_display_delete(lv_display);
+#ifdef ESP32
+    lvgl_release();
 #endif
-  // Probably other stuff that could be deallocated here
+  }
+  freeBuffers();
 }
 
-// begin() function is overloaded for STMPE610 touch, ADC touch, or none.
-
-// Pass in POINTERS to ALREADY INITIALIZED display & touch objects (user code
-// should have previously called corresponding begin() functions and checked
-// return states before invoking this),
-// they are NOT initialized here. Debug arg is
-// touch arg can be NULL (or left off) if using LittlevGL as a passive widget
-// display.
-
 /**
- * @brief Configure the glue layer and the underlying LvGL code to use the given
- * TFT display driver instance and touchscreen controller
+ * @brief Wait for any DMA screen transfer started by the flush callback to
+ * complete, end the display's SPI transaction and tell LvGL the buffer is
+ * free again. Anything else sharing the display's bus (touch controller, SD
+ * card) must call this before using the bus.
  *
- * @param tft Pointer to an **already initialized** display object instance
- * @param touch Pointer to an **already initialized** `Adafruit_STMPE610`
- * touchscreen controller object instance
- * @param debug Debug flag to enable debug messages. Only used if LV_USE_LOG is
- * configured in LittleLVGL's lv_conf.h
- * @return LvGLStatus The status of the initialization:
- * * LVGL_OK : Success
- * * LVGL_ERR_TIMER : Failure to set up timers
- * * LVGL_ERR_ALLOC : Failure to allocate memory
+ */
+void Adafruit_LvGL_Glue::waitForFlush(void) {
+  finishFlush();
+  if (in_transaction) {
+    display->endWrite();
+    in_transaction = false;
+  }
+}
+
+/**
+ * @brief Wait for any DMA screen transfer started by the flush callback to
+ * complete and tell LvGL the buffer is free again. The display's SPI
+ * transaction is left open for the next area of the same refresh.
+ *
+ */
+void Adafruit_LvGL_Glue::finishFlush(void) {
+  if (dma_busy) {
+    display->dmaWait(); // Wait for prior DMA transfer to complete
+    lv_flush_done(&flush_stats);
+    dma_busy = false;
+    if (flush_last) {
+      display->endWrite(); // End of refresh, end transaction
+      in_transaction = false;
+    }
+    if (touch_pending) {
+      // A touch poll was put off for this transfer; the bus is free until
+      // the next flush, so read it now
+      if (in_transaction) {
+        display->endWrite();
+        in_transaction = false;
+      }
+      bus_stats.claims[LVGL_BUS_TOUCH]++;
+      bus_stats.waited[LVGL_BUS_TOUCH]++;
+      lv_hist_add(bus_stats.wait_hist[LVGL_BUS_TOUCH],
+                  micros() - touch_request_us);
+      stmpe_read(this);
+      touch_fresh = true;
+    }
+    lv_disp_flush_ready(lv_display);
+  }
+}
+
+/**
+ * @brief Take the display's shared SPI bus for another device: wait for
+ * any DMA transfer to the display to finish and end its SPI transaction.
+ * The bus is then the caller's until LvGL's next flush, which picks up
+ * where it left off. Wait times are counted in bus_stats.
+ *
+ * @param client The device that wants the bus
+ */
+void Adafruit_LvGL_Glue::claimBus(LvGLBusClient client) {
+  uint32_t start = micros();
+  bool busy = dma_busy;
+  waitForFlush();
+  bus_stats.claims[client]++;
+  if (busy) {
+    bus_stats.waited[client]++;
+  }
+  lv_hist_add(bus_stats.wait_hist[client], micros() - start);
+}
+
+/**
+ * @brief Sample the touchscreen into the ring that LvGL reads touch from,
+ * if LvGLConfig::touch_poll_ms is set. Call this from loop(), as often as
+ * you like; it only samples every touch_poll_ms. Not needed on ESP32,
+ * where a task of its own does it.
+ *
+ */
+void Adafruit_LvGL_Glue::pollTouch(void) {
+  uint32_t now = millis();
+  if (!lv_touchscreen || !touch_poll_ms ||
+      (now - touch_poll_last < touch_poll_ms)) {
+    return;
+  }
+  touch_poll_last = now;
+#ifdef ESP32
+  lvgl_acquire();
+  touch_hold(this);
+#endif
+  touch_poll(this);
+#ifdef ESP32
+  touch_unhold(this);
+  lvgl_release();
+#endif
+}
+
+/**
+ * @brief Calibrate the touchscreen. Three crosshairs are drawn in turn,
+ * straight to the display, each to be touched (a stylus helps). The new
+ * profile is put in use and LvGL's screen is then redrawn. Keep the
+ * profile (getTouchCalibration() or saveTouchCalibration()) and pass it to
+ * begin() through LvGLConfig::touch_calibration next time. On ESP32 this
+ * takes the LvGL lock itself.
+ *
+ * @param timeout_ms How long to wait for each touch
+ * @return true Calibrated
+ * @return false Timed out, or the touches made no sense
+ */
+bool Adafruit_LvGL_Glue::calibrateTouch(uint32_t timeout_ms) {
+  if (!lv_touchscreen) {
+    return false;
+  }
+#ifdef ESP32
+  lvgl_acquire();
+  touch_hold(this);
+#endif
+  waitForFlush(); // The display is drawn to directly from here on
+  // Targets, in the display's current (GFX-rotated) coordinates
+  int32_t w = display->width(), h = display->height();
+  int32_t target[3][2] = {{w / 8, h / 8},
+                          {w - 1 - w / 8, h / 2},
+                          {w / 2, h - 1 - h / 8}};
+  int32_t raw[3][2];
+  bool ok = true;
+  for (uint8_t i = 0; ok && (i < 3); i++) {
+    display->fillScreen(0x0000);
+    display->drawFastHLine(target[i][0] - 10, target[i][1], 21, 0xFFFF);
+    display->drawFastVLine(target[i][0], target[i][1] - 10, 21, 0xFFFF);
+    ok = touch_raw_average(this, raw[i], timeout_ms);
+  }
+  LvGLTouchCalibration cal;
+  if (ok && touch_solve(raw, target, cal.matrix)) {
+    // Turn the matrix from the current rotation back to the panel's own
+    int32_t pw, ph;
+    touch_panel_size(this, &pw, &ph);
+    touch_turn(cal.matrix, 4 - display->getRotation(), w, h);
+    cal.magic = LVGL_TOUCH_CAL_MAGIC;
+    cal.width = pw;
+    cal.height = ph;
+    ok = touch_set_cal(this, &cal);
+  } else {
+    ok = false;
+  }
+  resetTileHashes(); // Screen was drawn over behind frame-diff's back
+  lv_obj_invalidate(lv_display_get_screen_active(lv_display));
+#ifdef ESP32
+  touch_unhold(this);
+  lvgl_release();
+#endif
+  return ok;
+}
+
+/**
+ * @brief Use a touchscreen calibration profile, e.g. one kept from
+ * calibrateTouch(). On ESP32 this takes the LvGL lock itself.
+ *
+ * @param cal The profile
+ * @return true Profile in use
+ * @return false Not a profile for this display's panel
+ */
+bool Adafruit_LvGL_Glue::setTouchCalibration(const LvGLTouchCalibration &cal) {
+  if (!lv_touchscreen) {
+    return false;
+  }
+#ifdef ESP32
+  lvgl_acquire(); // Touch may be read meanwhile
+  touch_hold(this);
+#endif
+  bool ok = touch_set_cal(this, &cal);
+#ifdef ESP32
+  touch_unhold(this);
+  lvgl_release();
+#endif
+  return ok;
+}
+
+/**
+ * @brief Write the touchscreen calibration profile in use to a file,
+ * through an LvGL drive (e.g. "S:touch.cal" with Adafruit_LvGL_Glue_SD).
+ * On ESP32 this takes the LvGL lock itself.
+ *
+ * @param path LvGL path of the file; replaced if it exists
+ * @return true Saved
+ * @return false Couldn't write the file
+ */
+bool Adafruit_LvGL_Glue::saveTouchCalibration(const char *path) {
+  lv_fs_file_t file;
+  uint32_t bw;
+  bool ok = false;
+#ifdef ESP32
+  lvgl_acquire();
+#endif
+  if (lv_fs_open(&file, path, LV_FS_MODE_WR) == LV_FS_RES_OK) {
+    ok = (lv_fs_write(&file, &touch_cal, sizeof(touch_cal), &bw) ==
+          LV_FS_RES_OK) &&
+         (bw == sizeof(touch_cal));
+    ok = (lv_fs_close(&file) == LV_FS_RES_OK) && ok;
+  }
+#ifdef ESP32
+  lvgl_release();
+#endif
+  return ok;
+}
+
+/**
+ * @brief Read a touchscreen calibration profile written by
+ * saveTouchCalibration() and put it in use. On ESP32 this takes the LvGL
+ * lock itself.
+ *
+ * @param path LvGL path of the file
+ * @return true Profile in use
+ * @return false No such file, or not a profile for this display's panel
+ */
+bool Adafruit_LvGL_Glue::loadTouchCalibration(const char *path) {
+  LvGLTouchCalibration cal;
+  lv_fs_file_t file;
+  uint32_t br;
+  bool ok = false;
+  if (!lv_touchscreen) {
+    return false;
+  }
+#ifdef ESP32
+  lvgl_acquire();
+#endif
+  if (lv_fs_open(&file, path, LV_FS_MODE_RD) == LV_FS_RES_OK) {
+    ok = (lv_fs_read(&file, &cal, sizeof(cal), &br) == LV_FS_RES_OK) &&
+         (br == sizeof(cal));
+    lv_fs_close(&file);
+  }
+#ifdef ESP32
+  touch_hold(this);
+#endif
+  ok = ok && touch_set_cal(this, &cal);
+#ifdef ESP32
+  touch_unhold(this);
+  lvgl_release();
+#endif
+  return ok;
+}
+
+#ifdef ESP32
+/**
+ * @brief Get the GUI task's counters. The GUI task is shared, so these
+ * cover every glue instance. Takes the LvGL lock itself.
+ *
+ * @param stats Set to the counters, and the task's free stack low point
+ * @param reset If true, restart counting (the stack low point is kept by
+ * FreeRTOS and not reset)
+ */
+void Adafruit_LvGL_Glue::getTaskStats(LvGLTaskStats *stats, bool reset) {
+  if (!g_lvgl_task_handle) {
+    memset(stats, 0, sizeof(LvGLTaskStats)); // Not started
+    return;
+  }
+  lvgl_acquire();
+  *stats = lv_task_stats;
+  if (reset) {
+    memset(&lv_task_stats, 0, sizeof(LvGLTaskStats));
+  }
+  lvgl_release();
+  // ESP-IDF counts stack in bytes, not words
+  stats->stack_free = uxTaskGetStackHighWaterMark(g_lvgl_task_handle);
+}
+#endif
+
+#if LVGL_COMMAND_QUEUE
+// Queues a command for the GUI task and wakes it. Fails if LvGL isn't
+// started or the queue is full.
+static bool lv_command_post(lv_command_type_t type, lv_obj_t *obj,
+                            int32_t value, const char *text) {
+  lv_command_t *cmd;
+  if (!lv_task_running || !obj || !(cmd = lv_command_claim())) {
+    return false;
+  }
+  cmd->type = type;
+  cmd->obj = obj;
+  cmd->value = value;
+  if (text) {
+    strcpy(cmd->text, text);
+  }
+  lv_command_done(cmd);
+#ifdef ESP32
+  if (g_lvgl_task_handle) { // Only set once the GUI task is created
+    xTaskNotifyGive(g_lvgl_task_handle); // Even from the GUI task itself
+  }
+#endif
+  return true;
+}
+
+/**
+ * @brief Set a label's or text area's text, from any task and without the
+ * LvGL lock. The text is copied; the GUI task applies it before its next
+ * frame, in the order posted. If the object is deleted meanwhile the
+ * update is dropped. On ESP32, not from interrupts.
+ *
+ * @param obj The label or text area
+ * @param text The new text, shorter than LVGL_COMMAND_TEXT
+ * @return true Posted
+ * @return false Text too long, or LVGL_COMMAND_QUEUE updates already wait;
+ * post it again later or use an LvGLLock
+ */
+bool Adafruit_LvGL_Glue::postText(lv_obj_t *obj, const char *text) {
+  if (strlen(text) >= LVGL_COMMAND_TEXT) {
+    return false;
+  }
+  return lv_command_post(LV_CMD_TEXT, obj, 0, text);
+}
+
+/**
+ * @brief Set a bar's, slider's or arc's value, from any task and without
+ * the LvGL lock. Applied like postText(), without animation.
+ *
+ * @param obj The bar, slider or arc
+ * @param value The new value
+ * @return true Posted
+ * @return false LVGL_COMMAND_QUEUE updates already wait
+ */
+bool Adafruit_LvGL_Glue::postValue(lv_obj_t *obj, int32_t value) {
+  return lv_command_post(LV_CMD_VALUE, obj, value, NULL);
+}
+
+/**
+ * @brief Have an object redrawn, from any task and without the LvGL lock,
+ * e.g. after changing data it draws from. Applied like postText().
+ *
+ * @param obj The object
+ * @return true Posted
+ * @return false LVGL_COMMAND_QUEUE updates already wait
+ */
+bool Adafruit_LvGL_Glue::postInvalidate(lv_obj_t *obj) {
+  return lv_command_post(LV_CMD_INVALIDATE, obj, 0, NULL);
+}
+#endif
+
+/**
+ * @brief Forget what the frame-diff tile hashes say is on screen, so the
+ * next redraw of every area is sent in full. Call this after drawing to
+ * the display directly (not through LvGL), or after a panel reset.
+ *
+ */
+void Adafruit_LvGL_Glue::resetTileHashes(void) {
+  if (tile_hash) {
+    memset(tile_hash, 0, tiles_x * tiles_y * sizeof(uint32_t));
+  }
+}
+
+/**
+ * @brief Capture what's on screen. The whole screen is redrawn at once,
+ * and each area is handed to the sink as it's flushed to the display, so
+ * no frame buffer is needed beyond what the sink keeps. Frame-diff still
+ * skips sending unchanged tiles to the display; the sink gets them all.
+ * On ESP32, call between lvgl_acquire() and lvgl_release().
+ *
+ * @param sink Where to put the frame, e.g. an LvGLCaptureFile
+ * @return true The whole frame reached the sink
+ * @return false Not started, or the sink failed
+ */
+bool Adafruit_LvGL_Glue::captureFrame(LvGLCaptureSink &sink) {
+  if (!lv_display ||
+      !sink.begin(lv_display_get_horizontal_resolution(lv_display),
+                  lv_display_get_vertical_resolution(lv_display))) {
+    return false;
+  }
+  capture = &sink;
+  capture_ok = true;
+  lv_obj_invalidate(lv_display_get_screen_active(lv_display));
+  lv_refr_now(lv_display);
+  capture = NULL;
+  // The last area may still be going out by DMA, but the sink has had it
+  waitForFlush();
+  return sink.end() && capture_ok;
+}
+
+// begin() function is overloaded for STMPE610 touch, ADC touch, or none.
+
+// Pass in POINTERS to ALREADY INITIALIZED display & touch objects (user code
+// should have previously called corresponding begin() functions and checked
+// return states before invoking this),
+// they are NOT initialized here. Debug arg is
+// touch arg can be NULL (or left off) if using LittlevGL as a passive widget
+// display.
+
+/**
+ * @brief Configure the glue layer and the underlying LvGL code to use the given
+ * TFT display driver instance and touchscreen controller
+ *
+ * @param tft Pointer to an **already initialized** display object instance
+ * @param touch Pointer to an **already initialized** `Adafruit_STMPE610`
+ * touchscreen controller object instance
+ * @param debug Debug flag to enable debug messages. Only used if LV_USE_LOG is
+ * configured in LittleLVGL's lv_conf.h
+ * @return LvGLStatus The status of the initialization:
+ * * LVGL_OK : Success
+ * * LVGL_ERR_ALLOC : Failure to allocate memory
  */
 LvGLStatus Adafruit_LvGL_Glue::begin(Adafruit_SPITFT *tft,
                                      Adafruit_STMPE610 *touch, bool debug) {
-  is_adc_touch = false;
-  return begin(tft, (void *)touch, debug);
+  return begin(tft, touch, LvGLConfig(), debug);
 }
 /**
  * @brief Configure the glue layer and the underlying LvGL code to use the given
@@ -330,13 +1586,11 @@ LvGLStatus Adafruit_LvGL_Glue::begin(Adafruit_SPITFT *tft,
  * configured in LittleLVGL's lv_conf.h
  * @return LvGLStatus The status of the initialization:
  * * LVGL_OK : Success
- * * LVGL_ERR_TIMER : Failure to set up timers
  * * LVGL_ERR_ALLOC : Failure to allocate memory
  */
 LvGLStatus Adafruit_LvGL_Glue::begin(Adafruit_SPITFT *tft, TouchScreen *touch,
                                      bool debug) {
-  is_adc_touch = true;
-  return begin(tft, (void *)touch, debug);
+  return begin(tft, touch, LvGLConfig(), debug);
 }
 /**
  * @brief Configure the glue layer and the underlying LvGL code to use the given
@@ -347,57 +1601,376 @@ LvGLStatus Adafruit_LvGL_Glue::begin(Adafruit_SPITFT *tft, TouchScreen *touch,
  * configured in LittleLVGL's lv_conf.h
  * @return LvGLStatus The status of the initialization:
  * * LVGL_OK : Success
- * * LVGL_ERR_TIMER : Failure to set up timers
  * * LVGL_ERR_ALLOC : Failure to allocate memory
  */
 LvGLStatus Adafruit_LvGL_Glue::begin(Adafruit_SPITFT *tft, bool debug) {
-  return begin(tft, (void *)NULL, debug);
+  return begin(tft, LvGLConfig(), debug);
+}
+
+/**
+ * @brief Configure the glue layer and the underlying LvGL code to use the given
+ * TFT display driver and touchscreen controller instances, with non-default
+ * draw buffer settings
+ *
+ * @param tft Pointer to an **already initialized** display object instance
+ * @param touch Pointer to an **already initialized** `Adafruit_STMPE610`
+ * touchscreen controller object instance
+ * @param config Draw buffer size, mode and placement, see LvGLConfig
+ * @param debug Debug flag to enable debug messages. Only used if LV_USE_LOG is
+ * configured in LittleLVGL's lv_conf.h
+ * @return LvGLStatus The status of the initialization:
+ * * LVGL_OK : Success
+ * * LVGL_ERR_ALLOC : Failure to allocate memory, or config.buffer too small
+ * * LVGL_ERR_CONFIG : config.rotation used with LVGL_BUFFER_FULL_FRAME, or
+ * a gui_core or gui_priority this chip doesn't have
+ */
+LvGLStatus Adafruit_LvGL_Glue::begin(Adafruit_SPITFT *tft,
+                                     Adafruit_STMPE610 *touch,
+                                     const LvGLConfig &config, bool debug) {
+  is_adc_touch = false;
+  return begin(tft, (void *)touch, config, debug);
+}
+
+/**
+ * @brief Configure the glue layer and the underlying LvGL code to use the given
+ * TFT display driver and touchscreen controller instances, with non-default
+ * draw buffer settings
+ *
+ * @param tft Pointer to an **already initialized** display object instance
+ * @param touch Pointer to an **already initialized** `TouchScreen` touchscreen
+ * controller object instance
+ * @param config Draw buffer size, mode and placement, see LvGLConfig
+ * @param debug Debug flag to enable debug messages. Only used if LV_USE_LOG is
+ * configured in LittleLVGL's lv_conf.h
+ * @return LvGLStatus The status of the initialization:
+ * * LVGL_OK : Success
+ * * LVGL_ERR_ALLOC : Failure to allocate memory, or config.buffer too small
+ * * LVGL_ERR_CONFIG : config.rotation used with LVGL_BUFFER_FULL_FRAME, or
+ * a gui_core or gui_priority this chip doesn't have
+ */
+LvGLStatus Adafruit_LvGL_Glue::begin(Adafruit_SPITFT *tft, TouchScreen *touch,
+                                     const LvGLConfig &config, bool debug) {
+  is_adc_touch = true;
+  return begin(tft, (void *)touch, config, debug);
+}
+
+/**
+ * @brief Configure the glue layer and the underlying LvGL code to use the given
+ * TFT display driver instance, with non-default draw buffer settings
+ *
+ * @param tft Pointer to an **already initialized** display object instance
+ * @param config Draw buffer size, mode and placement, see LvGLConfig
+ * @param debug Debug flag to enable debug messages. Only used if LV_USE_LOG is
+ * configured in LittleLVGL's lv_conf.h
+ * @return LvGLStatus The status of the initialization:
+ * * LVGL_OK : Success
+ * * LVGL_ERR_ALLOC : Failure to allocate memory, or config.buffer too small
+ * * LVGL_ERR_CONFIG : config.rotation used with LVGL_BUFFER_FULL_FRAME, or
+ * a gui_core or gui_priority this chip doesn't have
+ */
+LvGLStatus Adafruit_LvGL_Glue::begin(Adafruit_SPITFT *tft,
+                                     const LvGLConfig &config, bool debug) {
+  return begin(tft, (void *)NULL, config, debug);
+}
+
+/**
+ * @brief Byte-swap RGB565 pixels between the MCU's little-endian order and
+ * the big-endian order displays expect. Works a 32-bit word (two pixels)
+ * at a time, using the REV16 instruction on ARM, or 64 bits at a time on
+ * 64-bit hosts.
+ *
+ * @param dest Where to write swapped pixels, may be the same as src
+ * @param src Pixels to swap
+ * @param len Number of pixels
+ */
+void Adafruit_LvGL_Glue::swapPixels(uint16_t *dest, const uint16_t *src,
+                                    uint32_t len) {
+  if (len && ((uintptr_t)src & 2)) { // Get src to a word boundary
+    *dest++ = __builtin_bswap16(*src++);
+    len--;
+  }
+  if (!((uintptr_t)dest & 2)) { // Both on word boundaries
+    const uint32_t *s32 = (const uint32_t *)src;
+    uint32_t *d32 = (uint32_t *)dest;
+#if defined(__arm__)
+    for (; len >= 8; len -= 8, s32 += 4, d32 += 4) { // 8 pixels per pass
+      uint32_t a = s32[0], b = s32[1], c = s32[2], d = s32[3];
+      __asm__("rev16 %0, %0" : "+l"(a));
+      __asm__("rev16 %0, %0" : "+l"(b));
+      __asm__("rev16 %0, %0" : "+l"(c));
+      __asm__("rev16 %0, %0" : "+l"(d));
+      d32[0] = a;
+      d32[1] = b;
+      d32[2] = c;
+      d32[3] = d;
+    }
+#elif UINTPTR_MAX > 0xFFFFFFFFUL
+    if (len >= 4 && !((uintptr_t)s32 & 4) && !((uintptr_t)d32 & 4)) {
+      const uint64_t *s64 = (const uint64_t *)s32;
+      uint64_t *d64 = (uint64_t *)d32;
+      for (; len >= 4; len -= 4) { // 4 pixels per pass
+        uint64_t x = *s64++;
+        *d64++ = ((x & 0x00FF00FF00FF00FFULL) << 8) |
+                 ((x >> 8) & 0x00FF00FF00FF00FFULL);
+      }
+      s32 = (const uint32_t *)s64;
+      d32 = (uint32_t *)d64;
+    }
+#endif
+    for (; len >= 2; len -= 2) { // 2 pixels per pass
+      uint32_t x = *s32++;
+      *d32++ = ((x & 0x00FF00FFUL) << 8) | ((x >> 8) & 0x00FF00FFUL);
+    }
+    src = (const uint16_t *)s32;
+    dest = (uint16_t *)d32;
+  }
+  while (len--) {
+    *dest++ = __builtin_bswap16(*src++);
+  }
+}
+
+// Size, place and hand the LvGL draw buffer(s) to lv_display, per config.
+// Buffers come from config.buffer if given, else from the heap.
+LvGLStatus Adafruit_LvGL_Glue::initBuffers(const LvGLConfig &config) {
+  uint32_t width = lv_display_get_horizontal_resolution(lv_display);
+  uint32_t height = lv_display_get_vertical_resolution(lv_display);
+  uint32_t row_bytes = width * sizeof(uint16_t);
+
+  LvGLBufferMode mode = config.buffer_mode;
+  if (mode == LVGL_BUFFER_AUTO) {
+#if defined(USE_SPI_DMA)
+    mode = LVGL_BUFFER_DOUBLE; // Render one while DMA sends the other
+#else
+    mode = LVGL_BUFFER_SINGLE;
+#endif
+  }
+  uint8_t count = (mode == LVGL_BUFFER_SINGLE) ? 1 : 2;
+
+  // Caller's memory, from its first 4-byte boundary
+  uint8_t *mem = (uint8_t *)config.buffer;
+  size_t avail = 0;
+  if (mem) {
+    size_t pad = (4 - ((uintptr_t)mem & 3)) & 3;
+    avail = (config.buffer_size > pad) ? (config.buffer_size - pad) : 0;
+    mem += pad;
+  }
+
+  // Bytes per buffer. LvGL wants each buffer 4-byte aligned, so sizes
+  // are rounded down to a multiple of 4.
+  uint32_t bytes;
+  if (mode == LVGL_BUFFER_FULL_FRAME) {
+    bytes = row_bytes * height;
+  } else if (config.buffer_bytes) {
+    bytes = config.buffer_bytes;
+  } else if (config.buffer_rows) {
+    bytes = row_bytes * config.buffer_rows;
+  } else if (mem) {
+    bytes = avail / count; // Use all of caller's memory
+  } else {
+    bytes = row_bytes * LV_BUFFER_ROWS;
+  }
+  bytes &= ~3UL;
+  if (bytes < row_bytes) {
+    return LVGL_ERR_ALLOC; // LvGL needs at least one full row
+  }
+
+  if (mem) {
+    if ((count > 1) && (avail < bytes * count)) {
+      if (config.buffer_mode == LVGL_BUFFER_DOUBLE) {
+        return LVGL_ERR_ALLOC; // Asked for two, don't quietly give one
+      }
+      count = 1; // Room for only one buffer, e.g. a single full frame
+    }
+    if (avail < bytes) {
+      return LVGL_ERR_ALLOC;
+    }
+  } else {
+    // A second full frame is a luxury; do without it if RAM is short
+    while (!(mem = (uint8_t *)malloc(bytes * count)) &&
+           (mode == LVGL_BUFFER_FULL_FRAME) && (count > 1)) {
+      count--;
+    }
+    if (!mem) {
+      return LVGL_ERR_ALLOC;
+    }
+    lv_pixel_buf_owned = true;
+  }
+  lv_pixel_buf = (uint16_t *)mem;
+  buffer_count = count;
+
+  // Full-frame buffers use DIRECT mode: LvGL redraws only the changed
+  // areas in place and lv_flush_callback() sends just those.
+  direct_mode = (mode == LVGL_BUFFER_FULL_FRAME);
+  lv_display_set_buffers(lv_display, mem, (count > 1) ? (mem + bytes) : NULL,
+                         bytes,
+                         direct_mode ? LV_DISPLAY_RENDER_MODE_DIRECT
+                                     : LV_DISPLAY_RENDER_MODE_PARTIAL);
+
+  if (rotation) {
+    // Rotated areas are at most one draw buffer's worth of pixels
+    if (!(rotate_buf = (uint16_t *)malloc(bytes))) {
+      return LVGL_ERR_ALLOC;
+    }
+  }
+
+  if (config.diff_tile) {
+    // Frame-diff hash table, 4 bytes per tile, all "unknown" to start
+    tile_size = config.diff_tile;
+    tiles_x = (width + tile_size - 1) / tile_size;
+    tiles_y = (height + tile_size - 1) / tile_size;
+    if (!(tile_hash = (uint32_t *)calloc(tiles_x * tiles_y, sizeof(uint32_t)))) {
+      return LVGL_ERR_ALLOC;
+    }
+  }
+  return LVGL_OK;
+}
+
+// Release draw buffer memory, if it was allocated here
+void Adafruit_LvGL_Glue::freeBuffers(void) {
+  if (lv_pixel_buf_owned) {
+    free(lv_pixel_buf);
+    lv_pixel_buf_owned = false;
+  }
+  lv_pixel_buf = NULL;
+  free(tile_hash);
+  tile_hash = NULL;
+  free(rotate_buf);
+  rotate_buf = NULL;
+}
+
+// Start what LittlevGL shares between glue instances: on ESP32 the GUI task
+// (set up by the first instance's LvGLConfig) and the lock around it.
+// Elsewhere the sketch calls lv_task_handler().
+static LvGLStatus lv_task_begin(const LvGLConfig &config) {
+#if LVGL_COMMAND_QUEUE
+  lv_commands_init();
+#endif
+#if defined(ESP32)
+  BaseType_t core;
+  switch (config.gui_core) {
+  case LVGL_CORE_AUTO:
+#if CONFIG_FREERTOS_UNICORE
+    core = 0; // Single-core ESP32-x (S2, C3...)
+#else
+    core = 1; // Multicore ESP32-x, leave core 0 to WiFi
+#endif
+    break;
+  case LVGL_CORE_ANY:
+    core = tskNO_AFFINITY;
+    break;
+  default:
+    core = config.gui_core - LVGL_CORE_0;
+    if (core >= portNUM_PROCESSORS) {
+      return LVGL_ERR_CONFIG; // No such core on this chip
+    }
+  }
+  UBaseType_t priority =
+      config.gui_priority ? config.gui_priority : LV_GUI_PRIORITY;
+  uint32_t stack =
+      config.gui_stack_bytes ? config.gui_stack_bytes : LV_GUI_STACK_BYTES;
+  if (priority >= configMAX_PRIORITIES) {
+    return LVGL_ERR_CONFIG;
+  }
+
+  // Create a new mutex
+  xGuiSemaphore = xSemaphoreCreateMutex();
+  if (xGuiSemaphore == NULL) {
+    return LVGL_ERR_MUTEX; // failure
+  }
+
+  if (xTaskCreatePinnedToCore(gui_task, "lvgl_gui", stack, NULL, priority,
+                              &g_lvgl_task_handle, core) != pdPASS) {
+    g_lvgl_task_handle = NULL;
+    vSemaphoreDelete(xGuiSemaphore);
+    xGuiSemaphore = NULL;
+    return LVGL_ERR_TASK; // failure
+  }
+#elif LVGL_COMMAND_QUEUE
+  if (!lv_timer_create(lv_command_timer, LV_DEF_REFR_PERIOD, NULL)) {
+    return LVGL_ERR_ALLOC;
+  }
+#endif
+
+  lv_task_running = true;
+  return LVGL_OK;
 }
 
 LvGLStatus Adafruit_LvGL_Glue::begin(Adafruit_SPITFT *tft, void *touch,
-                                     bool debug) {
+                                     const LvGLConfig &config, bool debug) {
 
-  lv_init();
+  if (!lv_is_initialized()) {
+    lv_init(); // Once for all instances
+  }
 #if (LV_USE_LOG)
   if (debug) {
     lv_log_register_print_cb(lv_debug); // Register debug print function
   }
 #endif
   lv_tick_set_cb(lv_tick_callback);
-  // Allocate LvGL display buffer (x2 because DMA double buffering)
-  LvGLStatus status = LVGL_ERR_ALLOC;
-#if defined(USE_SPI_DMA)
-  lv_pixel_buf.resize(tft->width() * LV_BUFFER_ROWS * 2);
-  if(true) {
-#else
-  lv_pixel_buf.resize(tft->width() * LV_BUFFER_ROWS);
-  if(true) {
-#endif
 
-    display = tft;
-    touchscreen = (void *)touch;
+  display = tft;
+  touchscreen = (void *)touch;
+  touch_poll_ms = config.touch_poll_ms;
+
+  rotation = config.rotation & 3;
+  if (rotation && (config.buffer_mode == LVGL_BUFFER_FULL_FRAME)) {
+    return LVGL_ERR_CONFIG; // LvGL's frame is the buffer, can't rotate it
+  }
+
+  if (touch) {
+    LvGLTouchFilter *f = &touch_filter;
+    memset(f, 0, sizeof(LvGLTouchFilter));
+    f->median = min(max(config.touch_median, (uint8_t)1),
+                    (uint8_t)LVGL_TOUCH_MEDIAN_MAX);
+    f->smooth = config.touch_smooth;
+    f->press_count = max(config.touch_press_count, (uint8_t)1);
+    f->release_count = config.touch_release_count;
+    if (!f->release_count) {
+      f->release_count = is_adc_touch ? ADC_RELEASE_COUNT : STMPE_RELEASE_COUNT;
+    }
+    if (config.touch_calibration) {
+      if (!touch_set_cal(this, config.touch_calibration)) {
+        return LVGL_ERR_CONFIG; // Not a profile for this panel
+      }
+    } else {
+      LvGLTouchCalibration cal;
+      touch_default_calibration(this, &cal);
+      touch_set_cal(this, &cal);
+    }
+  }
 
 #if defined(ARDUINO_NRF52840_CLUE) || defined(ARDUINO_NRF52840_CIRCUITPLAY) || \
     defined(ARDUINO_SAMD_CIRCUITPLAYGROUND_EXPRESS)
-    // ST7789 library (used by CLUE and TFT Gizmo for Circuit Playground
-    // Express/Bluefruit) is sort of low-level rigged to a 240x320
-    // screen, so this needs to work around that manually...
-    lv_display = lv_display_create(240, 240);
+  // ST7789 library (used by CLUE and TFT Gizmo for Circuit Playground
+  // Express/Bluefruit) is sort of low-level rigged to a 240x320
+  // screen, so this needs to work around that manually...
+  lv_display = lv_display_create(240, 240);
 #else
-    lv_display = lv_display_create(tft->width(), tft->width());
+  if (rotation & 1) { // Quarter turn, LvGL sees the display on its side
+    lv_display = lv_display_create(tft->height(), tft->width());
+  } else {
+    lv_display = lv_display_create(tft->width(), tft->height());
+  }
 #endif
 
+  // Allocate LvGL display buffer(s)
+  LvGLStatus status = LVGL_ERR_ALLOC;
+  if (lv_display && (initBuffers(config) == LVGL_OK)) {
+
     lv_display_set_flush_cb(lv_display, lv_flush_callback);
-    lv_display_set_user_data(lv_display, this);
-    // Initialize LvGL display buffers. The "second half" buffer is only
-    // used if USE_SPI_DMA is enabled in Adafruit_GFX.
-    lv_display_set_buffers(lv_display, lv_pixel_buf.data(),
 #if defined(USE_SPI_DMA)
-                          lv_pixel_buf.size(),
-#else
-                          NULL, // No double-buffering
+    lv_display_set_flush_wait_cb(lv_display, lv_flush_wait_callback);
+#endif
+    lv_display_set_user_data(lv_display, this);
+    window_cost = config.window_cost;
+    bool wake = false;
+#if defined(ESP32)
+    wake = true; // The callback also wakes the GUI task
 #endif
-                          lv_pixel_buf.size(), LV_DISPLAY_RENDER_MODE_PARTIAL);
+    if (window_cost || tile_hash || wake) {
+      lv_display_add_event_cb(lv_display, lv_invalidate_callback,
+                              LV_EVENT_INVALIDATE_AREA, this);
+    }
 
     // Initialize LvGL input device (touchscreen already started)
     if ((touch)) { // Can also pass NULL if passive widget display
@@ -405,123 +1978,230 @@ LvGLStatus Adafruit_LvGL_Glue::begin(Adafruit_SPITFT *tft, void *touch,
       lv_indev_set_type(lv_touchscreen, LV_INDEV_TYPE_POINTER); // Is pointer dev
       lv_indev_set_read_cb(lv_touchscreen, touchscreen_read); // Read callback
       lv_indev_set_user_data(lv_touchscreen, this);
+      lv_indev_set_display(lv_touchscreen, lv_display); // Not the default
     }
 
-    // TIMER SETUP is architecture-specific ----------------------------
-
-#if defined(ARDUINO_ARCH_SAMD) // --------------------------------------
-
-    // status is still ERR_ALLOC until proven otherwise...
-    if ((zerotimer = new Adafruit_ZeroTimer(TIMER_NUM))) {
-      uint16_t divider = 1;
-      uint16_t compare = 0;
-      tc_clock_prescaler prescaler = TC_CLOCK_PRESCALER_DIV1;
-
-      status = LVGL_OK; // We're prob good now, but one more test...
-
-      int freq = 1000 / lv_tick_interval_ms;
-
-      if ((freq < (48000000 / 2)) && (freq > (48000000 / 65536))) {
-        divider = 1;
-        prescaler = TC_CLOCK_PRESCALER_DIV1;
-      } else if (freq > (48000000 / 65536 / 2)) {
-        divider = 2;
-        prescaler = TC_CLOCK_PRESCALER_DIV2;
-      } else if (freq > (48000000 / 65536 / 4)) {
-        divider = 4;
-        prescaler = TC_CLOCK_PRESCALER_DIV4;
-      } else if (freq > (48000000 / 65536 / 8)) {
-        divider = 8;
-        prescaler = TC_CLOCK_PRESCALER_DIV8;
-      } else if (freq > (48000000 / 65536 / 16)) {
-        divider = 16;
-        prescaler = TC_CLOCK_PRESCALER_DIV16;
-      } else if (freq > (48000000 / 65536 / 64)) {
-        divider = 64;
-        prescaler = TC_CLOCK_PRESCALER_DIV64;
-      } else if (freq > (48000000 / 65536 / 256)) {
-        divider = 256;
-        prescaler = TC_CLOCK_PRESCALER_DIV256;
-      } else {
-        status = LVGL_ERR_TIMER; // Invalid frequency
-      }
+    // The GUI task is shared, only the first instance starts it
+    status = lv_task_running ? LVGL_OK : lv_task_begin(config);
 
-      if (status == LVGL_OK) {
-        compare = (48000000 / divider) / freq;
-        // Initialize timer
-        zerotimer->configure(prescaler, TC_COUNTER_SIZE_16BIT,
-                             TC_WAVE_GENERATION_MATCH_PWM);
-        zerotimer->setCompare(0, compare);
-        zerotimer->setCallback(true, TC_CALLBACK_CC_CHANNEL0, timerCallback0);
-        zerotimer->enable(true);
+#if defined(ESP32)
+    if (lv_touchscreen && touch_poll_ms) {
+      // No input timer; the GUI task reads the ring when woken with samples
+      lv_indev_set_mode(lv_touchscreen, LV_INDEV_MODE_EVENT);
+    }
+    if ((status == LVGL_OK) && lv_touchscreen && touch_poll_ms) {
+      UBaseType_t priority = config.touch_priority ? config.touch_priority
+                                                   : LV_TOUCH_PRIORITY;
+      uint32_t stack = config.touch_stack_bytes ? config.touch_stack_bytes
+                                                : LV_TOUCH_STACK_BYTES;
+      if (priority >= configMAX_PRIORITIES) {
+        status = LVGL_ERR_CONFIG;
+      } else if (is_adc_touch &&
+                 !(touch_lock = xSemaphoreCreateMutex())) {
+        status = LVGL_ERR_MUTEX;
+      } else if (xTaskCreate(touch_task_fn, "lvgl_touch", stack, this,
+                             priority, &touch_task) != pdPASS) {
+        touch_task = NULL;
+        status = LVGL_ERR_TASK;
       }
     }
+#endif
+  }
 
-#elif defined(ESP32) // ------------------------------------------------
-    // Create a periodic timer to call `lv_tick_handler`
-    const esp_timer_create_args_t periodic_timer_args = {
-        .callback = &lv_tick_handler, 
-        .name = "lv_tick_handler"
-    };
-    esp_timer_handle_t periodic_timer;
-    ESP_ERROR_CHECK(esp_timer_create(&periodic_timer_args, &periodic_timer));
-
-    // Create a new mutex
-    xGuiSemaphore = xSemaphoreCreateMutex();
-    if (xGuiSemaphore == NULL) {
-      return LVGL_ERR_MUTEX; // failure
+  if (status != LVGL_OK) {
+    if (lv_touchscreen) {
+      lv_indev_delete(lv_touchscreen);
+      lv_touchscreen = NULL;
     }
+    if (lv_display) {
+      lv_display_delete(lv_display);
+      lv_display = NULL;
+    }
+    freeBuffers();
+  }
 
-    // Pin the LVGL gui task to core 1
-    // TODO: For ESP32-S2/C3, this will need to be pined to core 0
-
-#ifdef CONFIG_IDF_TARGET_ESP32C3
-    // For unicore ESP32-x, pin GUI task to core 0
-    if (xTaskCreatePinnedToCore(gui_task, "lvgl_gui", 1024 * 8, NULL, 5,
-                                &g_lvgl_task_handle, 0) != pdPASS)
-      return LVGL_ERR_TASK; // failure
-#else
-    // For multicore ESP32-x, pin GUI task to core 1 to allow WiFi on core 0
-    if (xTaskCreatePinnedToCore(gui_task, "lvgl_gui", 1024 * 8, NULL, 5,
-                                &g_lvgl_task_handle, 1) != pdPASS)
-      return LVGL_ERR_TASK; // failure
-#endif
-
-    // Start timer
-    ESP_ERROR_CHECK(
-        esp_timer_start_periodic(periodic_timer, lv_tick_interval_ms * 1000));
-    status = LVGL_OK;
+  return status;
+}
+// CAPTURE SINKS -----------------------------------------------------------
 
-#elif defined(NRF52_SERIES) // -----------------------------------------
+/**
+ * @brief Check the frame fits in the buffer
+ *
+ * @param width Frame width in pixels
+ * @param height Frame height in pixels
+ * @return true The frame fits
+ * @return false The buffer is too small
+ */
+bool LvGLCaptureRAM::begin(uint16_t width, uint16_t height) {
+  this->width = width;
+  return buffer && ((size_t)width * height * sizeof(uint16_t) <= size);
+}
 
-  TIMER_ID->TASKS_STOP = 1;               // Stop timer
-  TIMER_ID->MODE = TIMER_MODE_MODE_Timer; // Not counter mode
-  TIMER_ID->TASKS_CLEAR = 1;
-  TIMER_ID->BITMODE = TIMER_BITMODE_BITMODE_16Bit << TIMER_BITMODE_BITMODE_Pos;
-  TIMER_ID->PRESCALER = 0; // 1:1 prescale (16 MHz)
-  TIMER_ID->INTENSET = TIMER_INTENSET_COMPARE0_Enabled
-                       << TIMER_INTENSET_COMPARE0_Pos; // Event 0 int
-  TIMER_ID->CC[0] = TIMER_FREQ / (lv_tick_interval_ms * 1000);
+/**
+ * @brief Copy an area into place in the buffer
+ *
+ * @param area Frame coordinates of the area, inclusive
+ * @param pixels The area's top left pixel
+ * @param stride Distance between rows of the area, in pixels
+ * @return true Always
+ */
+bool LvGLCaptureRAM::write(const lv_area_t *area, const uint16_t *pixels,
+                           uint32_t stride) {
+  uint32_t w = lv_area_get_width(area);
+  uint16_t *dest = buffer + area->y1 * width + area->x1;
+  for (int32_t y = area->y1; y <= area->y2; y++) {
+    memcpy(dest, pixels, w * sizeof(uint16_t));
+    dest += width;
+    pixels += stride;
+  }
+  return true;
+}
 
-  NVIC_DisableIRQ(TIMER_IRQN);
-  NVIC_ClearPendingIRQ(TIMER_IRQN);
-  NVIC_SetPriority(TIMER_IRQN, 2); // Lower priority than soft device
-  NVIC_EnableIRQ(TIMER_IRQN);
+/**
+ * @brief Destroy the LvGLCaptureFile object, closing the file if a capture
+ * was cut short
+ *
+ */
+LvGLCaptureFile::~LvGLCaptureFile(void) {
+  if (is_open) {
+    lv_fs_close(&file);
+  }
+}
 
-  TIMER_ID->TASKS_START = 1; // Start timer
+/**
+ * @brief Create the file and write the image header
+ *
+ * @param width Frame width in pixels
+ * @param height Frame height in pixels
+ * @return true Ready for the frame
+ * @return false Couldn't create or write the file
+ */
+bool LvGLCaptureFile::begin(uint16_t width, uint16_t height) {
+  if (is_open) {
+    lv_fs_close(&file);
+  }
+  is_open = (lv_fs_open(&file, path, LV_FS_MODE_WR) == LV_FS_RES_OK);
+  if (!is_open) {
+    return false;
+  }
+  lv_image_header_t header;
+  memset(&header, 0, sizeof(header));
+  header.magic = LV_IMAGE_HEADER_MAGIC;
+  header.cf = LV_COLOR_FORMAT_RGB565;
+  header.w = width;
+  header.h = height;
+  header.stride = width * sizeof(uint16_t);
+  this->width = width;
+  uint32_t bw;
+  length = 0;
+  if ((lv_fs_write(&file, &header, sizeof(header), &bw) != LV_FS_RES_OK) ||
+      (bw != sizeof(header))) {
+    return false;
+  }
+  length = sizeof(header);
+  return true;
+}
 
-  status = LVGL_OK;
+/**
+ * @brief Write an area's rows into place in the file. Full-width areas
+ * are one write; narrower ones are written row by row.
+ *
+ * @param area Frame coordinates of the area, inclusive
+ * @param pixels The area's top left pixel
+ * @param stride Distance between rows of the area, in pixels
+ * @return true Area written
+ * @return false Write failed
+ */
+bool LvGLCaptureFile::write(const lv_area_t *area, const uint16_t *pixels,
+                            uint32_t stride) {
+  uint32_t row_bytes = width * sizeof(uint16_t);
+  uint32_t bytes = lv_area_get_width(area) * sizeof(uint16_t);
+  uint32_t rows = lv_area_get_height(area);
+  if ((bytes == row_bytes) && (stride == width)) {
+    bytes *= rows; // Contiguous in the file and in memory
+    rows = 1;
+  }
+  uint32_t at = sizeof(lv_image_header_t) + area->y1 * row_bytes +
+                area->x1 * sizeof(uint16_t);
+  uint32_t bw;
+  for (; rows; rows--, at += row_bytes, pixels += stride) {
+    if (!fill(at) || (lv_fs_seek(&file, at, LV_FS_SEEK_SET) != LV_FS_RES_OK) ||
+        (lv_fs_write(&file, pixels, bytes, &bw) != LV_FS_RES_OK) ||
+        (bw != bytes)) {
+      return false;
+    }
+    length = max(length, at + bytes);
+  }
+  return true;
+}
 
-#endif // end timer setup --------------------------------------------------
+// Most drives can't seek past the end of a file; fills any gap between
+// the end and 'to' with black
+bool LvGLCaptureFile::fill(uint32_t to) {
+  static const uint16_t black[32] = {0};
+  if ((length < to) &&
+      (lv_fs_seek(&file, length, LV_FS_SEEK_SET) != LV_FS_RES_OK)) {
+    return false;
   }
+  while (length < to) {
+    uint32_t n = min(to - length, (uint32_t)sizeof(black)), bw;
+    if ((lv_fs_write(&file, black, n, &bw) != LV_FS_RES_OK) || (bw != n)) {
+      return false;
+    }
+    length += n;
+  }
+  return true;
+}
 
-  if (status != LVGL_OK) {
-    lv_pixel_buf.clear();
-#if defined(ARDUINO_ARCH_SAMD)
-    delete zerotimer;
-    zerotimer = NULL;
-#endif
+/**
+ * @brief Close the file
+ *
+ * @return true The file was closed cleanly
+ * @return false The drive reported an error, e.g. flushing buffered data
+ */
+bool LvGLCaptureFile::end(void) {
+  if (!is_open) {
+    return false;
   }
+  is_open = false;
+  return lv_fs_close(&file) == LV_FS_RES_OK;
+}
 
-  return status;
-}
\ No newline at end of file
+/**
+ * @brief Start a new hash
+ *
+ * @param width Frame width in pixels
+ * @param height Frame height in pixels
+ * @return true Always
+ */
+bool LvGLCaptureHash::begin(uint16_t width, uint16_t height) {
+  (void)height;
+  this->width = width;
+  hash = 2166136261UL; // FNV-1a
+  next_row = 0;
+  return true;
+}
+
+/**
+ * @brief Add an area's pixels to the hash
+ *
+ * @param area Frame coordinates of the area, inclusive
+ * @param pixels The area's top left pixel
+ * @param stride Distance between rows of the area, in pixels
+ * @return true Area hashed
+ * @return false The area isn't the full-width band of rows that comes next
+ */
+bool LvGLCaptureHash::write(const lv_area_t *area, const uint16_t *pixels,
+                            uint32_t stride) {
+  if ((area->x1 != 0) || (lv_area_get_width(area) != width) ||
+      (area->y1 != next_row)) {
+    return false;
+  }
+  for (int32_t y = area->y1; y <= area->y2; y++, pixels += stride) {
+    for (uint32_t x = 0; x < width; x++) {
+      hash = (hash ^ pixels[x]) * 16777619UL;
+    }
+  }
+  next_row = area->y2 + 1;
+  return true;
+}
@@ -4,21 +4,392 @@
 #include <Adafruit_SPITFT.h>   // GFX lib for SPI and parallel displays
 #include <Adafruit_STMPE610.h> // SPI Touchscreen lib
 #include <TouchScreen.h>       // ADC touchscreen lib
+#include <atomic>
 #include <lvgl.h>              // LittlevGL core lib
-#if defined(ARDUINO_ARCH_SAMD)
-#include <Adafruit_ZeroTimer.h> // SAMD-specific timer lib
-#elif defined(ESP32)
-#include <Ticker.h> // ESP32-specific timer lib
-#endif
 
 typedef enum {
   LVGL_OK,
   LVGL_ERR_ALLOC,
   LVGL_ERR_TIMER,
   LVGL_ERR_MUTEX,
-  LVGL_ERR_TASK
+  LVGL_ERR_TASK,
+  LVGL_ERR_CONFIG,
+  LVGL_ERR_FORMAT
 } LvGLStatus;
 
+#define LVGL_FLUSH_HIST_BUCKETS 16 ///< Size of LvGLFlushStats::latency_hist
+
+/**
+ * @brief Running totals kept by the flush path, for measuring how settings
+ * such as buffer size or refresh period affect display bus traffic.
+ * Zero the glue's `flush_stats` member to restart counting.
+ *
+ */
+typedef struct {
+  uint32_t flushes;      ///< Number of areas handed over by LvGL
+  uint32_t transactions; ///< startWrite()/endWrite() pairs issued
+  uint32_t addr_windows; ///< setAddrWindow() commands issued
+  uint32_t windows_saved; ///< Areas that continued the previous address
+                          ///< window, so needed no setAddrWindow()
+  uint32_t tiles_sent;    ///< Frame-diff tiles that had changed
+  uint32_t tiles_skipped; ///< Frame-diff tiles already on screen, not sent
+  uint32_t pixels;       ///< Pixels sent to the display
+  uint32_t bytes;        ///< Bytes of pixel data sent to the display
+  uint32_t flush_us;     ///< Total time spent flushing, in microseconds
+  uint32_t latency_hist[LVGL_FLUSH_HIST_BUCKETS]; ///< Flush count by duration,
+                                                  ///< bucket n is < 2^n us
+  uint32_t start_us; ///< micros() when the flush in progress was started
+} LvGLFlushStats;
+
+/**
+ * @brief Devices that share the display's SPI bus, see claimBus()
+ *
+ */
+typedef enum {
+  LVGL_BUS_TOUCH,  ///< STMPE610 touch controller
+  LVGL_BUS_SD,     ///< SD card (Adafruit_LvGL_Glue_SD)
+  LVGL_BUS_CLIENTS ///< Number of clients
+} LvGLBusClient;
+
+/**
+ * @brief Running totals of how other devices got at the display's shared
+ * SPI bus. Zero the glue's `bus_stats` member to restart counting.
+ *
+ */
+typedef struct {
+  uint32_t claims[LVGL_BUS_CLIENTS]; ///< Times each client got the bus
+  uint32_t waited[LVGL_BUS_CLIENTS]; ///< Claims that had to wait for a DMA
+                                     ///< transfer to the display
+  uint32_t deferred; ///< Touch polls put off until a transfer ended
+  uint32_t wait_hist[LVGL_BUS_CLIENTS]
+                    [LVGL_FLUSH_HIST_BUCKETS]; ///< Claim count by wait,
+                                               ///< bucket n is < 2^n us
+} LvGLBusStats;
+
+/**
+ * @brief Running totals kept by the ESP32 GUI task, for sizing and tuning
+ * it alongside other tasks such as WiFi. See getTaskStats().
+ *
+ */
+typedef struct {
+  uint32_t runs;        ///< Times lv_task_handler() was called
+  uint32_t handler_us;  ///< Total time inside lv_task_handler(), in
+                        ///< microseconds
+  uint32_t handler_max_us; ///< Longest single lv_task_handler() call
+  uint32_t lock_wait_us;   ///< Total time spent waiting for the LvGL lock
+                           ///< (held by other tasks' lvgl_acquire())
+  uint32_t lock_wait_max_us; ///< Longest single wait for the lock
+  uint32_t missed; ///< Runs that started later than LvGL's deadline (more
+                   ///< than an RTOS tick), e.g. starved by other tasks
+  uint32_t stack_free; ///< Least free stack the task has had, in bytes
+} LvGLTaskStats;
+
+#define LVGL_TOUCH_RING 16 ///< Touch samples held for LvGL, a power of 2
+
+/**
+ * @brief One touchscreen reading queued for LvGL, see pollTouch()
+ *
+ */
+typedef struct {
+  lv_coord_t x; ///< X coordinate, in LvGL's orientation
+  lv_coord_t y; ///< Y coordinate
+  bool pressed; ///< Touched; if not, x and y are the last point touched
+} LvGLTouchSample;
+
+#define LVGL_TOUCH_CAL_MAGIC 0x4C414354 ///< "TCAL", marks a valid profile
+
+/**
+ * @brief Touchscreen calibration profile: an affine transform from raw
+ * touchscreen readings to pixels of the panel in its native orientation
+ * (GFX rotation 0), in 16.16 fixed point. Plain data, so it can be kept
+ * in EEPROM, NVS or a file as it is; see calibrateTouch().
+ *
+ */
+typedef struct {
+  uint32_t magic;    ///< LVGL_TOUCH_CAL_MAGIC
+  uint16_t width;    ///< Native width of the panel it was made for
+  uint16_t height;   ///< Native height of the panel it was made for
+  int32_t matrix[6]; ///< x = (m0 * raw x + m1 * raw y + m2) / 65536,
+                     ///< y = (m3 * raw x + m4 * raw y + m5) / 65536
+} LvGLTouchCalibration;
+
+#define LVGL_TOUCH_MEDIAN_MAX 5 ///< Longest LvGLConfig::touch_median window
+
+/**
+ * @brief Touch filter settings and state. Each reading costs the same
+ * fixed amount of work, with no memory allocated.
+ *
+ */
+typedef struct {
+  uint8_t median;        ///< Copy of LvGLConfig::touch_median
+  uint8_t smooth;        ///< Copy of LvGLConfig::touch_smooth
+  uint8_t press_count;   ///< Copy of LvGLConfig::touch_press_count
+  uint8_t release_count; ///< Copy of LvGLConfig::touch_release_count
+  uint8_t touched;       ///< Successive touched readings, up to press_count
+  uint8_t hist_len;      ///< Readings in hist_x/hist_y for this touch
+  uint8_t hist_next;     ///< Slot for the next reading in hist_x/hist_y
+  lv_coord_t hist_x[LVGL_TOUCH_MEDIAN_MAX]; ///< Latest X readings
+  lv_coord_t hist_y[LVGL_TOUCH_MEDIAN_MAX]; ///< Latest Y readings
+  int32_t ema_x; ///< Smoothed X, 8 fraction bits
+  int32_t ema_y; ///< Smoothed Y, 8 fraction bits
+  lv_coord_t ref_x; ///< Point at the latest velocity update
+  lv_coord_t ref_y; ///< Point at the latest velocity update
+  uint32_t ref_ms;  ///< millis() at the latest velocity update
+  int32_t vx; ///< X velocity in pixels per second; kept after a release
+  int32_t vy; ///< Y velocity in pixels per second; kept after a release
+} LvGLTouchFilter;
+
+#ifdef _SAMD21_
+#define LVGL_COMMAND_QUEUE 0 ///< No command queue on SAMD21: short of RAM,
+                             ///< and no atomic compare-and-swap on Cortex-M0
+#else
+#define LVGL_COMMAND_QUEUE 32 ///< Widget updates that can wait to be applied
+                              ///< by the GUI task, a power of 2
+#endif
+#define LVGL_COMMAND_TEXT 32 ///< Longest postText() string, with its NUL
+
+/**
+ * @brief How LvGL draw buffers are laid out, see LvGLConfig
+ *
+ */
+typedef enum {
+  LVGL_BUFFER_AUTO,      ///< DOUBLE if the display uses DMA, else SINGLE
+  LVGL_BUFFER_SINGLE,    ///< One band of rows, rendered and sent in turn
+  LVGL_BUFFER_DOUBLE,    ///< Two bands, one rendered while the other is sent
+  LVGL_BUFFER_FULL_FRAME ///< Whole-screen buffer (two if RAM allows), only
+                         ///< changed areas are sent
+} LvGLBufferMode;
+
+/**
+ * @brief Core to run the ESP32 GUI task on, see LvGLConfig
+ *
+ */
+typedef enum {
+  LVGL_CORE_AUTO, ///< Core 1, leaving core 0 to WiFi; core 0 on single-core
+                  ///< chips (S2, C3...)
+  LVGL_CORE_0,    ///< Pinned to core 0
+  LVGL_CORE_1,    ///< Pinned to core 1
+  LVGL_CORE_ANY   ///< Not pinned, runs on whichever core is free
+} LvGLCore;
+
+/**
+ * @brief Optional settings for begin(). Start from a zeroed struct (e.g.
+ * `LvGLConfig config = {};`); any field left at zero keeps its default.
+ *
+ */
+typedef struct {
+  LvGLBufferMode buffer_mode; ///< Buffer layout, default LVGL_BUFFER_AUTO
+  uint16_t buffer_rows;  ///< Rows per (non-full-frame) buffer, default 8, or
+                         ///< 4 on SAMD21
+  uint32_t buffer_bytes; ///< Bytes per (non-full-frame) buffer, overrides
+                         ///< buffer_rows if set
+  void *buffer; ///< Memory to use for the buffer(s) instead of allocating it,
+                ///< e.g. PSRAM, DMA-capable SRAM or a static array. With
+                ///< LVGL_BUFFER_DOUBLE it must hold two buffers, or begin()
+                ///< fails with LVGL_ERR_ALLOC.
+  size_t buffer_size; ///< Size of buffer in bytes. If neither buffer_rows nor
+                      ///< buffer_bytes is set, all of it is used.
+  uint16_t window_cost; ///< Bus time of a setAddrWindow() command, counted in
+                        ///< pixels. Invalidated areas are widened to full
+                        ///< rows when the extra pixels cost less than this,
+                        ///< so that stacked areas flush as one window.
+                        ///< Default 0 (never widen).
+  uint8_t diff_tile; ///< Enables frame-diff flush suppression: the screen is
+                     ///< split into square tiles this many pixels wide, and
+                     ///< tiles whose content hasn't changed aren't sent.
+                     ///< Uses 4 bytes of RAM per tile (1.2 KB for 320x240
+                     ///< with 16 pixel tiles). buffer_rows must be at least
+                     ///< this. Default 0 (off).
+  uint8_t rotation; ///< Quarter turns (1-3, same sense as GFX setRotation())
+                    ///< applied by the glue on top of the display's own
+                    ///< rotation. LvGL renders at the rotated size and the
+                    ///< glue turns each area back to the panel's
+                    ///< orientation, so the panel can stay at the rotation
+                    ///< it writes fastest in. Needs a scratch buffer the
+                    ///< size of one draw buffer; not available with
+                    ///< LVGL_BUFFER_FULL_FRAME. Default 0 (none).
+  uint16_t sd_read_ahead; ///< Adafruit_LvGL_Glue_SD only: bytes of read-ahead
+                          ///< cache per open file, rounded up to whole 512
+                          ///< byte sectors. Default 512.
+  uint32_t sd_cache_bytes; ///< Adafruit_LvGL_Glue_SD only: RAM (PSRAM if
+                           ///< available) for keeping whole files read from
+                           ///< the card, so images that are drawn again are
+                           ///< read from RAM. Default 0 (off).
+  const char *sd_bundle; ///< Adafruit_LvGL_Glue_SD only: path of an asset
+                         ///< pack (see extras/lvpack.py) on the card. Its
+                         ///< index is loaded at begin() and S: paths found
+                         ///< in it are opened without any FAT lookup.
+                         ///< Default NULL (none).
+  uint32_t sd_stream_bytes; ///< Adafruit_LvGL_Glue_SD only: RGB565 .bin
+                            ///< images on the card (raw or RLE-compressed)
+                            ///< bigger than this, decoded, are streamed: a
+                            ///< band of sd_stream_rows rows is decoded at a
+                            ///< time as LvGL draws them, instead of the
+                            ///< whole image into LvGL's heap. Default 8192.
+  uint8_t sd_stream_rows;   ///< Adafruit_LvGL_Glue_SD only: rows per band
+                            ///< of a streamed image. Default 8.
+  uint8_t sd_handles; ///< Adafruit_LvGL_Glue_SD only: files that can be open
+                      ///< at once. Handles and their read-ahead caches are
+                      ///< allocated at begin(), so opening a file never
+                      ///< allocates memory; an open beyond this fails.
+                      ///< Default 4.
+  bool sd_keep_open;  ///< Adafruit_LvGL_Glue_SD only: keep files open after
+                      ///< LvGL closes them, while their handles aren't
+                      ///< needed, so opening one again skips the card's
+                      ///< FAT lookup. Default false.
+  uint8_t touch_poll_ms; ///< Sample the touchscreen this often, in ms, into
+                         ///< a ring that LvGL's touch read then just
+                         ///< drains, so touch I/O never holds up LvGL. A
+                         ///< task does the sampling on ESP32; elsewhere,
+                         ///< call pollTouch() from loop(). Default 0 (LvGL
+                         ///< reads the touchscreen itself, every
+                         ///< LV_INDEV_DEF_READ_PERIOD ms).
+  const LvGLTouchCalibration *touch_calibration; ///< Touchscreen calibration
+                                                 ///< profile to use, e.g.
+                                                 ///< one saved from
+                                                 ///< calibrateTouch().
+                                                 ///< Default NULL (built-in
+                                                 ///< for the touchscreen).
+  uint8_t touch_median; ///< Touch points are the median of this many
+                        ///< readings (up to LVGL_TOUCH_MEDIAN_MAX), which
+                        ///< throws out lone wild readings. Default 1 (off).
+  uint8_t touch_smooth; ///< Exponential smoothing of touch points, 0-255:
+                        ///< each reading moves the point (256 - this)/256
+                        ///< of the way to itself. Default 0 (off).
+  uint8_t touch_press_count;   ///< Touched readings in a row that make a
+                               ///< press. Default 1.
+  uint8_t touch_release_count; ///< Untouched readings in a row that make a
+                               ///< release. Default 4 for ADC touchscreens,
+                               ///< 1 for STMPE610 (2 on nRF52).
+  LvGLCore gui_core;    ///< ESP32 only: core for the GUI task. Default
+                        ///< LVGL_CORE_AUTO.
+  uint8_t gui_priority; ///< ESP32 only: FreeRTOS priority of the GUI task.
+                        ///< Default 5.
+  uint32_t gui_stack_bytes; ///< ESP32 only: stack size of the GUI task, see
+                            ///< LvGLTaskStats::stack_free. Default 8192.
+                            ///< The GUI task is shared, so the gui_ settings
+                            ///< of the first begin() are the ones used.
+  uint8_t touch_priority; ///< ESP32 only: FreeRTOS priority of the task
+                          ///< sampling the touchscreen, see touch_poll_ms.
+                          ///< Default 5.
+  uint32_t touch_stack_bytes; ///< ESP32 only: stack size of that task.
+                              ///< Default 4096.
+} LvGLConfig;
+
+/**
+ * @brief Receives a frame from Adafruit_LvGL_Glue::captureFrame(), one
+ * flushed area at a time, as the areas are sent to the display. Pixels are
+ * RGB565 in LvGL's own byte order and orientation (before any glue
+ * rotation). Derive from this for other destinations, e.g. a serial port.
+ *
+ */
+class LvGLCaptureSink {
+public:
+  virtual ~LvGLCaptureSink(void) {}
+  /**
+   * @brief Called before the frame's first area
+   *
+   * @param width Frame width in pixels
+   * @param height Frame height in pixels
+   * @return true Ready for the frame
+   * @return false Can't take it; captureFrame() gives up
+   */
+  virtual bool begin(uint16_t width, uint16_t height) = 0;
+  /**
+   * @brief Called for each area of the frame. Areas don't overlap, and
+   * come from top to bottom.
+   *
+   * @param area Frame coordinates of the area, inclusive
+   * @param pixels The area's top left pixel
+   * @param stride Distance between rows of the area, in pixels
+   * @return true Area stored
+   * @return false Failed; no more areas are passed on
+   */
+  virtual bool write(const lv_area_t *area, const uint16_t *pixels,
+                     uint32_t stride) = 0;
+  /**
+   * @brief Called after the frame's last area, or after a failure
+   *
+   * @return true The frame is complete
+   * @return false Failed to finish it
+   */
+  virtual bool end(void) { return true; }
+};
+
+/**
+ * @brief Capture sink that copies the frame into a RAM buffer, row after
+ * row with no padding. The buffer needs width x height x 2 bytes, so this
+ * is mostly for boards with PSRAM.
+ *
+ */
+class LvGLCaptureRAM : public LvGLCaptureSink {
+public:
+  /**
+   * @brief Set up a RAM capture sink
+   *
+   * @param buffer Where to put the frame
+   * @param size Size of buffer in bytes
+   */
+  LvGLCaptureRAM(uint16_t *buffer, size_t size)
+      : buffer(buffer), size(size), width(0) {}
+  bool begin(uint16_t width, uint16_t height);
+  bool write(const lv_area_t *area, const uint16_t *pixels, uint32_t stride);
+
+private:
+  uint16_t *buffer;
+  size_t size;
+  uint16_t width;
+};
+
+/**
+ * @brief Capture sink that writes the frame to a file, through any LvGL
+ * drive (e.g. "S:shot.bin" with Adafruit_LvGL_Glue_SD). The file is an
+ * LvGL binary RGB565 image, which can be drawn again or converted on a
+ * computer. Nothing is buffered here beyond what the drive does itself.
+ *
+ */
+class LvGLCaptureFile : public LvGLCaptureSink {
+public:
+  /**
+   * @brief Set up a file capture sink
+   *
+   * @param path LvGL path of the file to write; replaced if it exists. Must
+   * stay valid until the capture is done.
+   */
+  LvGLCaptureFile(const char *path) : path(path), is_open(false) {}
+  ~LvGLCaptureFile(void);
+  bool begin(uint16_t width, uint16_t height);
+  bool write(const lv_area_t *area, const uint16_t *pixels, uint32_t stride);
+  bool end(void);
+
+private:
+  bool fill(uint32_t to);
+  const char *path;
+  lv_fs_file_t file;
+  bool is_open;
+  uint16_t width;
+  uint32_t length; // Bytes written so far, header included
+};
+
+/**
+ * @brief Capture sink that hashes the frame (32 bit FNV-1a over its pixels
+ * in row order) without storing it, for comparing what's drawn against a
+ * known-good hash in tests. Needs full-width areas, which is what
+ * captureFrame() produces.
+ *
+ */
+class LvGLCaptureHash : public LvGLCaptureSink {
+public:
+  LvGLCaptureHash(void) : hash(0), width(0), next_row(0) {}
+  bool begin(uint16_t width, uint16_t height);
+  bool write(const lv_area_t *area, const uint16_t *pixels, uint32_t stride);
+  uint32_t hash; ///< Hash of the last frame captured
+
+private:
+  uint16_t width;
+  int32_t next_row;
+};
+
 /**
  * @brief Class to act as a "glue" layer between the LvGL graphics library and
  * most of Adafruit's TFT displays
@@ -34,13 +405,107 @@ public:
   LvGLStatus begin(Adafruit_SPITFT *tft, TouchScreen *touch,
                    bool debug = false);
   LvGLStatus begin(Adafruit_SPITFT *tft, bool debug = false);
+  // Same, with draw buffer settings
+  LvGLStatus begin(Adafruit_SPITFT *tft, Adafruit_STMPE610 *touch,
+                   const LvGLConfig &config, bool debug = false);
+  LvGLStatus begin(Adafruit_SPITFT *tft, TouchScreen *touch,
+                   const LvGLConfig &config, bool debug = false);
+  LvGLStatus begin(Adafruit_SPITFT *tft, const LvGLConfig &config,
+                   bool debug = false);
+  lv_display_t *getLvDisplay(void) { return lv_display; } ///< LvGL display
+                                                          ///< for this glue
+  bool captureFrame(LvGLCaptureSink &sink);
+  void pollTouch(void);
+  bool calibrateTouch(uint32_t timeout_ms = 10000);
+  bool setTouchCalibration(const LvGLTouchCalibration &cal);
+  /**
+   * @brief The touchscreen calibration profile in use
+   *
+   * @return const LvGLTouchCalibration& The profile, e.g. for saving
+   */
+  const LvGLTouchCalibration &getTouchCalibration(void) { return touch_cal; }
+  bool saveTouchCalibration(const char *path);
+  /**
+   * @brief Velocity of the current touch, from the filtered points. After
+   * a release it is the velocity the touch was released at, e.g. for
+   * flinging things.
+   *
+   * @param vx Set to the X velocity, in pixels per second
+   * @param vy Set to the Y velocity, in pixels per second
+   */
+  void getTouchVelocity(int32_t *vx, int32_t *vy) {
+    *vx = touch_filter.vx;
+    *vy = touch_filter.vy;
+  }
+  bool loadTouchCalibration(const char *path);
+#ifdef ESP32
+  void getTaskStats(LvGLTaskStats *stats, bool reset = false);
+#endif
+#if LVGL_COMMAND_QUEUE
+  static bool postText(lv_obj_t *obj, const char *text);
+  static bool postValue(lv_obj_t *obj, int32_t value);
+  static bool postInvalidate(lv_obj_t *obj);
+#endif
   // These items need to be public for some internal callbacks,
   // but should be avoided by user code please!
   Adafruit_SPITFT *display; ///< Pointer to the SPITFT display instance
   void *touchscreen;        ///< Pointer to the touchscreen object to use
   bool is_adc_touch; ///< determines if the touchscreen controlelr is ADC based
-  bool first_frame;  ///< Tracks if a call to `lv_flush_callback` needs to wait
-                     ///< for DMA transfer to complete
+  lv_coord_t touch_x;    ///< Last touched X coordinate
+  lv_coord_t touch_y;    ///< Last touched Y coordinate
+  uint8_t release_count; ///< Successive no-touch readings
+  LvGLTouchFilter touch_filter; ///< Touch filter settings and state
+  bool touch_pressed;    ///< Latest reading was a touch
+  bool touch_more;       ///< More points wait in the STMPE610 FIFO
+  bool touch_pending; ///< STMPE610 poll put off until the DMA transfer ends
+  bool touch_fresh;   ///< STMPE610 read at the end of a transfer, for LvGL's
+                      ///< next poll
+  uint8_t touch_deferred;    ///< Successive STMPE610 polls put off
+  uint32_t touch_request_us; ///< micros() when the first of those was
+  uint8_t touch_poll_ms;     ///< Copy of LvGLConfig::touch_poll_ms
+  uint32_t touch_poll_last;  ///< millis() of pollTouch()'s latest sample
+#ifdef ESP32
+  SemaphoreHandle_t touch_lock; ///< Held by the touch task while it samples
+                                ///< an ADC touchscreen, or NULL
+#endif
+  LvGLTouchSample touch_ring[LVGL_TOUCH_RING]; ///< Samples waiting for LvGL
+  std::atomic<uint8_t> touch_head; ///< Samples queued; written only by the
+                                   ///< sampling side
+  std::atomic<uint8_t> touch_tail; ///< Samples taken; written only by LvGL's
+                                   ///< touch read
+  LvGLTouchSample touch_sample; ///< Latest sample handed to LvGL
+  bool touch_queued_pressed;    ///< Latest sample queued was a touch
+  uint32_t touch_dropped;       ///< Samples lost to a full ring
+  LvGLTouchCalibration touch_cal; ///< Touchscreen calibration in use
+  int32_t touch_matrix[6]; ///< touch_cal turned to LvGL's orientation
+  uint8_t touch_matrix_rotation; ///< GFX rotation touch_matrix was made for
+  bool dma_busy;     ///< True while a DMA flush is in flight and LvGL has not
+                     ///< yet been told the buffer is free again
+  void waitForFlush(void); ///< Finish any in-flight DMA flush, free the bus
+  void finishFlush(void);  ///< Finish any in-flight DMA flush, keep the bus
+  void claimBus(LvGLBusClient client); ///< Take the shared bus from the
+                                       ///< display, see LvGLBusClient
+  LvGLBusStats bus_stats; ///< Shared bus counters, see LvGLBusStats
+  bool in_transaction; ///< True while the display's SPI transaction is open
+  bool flush_last;     ///< True if the latest flush ended an LvGL refresh
+  lv_area_t flush_window; ///< Columns of the display's current address
+                          ///< window (x1, x2) and the next row it expects (y1)
+  uint16_t window_cost;   ///< Copy of LvGLConfig::window_cost
+  uint32_t *tile_hash; ///< Frame-diff hash of each tile on screen, 0 if unknown
+  uint8_t tile_size;   ///< Frame-diff tile width and height in pixels
+  uint16_t tiles_x;    ///< Frame-diff tile columns
+  uint16_t tiles_y;    ///< Frame-diff tile rows
+  void resetTileHashes(void); ///< Forget frame-diff state, resend everything
+  static void swapPixels(uint16_t *dest, const uint16_t *src,
+                         uint32_t len); ///< RGB565 byte order swap
+  LvGLFlushStats flush_stats; ///< Flush path counters, see LvGLFlushStats
+  bool direct_mode; ///< True if LvGL draws into a full-frame buffer in place
+  uint8_t buffer_count; ///< Draw buffers in use, 1 or 2. FULL_FRAME and AUTO
+                        ///< settle for one if there's no room for two.
+  uint8_t rotation;     ///< Copy of LvGLConfig::rotation, 0-3
+  uint16_t *rotate_buf; ///< Scratch buffer for rotated pixels, or NULL
+  LvGLCaptureSink *capture; ///< Sink being fed by captureFrame(), or NULL
+  bool capture_ok;          ///< False once the capture sink has failed
 
 #ifdef ESP32
   void lvgl_acquire(); ///< Acquires the lock around the lvgl object
@@ -48,16 +513,65 @@ public:
 #endif
 
 private:
-  LvGLStatus begin(Adafruit_SPITFT *tft, void *touch, bool debug);
+  LvGLStatus begin(Adafruit_SPITFT *tft, void *touch, const LvGLConfig &config,
+                   bool debug);
+  LvGLStatus initBuffers(const LvGLConfig &config);
+  void freeBuffers(void);
   lv_display_t *lv_display;
   lv_indev_t *lv_touchscreen;
-  std::vector<uint16_t> lv_pixel_buf{};
+#ifdef ESP32
+  TaskHandle_t touch_task; // Samples the touchscreen, see touch_poll_ms
+#endif
+  uint16_t *lv_pixel_buf;
+  bool lv_pixel_buf_owned;
 
-#if defined(ARDUINO_ARCH_SAMD)
-  Adafruit_ZeroTimer *zerotimer;
-#elif defined(ESP32)
-  Ticker tick;
-#elif defined(NRF52_SERIES)
+};
+
+/**
+ * @brief Holds the LvGL lock for as long as it's in scope, for calling LvGL
+ * directly from another task on ESP32. Widget updates that can wait a
+ * frame are better posted (postText() etc.), which never blocks the GUI
+ * task. Does nothing on other boards.
+ *
+ * ```
+ * {
+ *   LvGLLock lock(glue);
+ *   lv_obj_set_style_bg_color(panel, color, 0);
+ * }
+ * ```
+ */
+class LvGLLock {
+public:
+  /**
+   * @brief Take the LvGL lock, waiting for the GUI task's frame if need be
+   *
+   * @param glue Any started glue object (the lock is shared)
+   */
+  LvGLLock(Adafruit_LvGL_Glue &glue)
+#ifdef ESP32
+      : glue(glue) {
+    glue.lvgl_acquire();
+  }
+#else
+  {
+    (void)glue; // No lock without a GUI task
+  }
+#endif
+  /**
+   * @brief Release the LvGL lock
+   *
+   */
+  ~LvGLLock(void) {
+#ifdef ESP32
+    glue.lvgl_release();
+#endif
+  }
+  LvGLLock(const LvGLLock &) = delete;
+  LvGLLock &operator=(const LvGLLock &) = delete;
+
+#ifdef ESP32
+private:
+  Adafruit_LvGL_Glue &glue;
 #endif
 };
 
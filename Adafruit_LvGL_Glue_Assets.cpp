@@ -0,0 +1,337 @@
+#include "Adafruit_LvGL_Glue_Assets.h"
+#include <new>
+#if defined(ESP32)
+#include <esp_idf_version.h>
+#include <esp_partition.h>
+#if ESP_IDF_VERSION_MAJOR < 5
+#include <esp_spi_flash.h>
+#endif
+#endif
+
+// Open file handle on an asset. Reads are plain copies out of the pack.
+struct asset_fp_ {
+  const uint8_t *data;
+  uint32_t size;
+  uint32_t pos;
+};
+
+// Callback functions to support reading assets as files
+static void *asset_open(lv_fs_drv_t *drv, const char *path,
+                        lv_fs_mode_t mode) {
+  Adafruit_LvGL_Assets *assets = (Adafruit_LvGL_Assets *)drv->user_data;
+
+  // Assets are read only
+  if (mode != LV_FS_MODE_RD) {
+    return NULL;
+  }
+
+  uint32_t size;
+  const uint8_t *data = assets->find(path, &size);
+  if (!data) {
+    LV_LOG_WARN("No asset %s", path);
+    return NULL;
+  }
+  return new (std::nothrow) asset_fp_{data, size, 0};
+}
+
+static lv_fs_res_t asset_read(lv_fs_drv_t *drv, void *file_p, void *buf,
+                              uint32_t btr, uint32_t *br) {
+  asset_fp_ *fp = (asset_fp_ *)file_p;
+  *br = (fp->pos < fp->size) ? min(btr, fp->size - fp->pos) : 0;
+  memcpy(buf, fp->data + fp->pos, *br);
+  fp->pos += *br;
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t asset_close(lv_fs_drv_t *drv, void *file_p) {
+  delete (asset_fp_ *)file_p;
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t asset_seek(lv_fs_drv_t *drv, void *file_p, uint32_t pos,
+                              lv_fs_whence_t whence) {
+  asset_fp_ *fp = (asset_fp_ *)file_p;
+  switch (whence) {
+  case LV_FS_SEEK_SET:
+    fp->pos = pos;
+    break;
+  case LV_FS_SEEK_CUR:
+    fp->pos += pos;
+    break;
+  case LV_FS_SEEK_END:
+    fp->pos = fp->size + pos;
+    break;
+  }
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t asset_tell(lv_fs_drv_t *drv, void *file_p,
+                              uint32_t *pos_p) {
+  *pos_p = ((asset_fp_ *)file_p)->pos;
+  return LV_FS_RES_OK;
+}
+
+/**
+ * @brief Construct a new Adafruit_LvGL_Assets object
+ *
+ */
+Adafruit_LvGL_Assets::Adafruit_LvGL_Assets(void)
+    : pack(NULL), pack_size(0), index(NULL), count(0) {
+  lv_fs_drv_init(&lv_fs_drv); // user_data is set once registered
+#if defined(ESP32)
+  mapped = false;
+#endif
+}
+
+/**
+ * @brief Destroy the Adafruit_LvGL_Assets object, unmapping the partition
+ * if begin() mapped one
+ *
+ */
+Adafruit_LvGL_Assets::~Adafruit_LvGL_Assets(void) {
+#if defined(ESP32)
+  unmap();
+#endif
+}
+
+// True if every index entry's path and data lie within the pack, so
+// lookups never need to check again
+static bool pack_valid(const uint8_t *pack, size_t size) {
+  const LvGLPackHeader *header = (const LvGLPackHeader *)pack;
+  const LvGLPackEntry *index = (const LvGLPackEntry *)(header + 1);
+  size_t names = header->names;
+  if ((names < sizeof(LvGLPackHeader) +
+                   header->count * sizeof(LvGLPackEntry)) ||
+      (names >= size)) {
+    return false; // Overlaps the index, or past the end
+  }
+  for (uint32_t i = 0; i < header->count; i++) {
+    const LvGLPackEntry *entry = &index[i];
+    if ((entry->name >= size - names) ||
+        !memchr(pack + names + entry->name, 0, size - names - entry->name) ||
+        (entry->offset > size) || (entry->size > size - entry->offset)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Serve assets from a pack already in the address space, e.g. a
+ * const array in flash made with `lvpack.py --c-array`. Nothing is copied
+ * or loaded; assets are looked up as they're used. Call after the glue's
+ * begin(), which starts LvGL. Calling it again switches to another pack.
+ *
+ * @param pack Start of the asset pack, 4-byte aligned
+ * @param size Size of the asset pack in bytes
+ * @param letter LvGL drive letter to serve the assets as files on
+ * @return LvGLStatus The status of the initialization:
+ * * LVGL_OK : Success
+ * * LVGL_ERR_FORMAT : Not an asset pack, not aligned, or its index points
+ *   outside it
+ */
+LvGLStatus Adafruit_LvGL_Assets::begin(const void *pack, size_t size,
+                                       char letter) {
+  const LvGLPackHeader *header = (const LvGLPackHeader *)pack;
+  if (((uintptr_t)pack & 3) || (size < sizeof(LvGLPackHeader)) ||
+      (header->magic != LVGL_PACK_MAGIC) ||
+      (header->version != LVGL_PACK_VERSION) ||
+      (header->count > (size - sizeof(LvGLPackHeader)) / sizeof(LvGLPackEntry)) ||
+      !pack_valid((const uint8_t *)pack, size)) {
+    return LVGL_ERR_FORMAT;
+  }
+#if defined(ESP32)
+  unmap(); // A partition an earlier begin() mapped, if any
+#endif
+  this->pack = (const uint8_t *)pack;
+  pack_size = size;
+  index = (const LvGLPackEntry *)(header + 1);
+  count = header->count;
+
+  // LvGL keeps a pointer to the driver, so it's registered only once;
+  // a later begin() just changes it
+  lv_fs_drv.letter = letter;
+  if (!lv_fs_drv.user_data) {
+    lv_fs_drv.open_cb = asset_open;
+    lv_fs_drv.close_cb = asset_close;
+    lv_fs_drv.read_cb = asset_read;
+    lv_fs_drv.seek_cb = asset_seek;
+    lv_fs_drv.tell_cb = asset_tell;
+    lv_fs_drv.user_data = this;
+    lv_fs_drv_register(&lv_fs_drv);
+  }
+  return LVGL_OK;
+}
+
+#if defined(ESP32)
+static void partition_munmap(uint32_t handle) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_partition_munmap(handle);
+#else
+  spi_flash_munmap(handle);
+#endif
+}
+
+/**
+ * @brief Serve assets from a pack written to a flash data partition (e.g.
+ * with `esptool.py write_flash`). The partition is mapped into the address
+ * space, so assets are read straight from flash with nothing loaded at
+ * startup. Call after the glue's begin(), which starts LvGL. Calling it
+ * again unmaps the partition mapped before.
+ *
+ * @param partition Label of the data partition, from the partition table
+ * @param letter LvGL drive letter to serve the assets as files on
+ * @return LvGLStatus The status of the initialization:
+ * * LVGL_OK : Success
+ * * LVGL_ERR_CONFIG : No such partition
+ * * LVGL_ERR_ALLOC : Failure to map the partition
+ * * LVGL_ERR_FORMAT : Partition doesn't hold an asset pack
+ */
+LvGLStatus Adafruit_LvGL_Assets::begin(const char *partition, char letter) {
+  const esp_partition_t *part = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partition);
+  if (!part) {
+    return LVGL_ERR_CONFIG;
+  }
+  unmap(); // Before mapping another, so mappings don't pile up
+  const void *ptr;
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_partition_mmap_handle_t handle;
+  esp_err_t err = esp_partition_mmap(part, 0, part->size,
+                                     ESP_PARTITION_MMAP_DATA, &ptr, &handle);
+#else
+  spi_flash_mmap_handle_t handle;
+  esp_err_t err = esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA,
+                                     &ptr, &handle);
+#endif
+  if (err != ESP_OK) {
+    return LVGL_ERR_ALLOC;
+  }
+  LvGLStatus status = begin(ptr, part->size, letter);
+  if (status != LVGL_OK) {
+    partition_munmap(handle);
+    return status;
+  }
+  mmap_handle = handle;
+  mapped = true;
+  return LVGL_OK;
+}
+
+// Releases the partition mapping made by begin(), and with it the pack
+void Adafruit_LvGL_Assets::unmap(void) {
+  if (!mapped) {
+    return;
+  }
+  partition_munmap(mmap_handle);
+  mapped = false;
+  pack = NULL;
+  pack_size = 0;
+  index = NULL;
+  count = 0;
+}
+#endif
+
+/**
+ * @brief FNV-1a hash of an asset path, as used in the pack index. A
+ * leading '/' is ignored.
+ *
+ * @param path Asset path, e.g. "icons/cloudy.bin"
+ * @return uint32_t The hash
+ */
+uint32_t Adafruit_LvGL_Assets::hashPath(const char *path) {
+  uint32_t hash = 2166136261UL;
+  if (*path == '/') {
+    path++;
+  }
+  for (; *path; path++) {
+    hash = (hash ^ (uint8_t)*path) * 16777619UL;
+  }
+  return hash;
+}
+
+/**
+ * @brief Binary search a pack index for a path
+ *
+ * @param index Index entries, sorted by hash
+ * @param count Number of index entries
+ * @param names The pack's path strings
+ * @param path Asset path to look for
+ * @return const LvGLPackEntry* The matching entry, or NULL if none
+ */
+const LvGLPackEntry *Adafruit_LvGL_Assets::findEntry(const LvGLPackEntry *index,
+                                                     uint32_t count,
+                                                     const char *names,
+                                                     const char *path) {
+  uint32_t hash = hashPath(path);
+  uint32_t lo = 0, hi = count;
+  while (lo < hi) { // First entry with this hash
+    uint32_t mid = (lo + hi) / 2;
+    if (index[mid].hash < hash) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (*path == '/') {
+    path++;
+  }
+  for (; (lo < count) && (index[lo].hash == hash); lo++) {
+    if (!strcmp(names + index[lo].name, path)) {
+      return &index[lo];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Look up an asset's data in the pack. The pointer is into the pack
+ * itself (flash), valid for as long as this object.
+ *
+ * @param path Asset path, e.g. "icons/cloudy.bin"
+ * @param size If not NULL, set to the asset's size in bytes
+ * @return const uint8_t* The asset's data, or NULL if there's no such asset
+ */
+const uint8_t *Adafruit_LvGL_Assets::find(const char *path,
+                                          uint32_t *size) const {
+  if (!pack) {
+    return NULL;
+  }
+  const LvGLPackHeader *header = (const LvGLPackHeader *)pack;
+  const LvGLPackEntry *entry =
+      findEntry(index, count, (const char *)pack + header->names, path);
+  if (!entry) {
+    return NULL; // begin() checked the others lie within the pack
+  }
+  if (size) {
+    *size = entry->size;
+  }
+  return pack + entry->offset;
+}
+
+/**
+ * @brief Set up an image descriptor for an LvGL binary (.bin) image in the
+ * pack, pointing straight at its pixels in flash. Pass the descriptor to
+ * lv_image_set_src() to draw the image with no file reads or copies. The
+ * descriptor must stay valid while the image is in use.
+ *
+ * @param path Asset path of the .bin image
+ * @param dsc Image descriptor to fill in
+ * @return true Success
+ * @return false No such asset, or it isn't an LvGL binary image
+ */
+bool Adafruit_LvGL_Assets::getImage(const char *path,
+                                    lv_image_dsc_t *dsc) const {
+  uint32_t size;
+  const uint8_t *data = find(path, &size);
+  if (!data || (size < sizeof(lv_image_header_t))) {
+    return false;
+  }
+  memset(dsc, 0, sizeof(lv_image_dsc_t));
+  memcpy(&dsc->header, data, sizeof(lv_image_header_t));
+  if (dsc->header.magic != LV_IMAGE_HEADER_MAGIC) {
+    return false;
+  }
+  dsc->data = data + sizeof(lv_image_header_t);
+  dsc->data_size = size - sizeof(lv_image_header_t);
+  return true;
+}
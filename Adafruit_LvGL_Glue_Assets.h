@@ -0,0 +1,75 @@
+#ifndef _ADAFRUIT_LVGL_GLUE_ASSETS_H
+#define _ADAFRUIT_LVGL_GLUE_ASSETS_H
+
+#include "Adafruit_LvGL_Glue.h"
+
+// Asset pack format, as written by extras/lvpack.py. All fields are
+// little-endian. A pack is a header, then `count` index entries sorted by
+// path hash, then the NUL-terminated paths, then each asset's data,
+// starting on a multiple of `align` bytes from the start of the pack.
+
+#define LVGL_PACK_MAGIC 0x4B50564C ///< "LVPK"
+#define LVGL_PACK_VERSION 1        ///< Pack format version understood here
+
+/**
+ * @brief Start of an asset pack
+ *
+ */
+typedef struct {
+  uint32_t magic;   ///< LVGL_PACK_MAGIC
+  uint16_t version; ///< LVGL_PACK_VERSION
+  uint16_t align;   ///< Alignment of asset data, in bytes
+  uint32_t count;   ///< Number of assets (index entries)
+  uint32_t names;   ///< Offset of the path strings
+} LvGLPackHeader;
+
+/**
+ * @brief Asset pack index entry; the index follows the header
+ *
+ */
+typedef struct {
+  uint32_t hash;   ///< Adafruit_LvGL_Assets::hashPath() of the path
+  uint32_t name;   ///< Offset of the path from the start of the path strings
+  uint32_t offset; ///< Offset of the asset data from the start of the pack
+  uint32_t size;   ///< Size of the asset data in bytes
+} LvGLPackEntry;
+
+/**
+ * @brief Serves assets from an asset pack held in memory: internal flash
+ * (a const array), or on ESP32 a flash partition mapped into the address
+ * space. Assets are found through the pack's index without copying, and
+ * are also available to LvGL as files on their own drive letter.
+ *
+ */
+class Adafruit_LvGL_Assets {
+public:
+  Adafruit_LvGL_Assets(void);
+  ~Adafruit_LvGL_Assets(void);
+  LvGLStatus begin(const void *pack, size_t size, char letter = 'M');
+#if defined(ESP32)
+  LvGLStatus begin(const char *partition, char letter = 'M');
+#endif
+  const uint8_t *find(const char *path, uint32_t *size = NULL) const;
+  bool getImage(const char *path, lv_image_dsc_t *dsc) const;
+
+  static uint32_t hashPath(const char *path);
+  static const LvGLPackEntry *findEntry(const LvGLPackEntry *index,
+                                        uint32_t count, const char *names,
+                                        const char *path);
+
+  // The following need to be public for internal callbacks
+  const uint8_t *pack;       ///< Start of the asset pack
+  size_t pack_size;          ///< Size of the asset pack in bytes
+  const LvGLPackEntry *index; ///< The pack's index, sorted by hash
+  uint32_t count;            ///< Number of entries in index
+
+private:
+  lv_fs_drv_t lv_fs_drv;
+#if defined(ESP32)
+  void unmap(void);
+  uint32_t mmap_handle; // Partition mapping made by begin()
+  bool mapped;          // True if mmap_handle is in use
+#endif
+};
+
+#endif // _ADAFRUIT_LVGL_GLUE_ASSETS_H
@@ -1,81 +1,1044 @@
 #include "Adafruit_LvGL_Glue_SD.h"
+#include <new>
+#if __has_include(<lvgl_private.h>)
+#include <lvgl_private.h> // Image decoder internals, LvGL 9.2 and later
+#endif
 
-static void waitForDisplay(Adafruit_SPITFT *display) {
+static void waitForDisplay(Adafruit_LvGL_Glue *glue) {
   // Before accessing SD, wait on any in-progress
   // DMA screen transfer to finish (shared bus).
-  display->dmaWait();
-  display->endWrite();
+  glue->claimBus(LVGL_BUS_SD);
 }
 
+#define SD_SECTOR 512 // Read-ahead is done in whole, aligned card sectors
+#define SD_HANDLES 4  // Default LvGLConfig::sd_handles
+#define SD_HANDLE_PATH 48 // Longest path (with NUL) an idle handle can keep
+
+#if defined(ESP32) && defined(BOARD_HAS_PSRAM)
+#define file_cache_alloc ps_malloc // Keep cached files out of internal RAM
+#else
+#define file_cache_alloc malloc
+#endif
+
+// A whole file kept in RAM. LvGL's binary images are stored already
+// decoded, so this is in effect a decoded-image cache: redrawing an icon
+// that's still here doesn't touch the card at all.
+struct LvGLFileCacheEntry {
+  LvGLFileCacheEntry *next; // Next less recently used
+  uint32_t size;            // File size
+  uint16_t users;           // Handles open on it; can't be evicted if > 0
+  bool stale;               // File was written, free when users reaches 0
+  uint8_t *data;            // File contents, followed by path
+  const char *path;
+};
+
+// Open file handle. LvGL's reads are served from a cache of the sectors
+// around the read position, so the many small reads image and font
+// decoders make only reach the card (and stall the display's bus) once
+// per cache-full. Files in the file cache are read from there instead.
+// An asset in the bundle is a slice of the bundle file, starting at base.
+// For files open for writing the cache also holds data written but not
+// yet sent to the card (dirty), so small writes reach the card, and hold
+// up the display's bus, once per cache-full.
+// Handles come from a pool allocated at begin(), read-ahead caches and
+// all, so opening and closing files never touches the heap.
+enum { SD_HANDLE_FREE, SD_HANDLE_OPEN, SD_HANDLE_IDLE };
 struct fp_ {
   File32 file;
+  uint32_t pos;       // Read position as LvGL sees it
+  uint32_t cache_pos; // File offset of cache[0]
+  uint32_t cache_len; // Valid bytes in cache
+  uint8_t *cache;
+  LvGLFileCacheEntry *entry; // Cached file, or NULL to read the card
+  uint32_t base;             // File offset of the data
+  uint32_t size;             // Data size
+  bool bundled;              // file is a copy of the bundle's, keep it open
+  bool writable;             // Opened with LV_FS_MODE_WR
+  bool dirty;                // cache holds data still to be written
+  uint8_t state;             // SD_HANDLE_FREE, _OPEN or _IDLE
+  uint32_t closed;           // When an idle handle was closed by LvGL
+  char path[SD_HANDLE_PATH]; // File an idle handle still has open
 };
 
-// Callback functions to support reading images from SD cards
-static void *sd_open(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode) {
-  Adafruit_LvGL_Glue_SD *glue = (Adafruit_LvGL_Glue_SD *)drv->user_data;
-  waitForDisplay(glue->display);
+// Writes the data waiting in a handle's cache to the card. The cache then
+// stays valid for reading.
+static bool handle_flush(Adafruit_LvGL_Glue_SD *glue, fp_ *fp) {
+  if (!fp->dirty) {
+    return true;
+  }
+  waitForDisplay(glue);
+  fp->dirty = false;
+  glue->sd_stats.sd_writes++;
+  glue->sd_stats.sd_write_bytes += fp->cache_len;
+  if ((fp->file.curPosition() != fp->cache_pos) &&
+      !fp->file.seek(fp->cache_pos)) {
+    fp->cache_len = 0;
+    return false;
+  }
+  if (fp->file.write(fp->cache, fp->cache_len) != fp->cache_len) {
+    fp->cache_len = 0;
+    return false;
+  }
+  return true;
+}
+
+// Closes the file kept open by a handle, freeing it
+static void handle_drop(Adafruit_LvGL_Glue_SD *glue, fp_ *fp) {
+  handle_flush(glue, fp);
+  waitForDisplay(glue);
+  fp->file.close();
+  fp->state = SD_HANDLE_FREE;
+}
+
+// Takes a free handle from the pool, or failing that the idle handle LvGL
+// closed longest ago. NULL if all are in use.
+static fp_ *handle_get(Adafruit_LvGL_Glue_SD *glue) {
+  fp_ *handles = (fp_ *)glue->handles, *idle = NULL;
+  for (uint8_t i = 0; i < glue->handle_count; i++) {
+    if (handles[i].state == SD_HANDLE_FREE) {
+      handles[i].state = SD_HANDLE_OPEN;
+      return &handles[i];
+    }
+    if ((handles[i].state == SD_HANDLE_IDLE) &&
+        (!idle || (handles[i].closed < idle->closed))) {
+      idle = &handles[i];
+    }
+  }
+  if (idle) {
+    handle_drop(glue, idle);
+    idle->state = SD_HANDLE_OPEN;
+  }
+  return idle;
+}
 
-  // Support only reading
-  if (mode != LV_FS_MODE_RD) {
+// Sets up a handle from the pool for reading size bytes of file, from
+// offset base, or of a file cache entry
+static fp_ *handle_init(fp_ *fp, const File32 &file, LvGLFileCacheEntry *entry,
+                        uint32_t base, uint32_t size, bool bundled) {
+  fp->file = file;
+  fp->pos = 0;
+  fp->cache_pos = 0;
+  fp->cache_len = 0;
+  fp->entry = entry;
+  fp->base = base;
+  fp->size = size;
+  fp->bundled = bundled;
+  fp->writable = false;
+  fp->dirty = false;
+  fp->path[0] = 0;
+  return fp;
+}
+
+// Looks for path in the file cache, moving it to the front if found
+static LvGLFileCacheEntry *file_cache_find(Adafruit_LvGL_Glue_SD *glue,
+                                           const char *path) {
+  for (LvGLFileCacheEntry **link = &glue->file_cache; *link;
+       link = &(*link)->next) {
+    LvGLFileCacheEntry *entry = *link;
+    if (!strcmp(entry->path, path)) {
+      *link = entry->next;
+      entry->next = glue->file_cache;
+      glue->file_cache = entry;
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+// Drops the least recently used file no one has open. False if none.
+static bool file_cache_evict(Adafruit_LvGL_Glue_SD *glue) {
+  LvGLFileCacheEntry **victim = NULL;
+  for (LvGLFileCacheEntry **link = &glue->file_cache; *link;
+       link = &(*link)->next) {
+    if (!(*link)->users) {
+      victim = link;
+    }
+  }
+  if (!victim) {
+    return false;
+  }
+  LvGLFileCacheEntry *entry = *victim;
+  *victim = entry->next;
+  glue->sd_stats.cache_used -= entry->size;
+  glue->sd_stats.cache_evictions++;
+  free(entry);
+  return true;
+}
+
+// Frees every file cache entry. Only once freeHandles() has closed the
+// files still open, leaving no users.
+static void file_cache_free(Adafruit_LvGL_Glue_SD *glue) {
+  while (LvGLFileCacheEntry *entry = glue->file_cache) {
+    glue->file_cache = entry->next;
+    free(entry);
+  }
+  glue->sd_stats.cache_used = 0;
+}
+
+static void stream_forget(Adafruit_LvGL_Glue_SD *glue, const char *path);
+
+// Forgets what's kept in RAM about a file that's about to be written: the
+// image the streaming decoder left open on it, its file cache entry (freed
+// as soon as no one is reading it) and idle handles
+static void file_cache_invalidate(Adafruit_LvGL_Glue_SD *glue,
+                                  const char *path) {
+  stream_forget(glue, path); // Its handle may then go idle, dropped below
+  LvGLFileCacheEntry *entry = file_cache_find(glue, path);
+  if (entry) {
+    glue->file_cache = entry->next;
+    glue->sd_stats.cache_used -= entry->size;
+    if (entry->users) {
+      entry->stale = true;
+    } else {
+      free(entry);
+    }
+  }
+  fp_ *handles = (fp_ *)glue->handles;
+  for (uint8_t i = 0; i < glue->handle_count; i++) {
+    if ((handles[i].state == SD_HANDLE_IDLE) &&
+        !strcmp(handles[i].path, path)) {
+      handle_drop(glue, &handles[i]);
+    }
+  }
+}
+
+// Reads size bytes of a just-opened file, from offset base, into a new file
+// cache entry, making room by evicting older files. Files over half the
+// budget aren't cached, so one big background image can't push out every
+// icon. NULL if not cached.
+static LvGLFileCacheEntry *file_cache_load(Adafruit_LvGL_Glue_SD *glue,
+                                           const char *path, File32 &file,
+                                           uint32_t base, uint32_t size) {
+  if (size > glue->cache_budget / 2) {
+    return NULL;
+  }
+  while ((glue->sd_stats.cache_used + size > glue->cache_budget) &&
+         file_cache_evict(glue))
+    ;
+  if (glue->sd_stats.cache_used + size > glue->cache_budget) {
+    return NULL; // Everything left is in use
+  }
+  size_t path_len = strlen(path) + 1;
+  LvGLFileCacheEntry *entry = (LvGLFileCacheEntry *)file_cache_alloc(
+      sizeof(LvGLFileCacheEntry) + size + path_len);
+  if (!entry) {
     return NULL;
   }
+  entry->data = (uint8_t *)(entry + 1);
+  entry->path = (const char *)memcpy(entry->data + size, path, path_len);
+  entry->size = size;
+  entry->users = 0;
+  entry->stale = false;
+  if (!file.seek(base) || (file.read(entry->data, size) != (int)size)) {
+    free(entry);
+    return NULL;
+  }
+  glue->sd_stats.sd_reads++;
+  glue->sd_stats.sd_bytes += size;
+  glue->sd_stats.cache_used += size;
+  entry->next = glue->file_cache;
+  glue->file_cache = entry;
+  return entry;
+}
 
-  SdFat *sd = glue->sd;
-  auto file = sd->open(path);
+// Opens a file for writing (LV_FS_MODE_WR), creating it if need be. On its
+// own that starts the file afresh, as fopen()'s "w" does; with
+// LV_FS_MODE_RD too the contents are kept, for updating or (after seeking
+// to LV_FS_SEEK_END) appending.
+static void *sd_open_write(Adafruit_LvGL_Glue_SD *glue, const char *path,
+                           lv_fs_mode_t mode) {
+  fp_ *fp = handle_get(glue);
+  if (!fp) {
+    glue->sd_stats.handle_fails++;
+    LV_LOG_WARN("No free file handle for %s", path);
+    return NULL;
+  }
+  file_cache_invalidate(glue, path);
 
+  waitForDisplay(glue);
+  SdFat *sd = glue->sd;
+  File32 file = sd->open(path, (mode & LV_FS_MODE_RD)
+                                   ? (O_RDWR | O_CREAT)
+                                   : (O_WRONLY | O_CREAT | O_TRUNC));
   if (!file.isOpen()) {
-    LV_LOG_ERROR("Failed to open file %s", path);
+    LV_LOG_ERROR("Failed to open file %s for writing", path);
+    fp->state = SD_HANDLE_FREE;
     return NULL;
   }
+  handle_init(fp, file, NULL, 0, file.fileSize(), false);
+  fp->writable = true;
+  return fp;
+}
+
+// Callback functions to support reading images from SD cards
+static void *sd_open(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode) {
+  Adafruit_LvGL_Glue_SD *glue = (Adafruit_LvGL_Glue_SD *)drv->user_data;
+
+  if (mode & LV_FS_MODE_WR) {
+    return sd_open_write(glue, path, mode);
+  }
+
+  // A handle LvGL closed on the same file can be taken up again as it was,
+  // skipping the FAT lookup and keeping its read-ahead cache
+  fp_ *handles = (fp_ *)glue->handles;
+  for (uint8_t i = 0; i < glue->handle_count; i++) {
+    if ((handles[i].state == SD_HANDLE_IDLE) &&
+        !strcmp(handles[i].path, path)) {
+      handles[i].state = SD_HANDLE_OPEN;
+      handles[i].pos = 0;
+      glue->sd_stats.handle_reuses++;
+      return &handles[i];
+    }
+  }
 
-  if (!file.seek(0)) {
+  // Handles come from the pool, so there's a fixed number
+  fp_ *fp = handle_get(glue);
+  if (!fp) {
+    glue->sd_stats.handle_fails++;
+    LV_LOG_WARN("No free file handle for %s", path);
     return NULL;
   }
-  return new fp_{file};
+
+  LvGLFileCacheEntry *entry = NULL;
+  if (glue->cache_budget) {
+    if ((entry = file_cache_find(glue, path))) {
+      glue->sd_stats.cache_hits++;
+      entry->users++;
+      return handle_init(fp, File32(), entry, 0, entry->size, false);
+    }
+    glue->sd_stats.cache_misses++;
+  }
+
+  // Look in the bundle's index first, then on the card. Assets in the
+  // bundle don't need a FAT directory walk, or any card access at all
+  // until they're read.
+  const LvGLPackEntry *asset = NULL;
+  File32 file;
+  uint32_t base = 0, size;
+  if (glue->bundle_index &&
+      (asset = Adafruit_LvGL_Assets::findEntry(
+           glue->bundle_index, glue->bundle_count, glue->bundle_names, path))) {
+    glue->sd_stats.bundle_opens++;
+    file = glue->bundle;
+    base = asset->offset;
+    size = asset->size;
+  } else {
+    waitForDisplay(glue);
+    SdFat *sd = glue->sd;
+    file = sd->open(path);
+
+    if (!file.isOpen()) {
+      LV_LOG_ERROR("Failed to open file %s", path);
+      fp->state = SD_HANDLE_FREE;
+      return NULL;
+    }
+
+    if (!file.seek(0)) {
+      file.close();
+      fp->state = SD_HANDLE_FREE;
+      return NULL;
+    }
+    size = file.fileSize();
+  }
+
+  if (glue->cache_budget) {
+    if (asset) {
+      waitForDisplay(glue);
+    }
+    if ((entry = file_cache_load(glue, path, file, base, size))) {
+      if (!asset) {
+        file.close();
+      }
+      entry->users++;
+      return handle_init(fp, File32(), entry, 0, size, false);
+    }
+  }
+  handle_init(fp, file, NULL, base, size, asset != NULL);
+  // Remember the path, so the handle can be kept open after LvGL closes it
+  size_t path_len = strlen(path) + 1;
+  if (glue->keep_open && !asset && (path_len <= SD_HANDLE_PATH)) {
+    memcpy(fp->path, path, path_len);
+  }
+  return fp;
 }
 
 static lv_fs_res_t sd_read(struct lv_fs_drv_t *drv, void *file_p, void *buf,
                            uint32_t btr, uint32_t *br) {
   Adafruit_LvGL_Glue_SD *glue = (Adafruit_LvGL_Glue_SD *)drv->user_data;
-  waitForDisplay(glue->display);
-
   fp_ *fp = (fp_ *)file_p;
-  *br = fp->file.read(buf, btr);
+  LvGLSDStats *stats = &glue->sd_stats;
+  uint8_t *dest = (uint8_t *)buf;
+  uint32_t sd_reads = stats->sd_reads;
+  stats->reads++;
+  *br = 0;
+  btr = (fp->pos < fp->size) ? min(btr, fp->size - fp->pos) : 0;
+  if (fp->entry) { // Whole file is in RAM
+    memcpy(dest, fp->entry->data + fp->pos, btr);
+    fp->pos += btr;
+    *br = btr;
+    btr = 0;
+  }
+  while (btr) {
+    uint32_t at = fp->base + fp->pos; // Offset in the file on the card
+    if ((at >= fp->cache_pos) && (at < fp->cache_pos + fp->cache_len)) {
+      uint32_t offset = at - fp->cache_pos;
+      uint32_t n = min(btr, fp->cache_len - offset);
+      memcpy(dest, fp->cache + offset, n);
+      dest += n;
+      fp->pos += n;
+      *br += n;
+      btr -= n;
+      continue;
+    }
+    // Miss: go to the card, which means waiting for the display's bus,
+    // after sending it anything written that's still in the cache
+    if (!handle_flush(glue, fp)) {
+      return LV_FS_RES_FS_ERR;
+    }
+    waitForDisplay(glue);
+    int n;
+    if (btr >= glue->read_ahead) {
+      // Big enough to read straight into LvGL's buffer
+      if ((fp->file.curPosition() != at) && !fp->file.seek(at)) {
+        return LV_FS_RES_FS_ERR;
+      }
+      if ((n = fp->file.read(dest, btr)) < 0) {
+        return LV_FS_RES_FS_ERR;
+      }
+      fp->pos += n;
+      *br += n;
+      btr = 0;
+    } else {
+      // Refill the cache from the start of the sector holding pos
+      uint32_t start = at & ~(uint32_t)(SD_SECTOR - 1);
+      fp->cache_len = 0;
+      if ((fp->file.curPosition() != start) && !fp->file.seek(start)) {
+        return LV_FS_RES_FS_ERR;
+      }
+      if ((n = fp->file.read(fp->cache, glue->read_ahead)) < 0) {
+        return LV_FS_RES_FS_ERR;
+      }
+      fp->cache_pos = start;
+      fp->cache_len = n;
+      if (at >= start + n) {
+        btr = 0; // End of file
+      }
+    }
+    stats->sd_reads++;
+    stats->sd_bytes += n;
+  }
+  stats->bytes += *br;
+  if (stats->sd_reads == sd_reads) {
+    stats->hits++;
+  }
 
-  return (*br != -1) ? LV_FS_RES_OK : LV_FS_RES_FS_ERR;
+  return LV_FS_RES_OK;
 }
 
 static lv_fs_res_t sd_close(lv_fs_drv_t *drv, void *file_p) {
   Adafruit_LvGL_Glue_SD *glue = (Adafruit_LvGL_Glue_SD *)drv->user_data;
-  waitForDisplay(glue->display);
-
   fp_ *fp = (fp_ *)file_p;
-  lv_fs_res_t result = fp->file.close() ? LV_FS_RES_OK : LV_FS_RES_UNKNOWN;
-  delete fp;
+  if (fp->entry) {
+    if (!--fp->entry->users && fp->entry->stale) {
+      free(fp->entry);
+    }
+    fp->entry = NULL;
+    fp->state = SD_HANDLE_FREE;
+    return LV_FS_RES_OK;
+  }
+  if (fp->path[0]) {
+    // Keep the file open in case LvGL opens it again
+    fp->state = SD_HANDLE_IDLE;
+    fp->closed = glue->handle_clock++;
+    return LV_FS_RES_OK;
+  }
+
+  lv_fs_res_t result = handle_flush(glue, fp) ? LV_FS_RES_OK : LV_FS_RES_FS_ERR;
+  if (!fp->bundled) {
+    waitForDisplay(glue);
+    if (!fp->file.close()) {
+      result = LV_FS_RES_UNKNOWN;
+    }
+  }
+  fp->state = SD_HANDLE_FREE;
 
   return result;
 }
 
-static lv_fs_res_t sd_seek(lv_fs_drv_t *drv, void *file_p, uint32_t pos,
-                           lv_fs_whence_t whence) {
+// Writes are gathered in the handle's cache while they carry on from one
+// another, and sent to the card when it fills up, before a read that
+// misses it, or when the file is closed. Writes of a cache-full or more
+// go straight to the card.
+static lv_fs_res_t sd_write(lv_fs_drv_t *drv, void *file_p, const void *buf,
+                            uint32_t btw, uint32_t *bw) {
   Adafruit_LvGL_Glue_SD *glue = (Adafruit_LvGL_Glue_SD *)drv->user_data;
-  waitForDisplay(glue->display);
+  fp_ *fp = (fp_ *)file_p;
+  const uint8_t *src = (const uint8_t *)buf;
+  *bw = 0;
+  if (!fp->writable) {
+    return LV_FS_RES_DENIED;
+  }
+  glue->sd_stats.writes++;
+  if (fp->dirty && (fp->pos != fp->cache_pos + fp->cache_len) &&
+      !handle_flush(glue, fp)) {
+    return LV_FS_RES_FS_ERR;
+  }
+  if (!fp->dirty) {
+    // Start gathering here; what was cached for reading may be overwritten
+    fp->cache_pos = fp->pos;
+    fp->cache_len = 0;
+  }
+  while (btw) {
+    if (!fp->dirty && (btw >= glue->read_ahead)) {
+      waitForDisplay(glue);
+      if ((fp->file.curPosition() != fp->pos) && !fp->file.seek(fp->pos)) {
+        return LV_FS_RES_FS_ERR;
+      }
+      size_t n = fp->file.write(src, btw);
+      glue->sd_stats.sd_writes++;
+      glue->sd_stats.sd_write_bytes += n;
+      fp->pos += n;
+      *bw += n;
+      if (n != btw) {
+        fp->size = max(fp->size, fp->pos);
+        return LV_FS_RES_FS_ERR;
+      }
+      break;
+    }
+    uint32_t n = min(btw, (uint32_t)(glue->read_ahead - fp->cache_len));
+    memcpy(fp->cache + fp->cache_len, src, n);
+    fp->cache_len += n;
+    fp->dirty = true;
+    fp->pos += n;
+    *bw += n;
+    src += n;
+    btw -= n;
+    if ((fp->cache_len == glue->read_ahead) && !handle_flush(glue, fp)) {
+      fp->size = max(fp->size, fp->pos);
+      return LV_FS_RES_FS_ERR;
+    }
+    if (!fp->dirty) {
+      fp->cache_pos = fp->pos; // Gather the rest after what was just sent
+      fp->cache_len = 0;
+    }
+  }
+  fp->size = max(fp->size, fp->pos);
+  return LV_FS_RES_OK;
+}
 
+// Seeking just moves the read position; the card is only touched by the
+// next read, and not at all if that's a cache hit. Offsets from the
+// current position or the end are signed, as LvGL passes them in a
+// uint32_t. A position before the start or past the end is refused, for
+// writing too: SdFat can't seek there either.
+static lv_fs_res_t sd_seek(lv_fs_drv_t *drv, void *file_p, uint32_t pos,
+                           lv_fs_whence_t whence) {
   fp_ *fp = (fp_ *)file_p;
-  return fp->file.seek(pos) ? LV_FS_RES_OK : LV_FS_RES_UNKNOWN;
+  int64_t to;
+  switch (whence) {
+  case LV_FS_SEEK_SET:
+    to = pos;
+    break;
+  case LV_FS_SEEK_CUR:
+    to = (int64_t)fp->pos + (int32_t)pos;
+    break;
+  case LV_FS_SEEK_END:
+    to = (int64_t)fp->size + (int32_t)pos;
+    break;
+  default:
+    return LV_FS_RES_INV_PARAM;
+  }
+  if ((to < 0) || (to > fp->size)) {
+    return LV_FS_RES_INV_PARAM;
+  }
+  fp->pos = to;
+  return LV_FS_RES_OK;
 }
 
 static lv_fs_res_t sd_tell(lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p) {
+  fp_ *fp = (fp_ *)file_p;
+  *pos_p = fp->pos;
+
+  return LV_FS_RES_OK;
+}
+
+// Directories are listed through a handle from the pool, too
+static void *sd_dir_open(lv_fs_drv_t *drv, const char *path) {
   Adafruit_LvGL_Glue_SD *glue = (Adafruit_LvGL_Glue_SD *)drv->user_data;
-  waitForDisplay(glue->display);
+  fp_ *fp = handle_get(glue);
+  if (!fp) {
+    glue->sd_stats.handle_fails++;
+    return NULL;
+  }
+  waitForDisplay(glue);
+  SdFat *sd = glue->sd;
+  File32 dir = sd->open(*path ? path : "/");
+  if (!dir.isOpen() || !dir.isDir()) {
+    LV_LOG_ERROR("Failed to open directory %s", path);
+    dir.close();
+    fp->state = SD_HANDLE_FREE;
+    return NULL;
+  }
+  return handle_init(fp, dir, NULL, 0, 0, false);
+}
 
-  fp_ *fp = (fp_ *)file_p;
-  *pos_p = fp->file.position();
+// Gives the next name in the directory, with a '/' in front if it's a
+// directory itself, as LvGL expects, or "" after the last one
+static lv_fs_res_t sd_dir_read(lv_fs_drv_t *drv, void *dir_p, char *fn,
+                               uint32_t fn_len) {
+  Adafruit_LvGL_Glue_SD *glue = (Adafruit_LvGL_Glue_SD *)drv->user_data;
+  fp_ *fp = (fp_ *)dir_p;
+  File32 entry;
+  if (fn_len < 2) {
+    return LV_FS_RES_INV_PARAM;
+  }
+  waitForDisplay(glue);
+  if (!entry.openNext(&fp->file, O_RDONLY)) {
+    fn[0] = 0;
+    return LV_FS_RES_OK;
+  }
+  if (entry.isDir()) {
+    *fn++ = '/';
+    fn_len--;
+  }
+  entry.getName(fn, fn_len);
+  entry.close();
+  return LV_FS_RES_OK;
+}
 
+static lv_fs_res_t sd_dir_close(lv_fs_drv_t *drv, void *dir_p) {
+  Adafruit_LvGL_Glue_SD *glue = (Adafruit_LvGL_Glue_SD *)drv->user_data;
+  handle_drop(glue, (fp_ *)dir_p);
   return LV_FS_RES_OK;
 }
 
+// Streaming image decoder. RGB565 .bin images on the card are decoded a
+// band of rows at a time as LvGL draws them, straight from the file into
+// a band buffer, instead of whole into LvGL's heap. It takes big images,
+// raw or compressed with LvGL's RLE (LVGLImage.py --compress RLE), and
+// Q565-compressed images (see Adafruit_LvGL_Glue_SD.h) of any size. The
+// file stays open between bands with its decode position, so drawing the
+// image top to bottom reads and decodes each row once.
+
+#define SD_STREAM_BYTES 8192 // Default LvGLConfig::sd_stream_bytes
+#define SD_STREAM_ROWS 8     // Default LvGLConfig::sd_stream_rows
+#define SD_STREAM_RAW 0      // Image data methods
+#define SD_STREAM_RLE 1
+
+// Compression header following lv_image_header_t in compressed .bin files
+typedef struct {
+  uint32_t method; // Low 4 bits: SD_STREAM_RLE or LVGL_COMPRESS_Q565
+  uint32_t compressed_size;
+  uint32_t decompressed_size;
+} sd_stream_compressed_t;
+
+// State of one image being streamed
+struct stream_ {
+  lv_fs_file_t file;
+  char *path;          // Image source, to resume on the next open
+  uint32_t data_pos;   // File offset of the pixels, or of the compressed data
+  uint32_t stride;     // Bytes per row
+  uint32_t row;        // Row the file position has reached
+  uint8_t method;      // SD_STREAM_RAW, SD_STREAM_RLE or LVGL_COMPRESS_Q565
+  bool literal;        // Current run's pixels follow it in the file
+  uint8_t run;         // Pixels left in the current run
+  uint16_t pixel;      // Pixel repeated by the current run; Q565's previous
+  uint16_t in_pos;     // Next byte in in[]
+  uint16_t in_len;     // Valid bytes in in[]
+  uint8_t in[128];     // Compressed data input buffer
+  uint8_t *pixels;     // Band buffer
+  lv_draw_buf_t band;  // Band handed to LvGL, on pixels
+};
+
+static void stream_free(stream_ *s) {
+  if (s) {
+    lv_fs_close(&s->file);
+    free(s->pixels);
+    free(s->path);
+    delete s;
+  }
+}
+
+// Closes the image left open by the last draw if it's the SD file path
+// (without the drive letter), so the next draw reads the file afresh
+static void stream_forget(Adafruit_LvGL_Glue_SD *glue, const char *path) {
+  stream_ *s = (stream_ *)glue->stream_idle;
+  if (s && (s->path[0] == 'S') && (s->path[1] == ':') &&
+      !strcmp(s->path + 2, path)) {
+    stream_free(s);
+    glue->stream_idle = NULL;
+  }
+}
+
+// Copies (or, if dest is NULL, skips) n bytes of compressed data
+static bool stream_bytes(stream_ *s, uint8_t *dest, uint32_t n) {
+  while (n) {
+    if (s->in_pos == s->in_len) {
+      uint32_t br;
+      if ((lv_fs_read(&s->file, s->in, sizeof s->in, &br) != LV_FS_RES_OK) ||
+          !br) {
+        return false;
+      }
+      s->in_pos = 0;
+      s->in_len = br;
+    }
+    uint32_t len = min(n, (uint32_t)(s->in_len - s->in_pos));
+    if (dest) {
+      memcpy(dest, s->in + s->in_pos, len);
+      dest += len;
+    }
+    s->in_pos += len;
+    n -= len;
+  }
+  return true;
+}
+
+// Reads one byte of compressed data, usually straight from in[]
+static inline bool stream_byte(stream_ *s, uint8_t *b) {
+  if (s->in_pos < s->in_len) {
+    *b = s->in[s->in_pos++];
+    return true;
+  }
+  return stream_bytes(s, b, 1);
+}
+
+// Writes n copies of s->pixel to *dest (if not NULL), advancing it
+static inline void stream_fill(stream_ *s, uint8_t **dest, uint32_t n) {
+  if (*dest) {
+    for (uint32_t i = 0; i < n; i++, *dest += 2) {
+      memcpy(*dest, &s->pixel, 2);
+    }
+  }
+}
+
+// Copies n literal pixels to *dest (or skips them, if it's NULL), leaving
+// the last one in s->pixel
+static bool stream_literal(stream_ *s, uint8_t **dest, uint32_t n) {
+  if (!*dest) {
+    return stream_bytes(s, NULL, n * 2 - 2) &&
+           stream_bytes(s, (uint8_t *)&s->pixel, 2);
+  }
+  if (!stream_bytes(s, *dest, n * 2)) {
+    return false;
+  }
+  *dest += n * 2;
+  memcpy(&s->pixel, *dest - 2, 2);
+  return true;
+}
+
+// Decodes (or, if dest is NULL, skips) the next 'pixels' pixels of an RLE
+// image. Blocks are a control byte, then either (bit 7 set) that many
+// pixels, or (bit 7 clear) one pixel repeated that many times, and may
+// run across rows, so the current block is carried over between calls.
+static bool stream_rle(stream_ *s, uint8_t *dest, uint32_t pixels) {
+  while (pixels) {
+    if (!s->run) {
+      uint8_t ctrl;
+      if (!stream_byte(s, &ctrl)) {
+        return false;
+      }
+      s->literal = ctrl & 0x80;
+      s->run = ctrl & 0x7F;
+      if (!s->literal && !stream_bytes(s, (uint8_t *)&s->pixel, 2)) {
+        return false;
+      }
+      continue;
+    }
+    uint32_t n = min(pixels, (uint32_t)s->run);
+    if (s->literal) {
+      if (!stream_literal(s, &dest, n)) {
+        return false;
+      }
+    } else {
+      stream_fill(s, &dest, n);
+    }
+    s->run -= n;
+    pixels -= n;
+  }
+  return true;
+}
+
+// Decodes (or, if dest is NULL, skips) the next 'pixels' pixels of a Q565
+// image: one pass, no tables, every op is decided by its top two bits.
+// Runs and literal runs may cross rows and are carried over like RLE's.
+static bool stream_q565(stream_ *s, uint8_t *dest, uint32_t pixels) {
+  while (pixels) {
+    if (s->run) {
+      uint32_t n = min(pixels, (uint32_t)s->run);
+      if (s->literal) {
+        if (!stream_literal(s, &dest, n)) {
+          return false;
+        }
+      } else {
+        stream_fill(s, &dest, n);
+      }
+      s->run -= n;
+      pixels -= n;
+      continue;
+    }
+    uint8_t op;
+    if (!stream_byte(s, &op)) {
+      return false;
+    }
+    uint16_t p = s->pixel;
+    int8_t dr, dg, db;
+    switch (op >> 6) {
+    case 0: // Q565_RUN
+      s->literal = false;
+      s->run = (op & 0x3F) + 1;
+      continue;
+    case 3: // Q565_LITERAL
+      s->literal = true;
+      s->run = (op & 0x3F) + 1;
+      continue;
+    case 1: // Q565_DIFF
+      dr = ((op >> 4) & 3) - 2;
+      dg = ((op >> 2) & 3) - 2;
+      db = (op & 3) - 2;
+      break;
+    default: // Q565_LUMA
+      uint8_t rb;
+      if (!stream_byte(s, &rb)) {
+        return false;
+      }
+      dg = (op & 0x3F) - 32;
+      dr = (dg >> 1) + (rb >> 4) - 8;
+      db = (dg >> 1) + (rb & 0xF) - 8;
+      break;
+    }
+    s->pixel = (((p >> 11) + dr) & 0x1F) << 11 |
+               ((((p >> 5) & 0x3F) + dg) & 0x3F) << 5 |
+               (((p & 0x1F) + db) & 0x1F);
+    stream_fill(s, &dest, 1);
+    pixels--;
+  }
+  return true;
+}
+
+// Decodes (or skips) the next 'pixels' pixels of a compressed image
+static bool stream_decode(stream_ *s, uint8_t *dest, uint32_t pixels) {
+  return (s->method == SD_STREAM_RLE) ? stream_rle(s, dest, pixels)
+                                      : stream_q565(s, dest, pixels);
+}
+
+// Decodes rows y to y + n - 1 into the band buffer. Raw images seek to y;
+// compressed images decode forward to it, from the start if it's behind.
+static bool stream_rows(Adafruit_LvGL_Glue_SD *glue, stream_ *s, uint32_t y,
+                        uint32_t n) {
+  if (s->method == SD_STREAM_RAW) {
+    uint32_t br;
+    if ((lv_fs_seek(&s->file, s->data_pos + y * s->stride, LV_FS_SEEK_SET) !=
+         LV_FS_RES_OK) ||
+        (lv_fs_read(&s->file, s->pixels, n * s->stride, &br) !=
+         LV_FS_RES_OK) ||
+        (br != n * s->stride)) {
+      return false;
+    }
+  } else {
+    if (y < s->row) {
+      if (lv_fs_seek(&s->file, s->data_pos, LV_FS_SEEK_SET) != LV_FS_RES_OK) {
+        return false;
+      }
+      s->row = 0;
+      s->run = 0;
+      s->pixel = 0;
+      s->in_pos = s->in_len = 0;
+      glue->sd_stats.stream_rewinds++;
+    }
+    glue->sd_stats.stream_skipped += y - s->row;
+    if (!stream_decode(s, NULL, (y - s->row) * s->stride / 2) ||
+        !stream_decode(s, s->pixels, n * s->stride / 2)) {
+      return false;
+    }
+  }
+  s->row = y + n;
+  glue->sd_stats.stream_bands++;
+  return true;
+}
+
+// Claims RGB565 .bin images on this drive that are Q565-compressed, or that
+// decode to more than stream_bytes, leaving smaller ones to LvGL's own
+// decoder (and cache)
+static lv_result_t stream_info(lv_image_decoder_t *decoder,
+                               lv_image_decoder_dsc_t *dsc,
+                               lv_image_header_t *header) {
+  Adafruit_LvGL_Glue_SD *glue = (Adafruit_LvGL_Glue_SD *)decoder->user_data;
+  const char *path = (const char *)dsc->src;
+  if ((dsc->src_type != LV_IMAGE_SRC_FILE) || (path[0] != 'S')) {
+    return LV_RESULT_INVALID;
+  }
+  const char *ext = strrchr(path, '.');
+  if (!ext || strcmp(ext, ".bin")) {
+    return LV_RESULT_INVALID;
+  }
+
+  lv_image_header_t h;
+  sd_stream_compressed_t comp;
+  uint8_t method = SD_STREAM_RAW;
+  uint32_t br;
+  if ((lv_fs_read(&dsc->file, &h, sizeof h, &br) != LV_FS_RES_OK) ||
+      (br != sizeof h) || (h.magic != LV_IMAGE_HEADER_MAGIC) ||
+      (h.cf != LV_COLOR_FORMAT_RGB565)) {
+    return LV_RESULT_INVALID;
+  }
+  if (h.flags & LV_IMAGE_FLAGS_COMPRESSED) {
+    if ((lv_fs_read(&dsc->file, &comp, sizeof comp, &br) != LV_FS_RES_OK) ||
+        (br != sizeof comp)) {
+      return LV_RESULT_INVALID;
+    }
+    method = comp.method & 0xF;
+    if ((method != SD_STREAM_RLE) && (method != LVGL_COMPRESS_Q565)) {
+      return LV_RESULT_INVALID;
+    }
+  }
+  uint32_t stride = h.stride ? h.stride : h.w * 2;
+  if ((stride & 1) || (stride < h.w * 2) ||
+      ((method != LVGL_COMPRESS_Q565) && (stride * h.h <= glue->stream_bytes))) {
+    return LV_RESULT_INVALID;
+  }
+  *header = h;
+  header->stride = stride;
+  header->flags &= ~LV_IMAGE_FLAGS_COMPRESSED;
+  return LV_RESULT_OK;
+}
+
+// Opens the image, or picks up the one left open by the last close if it's
+// the same image. No pixels are decoded here; dsc->decoded stays NULL so
+// LvGL asks for them a band at a time through stream_get_area().
+static lv_result_t stream_open(lv_image_decoder_t *decoder,
+                               lv_image_decoder_dsc_t *dsc) {
+  Adafruit_LvGL_Glue_SD *glue = (Adafruit_LvGL_Glue_SD *)decoder->user_data;
+  const char *path = (const char *)dsc->src;
+  stream_ *s = (stream_ *)glue->stream_idle;
+  glue->stream_idle = NULL;
+  if (s && !strcmp(s->path, path)) {
+    dsc->user_data = s;
+    return LV_RESULT_OK;
+  }
+  stream_free(s);
+
+  lv_image_header_t h;
+  sd_stream_compressed_t comp;
+  uint32_t br;
+  if (!(s = new (std::nothrow) stream_())) {
+    return LV_RESULT_INVALID;
+  }
+  if (lv_fs_open(&s->file, path, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+    delete s;
+    return LV_RESULT_INVALID;
+  }
+  s->stride = dsc->header.stride;
+  s->path = strdup(path);
+  s->pixels = (uint8_t *)malloc(glue->stream_rows * s->stride);
+  if (!s->path || !s->pixels ||
+      (lv_fs_read(&s->file, &h, sizeof h, &br) != LV_FS_RES_OK) ||
+      (br != sizeof h)) {
+    stream_free(s);
+    return LV_RESULT_INVALID;
+  }
+  s->method = SD_STREAM_RAW;
+  s->data_pos = sizeof h;
+  if (h.flags & LV_IMAGE_FLAGS_COMPRESSED) {
+    if ((lv_fs_read(&s->file, &comp, sizeof comp, &br) != LV_FS_RES_OK) ||
+        (br != sizeof comp)) {
+      stream_free(s);
+      return LV_RESULT_INVALID;
+    }
+    s->method = comp.method & 0xF;
+    s->data_pos += sizeof comp;
+  }
+  lv_draw_buf_init(&s->band, h.w, glue->stream_rows, LV_COLOR_FORMAT_RGB565,
+                   s->stride, s->pixels, glue->stream_rows * s->stride);
+  dsc->user_data = s;
+  return LV_RESULT_OK;
+}
+
+// Decodes the next band of full_area: its first stream_rows rows on the
+// first call (decoded_area->y1 is LV_COORD_MIN), then the rows after the
+// last band, until full_area is done
+static lv_result_t stream_get_area(lv_image_decoder_t *decoder,
+                                   lv_image_decoder_dsc_t *dsc,
+                                   const lv_area_t *full_area,
+                                   lv_area_t *decoded_area) {
+  Adafruit_LvGL_Glue_SD *glue = (Adafruit_LvGL_Glue_SD *)decoder->user_data;
+  stream_ *s = (stream_ *)dsc->user_data;
+  int32_t y = (decoded_area->y1 == LV_COORD_MIN) ? full_area->y1
+                                                  : decoded_area->y2 + 1;
+  if ((y < 0) || (y > full_area->y2) || (y >= (int32_t)dsc->header.h)) {
+    return LV_RESULT_INVALID;
+  }
+  uint32_t n = min((uint32_t)(full_area->y2 - y + 1), (uint32_t)glue->stream_rows);
+  n = min(n, dsc->header.h - (uint32_t)y);
+  if (!stream_rows(glue, s, y, n)) {
+    return LV_RESULT_INVALID;
+  }
+  s->band.header.h = n;
+  s->band.data_size = n * s->stride;
+  dsc->decoded = &s->band;
+  decoded_area->x1 = 0;
+  decoded_area->x2 = dsc->header.w - 1;
+  decoded_area->y1 = y;
+  decoded_area->y2 = y + n - 1;
+  return LV_RESULT_OK;
+}
+
+// Keeps the image open, at its decode position, for the next draw of it
+static void stream_close(lv_image_decoder_t *decoder,
+                         lv_image_decoder_dsc_t *dsc) {
+  Adafruit_LvGL_Glue_SD *glue = (Adafruit_LvGL_Glue_SD *)decoder->user_data;
+  stream_free((stream_ *)glue->stream_idle);
+  glue->stream_idle = dsc->user_data;
+  dsc->user_data = NULL;
+  dsc->decoded = NULL;
+}
+
+/**
+ * @brief Construct a new Adafruit_LvGL_Glue_SD object
+ *
+ */
+Adafruit_LvGL_Glue_SD::Adafruit_LvGL_Glue_SD(void)
+    : sd(NULL), read_ahead(0), sd_stats(), cache_budget(0), file_cache(NULL),
+      bundle_index(NULL), bundle_names(NULL), bundle_count(0),
+      stream_bytes(0), stream_rows(0), stream_idle(NULL), handles(NULL),
+      handle_count(0), keep_open(false), handle_clock(0),
+      stream_decoder(NULL) {}
+
+/**
+ * @brief Destroy the Adafruit_LvGL_Glue_SD object, freeing the file cache
+ * and removing the streaming image decoder
+ *
+ */
+Adafruit_LvGL_Glue_SD::~Adafruit_LvGL_Glue_SD(void) {
+  if (stream_decoder) {
+    lv_image_decoder_delete(stream_decoder);
+  }
+  stream_free((stream_ *)stream_idle);
+  stream_idle = NULL;
+  clearFileCache();
+  freeHandles();
+  file_cache_free(this); // Files LvGL left open
+  closeBundle();
+}
+
+/**
+ * @brief Drop every file in the file cache that isn't open, e.g. after the
+ * files on the card have been changed by other code. Also closes the files
+ * kept open by idle handles and by the streaming image decoder.
+ *
+ */
+void Adafruit_LvGL_Glue_SD::clearFileCache(void) {
+  stream_free((stream_ *)stream_idle);
+  stream_idle = NULL;
+  fp_ *pool = (fp_ *)handles;
+  for (uint8_t i = 0; i < handle_count; i++) {
+    if (pool[i].state == SD_HANDLE_IDLE) {
+      handle_drop(this, &pool[i]);
+    }
+  }
+  while (file_cache_evict(this))
+    ;
+}
+
 /**
  * @brief Configure the glue layer and the underlying LvGL code to use the given
  * TFT display driver, touchscreen controller and SD card instances
@@ -88,16 +1051,12 @@ static lv_fs_res_t sd_tell(lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p) {
  * configured in LittleLVGL's lv_conf.h
  * @return LvGLStatus The status of the initialization:
  * * LVGL_OK : Success
- * * LVGL_ERR_TIMER : Failure to set up timers
  * * LVGL_ERR_ALLOC : Failure to allocate memory
  */
 LvGLStatus Adafruit_LvGL_Glue_SD::begin(Adafruit_SPITFT *tft,
                                         Adafruit_STMPE610 *touch, SdFat *sdFat,
                                         bool debug) {
-  sd = sdFat;
-  LvGLStatus status = Adafruit_LvGL_Glue::begin(tft, touch, debug);
-  initFileSystem();
-  return status;
+  return begin(tft, touch, sdFat, LvGLConfig(), debug);
 }
 
 /**
@@ -112,16 +1071,12 @@ LvGLStatus Adafruit_LvGL_Glue_SD::begin(Adafruit_SPITFT *tft,
  * configured in LittleLVGL's lv_conf.h
  * @return LvGLStatus The status of the initialization:
  * * LVGL_OK : Success
- * * LVGL_ERR_TIMER : Failure to set up timers
  * * LVGL_ERR_ALLOC : Failure to allocate memory
  */
 LvGLStatus Adafruit_LvGL_Glue_SD::begin(Adafruit_SPITFT *tft,
                                         TouchScreen *touch, SdFat *sdFat,
                                         bool debug) {
-  sd = sdFat;
-  LvGLStatus status = Adafruit_LvGL_Glue::begin(tft, touch, debug);
-  initFileSystem();
-  return status;
+  return begin(tft, touch, sdFat, LvGLConfig(), debug);
 }
 
 /**
@@ -134,25 +1089,242 @@ LvGLStatus Adafruit_LvGL_Glue_SD::begin(Adafruit_SPITFT *tft,
  * configured in LittleLVGL's lv_conf.h
  * @return LvGLStatus The status of the initialization:
  * * LVGL_OK : Success
- * * LVGL_ERR_TIMER : Failure to set up timers
  * * LVGL_ERR_ALLOC : Failure to allocate memory
  */
 LvGLStatus Adafruit_LvGL_Glue_SD::begin(Adafruit_SPITFT *tft, SdFat *sdFat,
                                         bool debug) {
+  return begin(tft, sdFat, LvGLConfig(), debug);
+}
+
+/**
+ * @brief Configure the glue layer and the underlying LvGL code to use the given
+ * TFT display driver, touchscreen controller and SD card instances, with
+ * non-default draw buffer settings
+ *
+ * @param tft Pointer to an **already initialized** display object instance
+ * @param touch Pointer to an **already initialized** `Adafruit_STMPE610`
+ * touchscreen controller object instance
+ * @param sdFat Pointer to an **already initialized** `SdFat` object instance
+ * @param config Draw buffer size, mode and placement, see LvGLConfig
+ * @param debug Debug flag to enable debug messages. Only used if LV_USE_LOG is
+ * configured in LittleLVGL's lv_conf.h
+ * @return LvGLStatus The status of the initialization:
+ * * LVGL_OK : Success
+ * * LVGL_ERR_ALLOC : Failure to allocate memory
+ */
+LvGLStatus Adafruit_LvGL_Glue_SD::begin(Adafruit_SPITFT *tft,
+                                        Adafruit_STMPE610 *touch, SdFat *sdFat,
+                                        const LvGLConfig &config, bool debug) {
+  sd = sdFat;
+  LvGLStatus status = Adafruit_LvGL_Glue::begin(tft, touch, config, debug);
+  LvGLStatus fs_status = initFileSystem(config);
+  return (status != LVGL_OK) ? status : fs_status;
+}
+
+/**
+ * @brief Configure the glue layer and the underlying LvGL code to use the given
+ * TFT display driver, touchscreen controller and SD card instances, with
+ * non-default draw buffer settings
+ *
+ * @param tft Pointer to an **already initialized** display object instance
+ * @param touch Pointer to an **already initialized** `TouchScreen` touchscreen
+ * controller object instance
+ * @param sdFat Pointer to an **already initialized** `SdFat` object instance
+ * @param config Draw buffer size, mode and placement, see LvGLConfig
+ * @param debug Debug flag to enable debug messages. Only used if LV_USE_LOG is
+ * configured in LittleLVGL's lv_conf.h
+ * @return LvGLStatus The status of the initialization:
+ * * LVGL_OK : Success
+ * * LVGL_ERR_ALLOC : Failure to allocate memory
+ */
+LvGLStatus Adafruit_LvGL_Glue_SD::begin(Adafruit_SPITFT *tft,
+                                        TouchScreen *touch, SdFat *sdFat,
+                                        const LvGLConfig &config, bool debug) {
+  sd = sdFat;
+  LvGLStatus status = Adafruit_LvGL_Glue::begin(tft, touch, config, debug);
+  LvGLStatus fs_status = initFileSystem(config);
+  return (status != LVGL_OK) ? status : fs_status;
+}
+
+/**
+ * @brief Configure the glue layer and the underlying LvGL code to use the given
+ * TFT display driver and SD card instances, with non-default draw buffer
+ * settings
+ *
+ * @param tft Pointer to an **already initialized** display object instance
+ * @param sdFat Pointer to an **already initialized** `SdFat` object instance
+ * @param config Draw buffer size, mode and placement, see LvGLConfig
+ * @param debug Debug flag to enable debug messages. Only used if LV_USE_LOG is
+ * configured in LittleLVGL's lv_conf.h
+ * @return LvGLStatus The status of the initialization:
+ * * LVGL_OK : Success
+ * * LVGL_ERR_ALLOC : Failure to allocate memory
+ */
+LvGLStatus Adafruit_LvGL_Glue_SD::begin(Adafruit_SPITFT *tft, SdFat *sdFat,
+                                        const LvGLConfig &config, bool debug) {
   sd = sdFat;
-  LvGLStatus status = Adafruit_LvGL_Glue::begin(tft, debug);
-  initFileSystem();
-  return status;
+  LvGLStatus status = Adafruit_LvGL_Glue::begin(tft, config, debug);
+  LvGLStatus fs_status = initFileSystem(config);
+  return (status != LVGL_OK) ? status : fs_status;
+}
+
+// Opens the asset pack at path and loads its index and path strings. The
+// file stays open; handles on its assets read through copies of it.
+LvGLStatus Adafruit_LvGL_Glue_SD::openBundle(const char *path) {
+  LvGLPackHeader header;
+  waitForDisplay(this);
+  bundle = sd->open(path);
+  if (!bundle.isOpen()) {
+    LV_LOG_ERROR("Failed to open bundle %s", path);
+    return LVGL_ERR_CONFIG;
+  }
+  uint32_t file_size = bundle.fileSize();
+  if ((bundle.read(&header, sizeof header) != (int)sizeof header) ||
+      (header.magic != LVGL_PACK_MAGIC) ||
+      (header.version != LVGL_PACK_VERSION) ||
+      (header.count > file_size / sizeof(LvGLPackEntry)) ||
+      (header.names < sizeof header + header.count * sizeof(LvGLPackEntry))) {
+    closeBundle();
+    return LVGL_ERR_FORMAT;
+  }
+
+  // Path strings run from header.names up to the first asset's data
+  size_t index_bytes = header.count * sizeof(LvGLPackEntry);
+  if (!(bundle_index = (LvGLPackEntry *)malloc(index_bytes))) {
+    closeBundle();
+    return LVGL_ERR_ALLOC;
+  }
+  bundle_count = header.count;
+  if (bundle.read(bundle_index, index_bytes) != (int)index_bytes) {
+    closeBundle();
+    return LVGL_ERR_FORMAT;
+  }
+  uint32_t names_end = file_size;
+  for (uint32_t i = 0; i < bundle_count; i++) {
+    names_end = min(names_end, bundle_index[i].offset);
+  }
+  if (names_end < header.names) {
+    closeBundle();
+    return LVGL_ERR_FORMAT;
+  }
+  size_t names_bytes = names_end - header.names;
+  if (!(bundle_names = (char *)malloc(names_bytes + 1))) {
+    closeBundle();
+    return LVGL_ERR_ALLOC;
+  }
+  bundle_names[names_bytes] = 0; // In case the last path isn't terminated
+  if (!bundle.seek(header.names) ||
+      (bundle.read(bundle_names, names_bytes) != (int)names_bytes)) {
+    closeBundle();
+    return LVGL_ERR_FORMAT;
+  }
+  for (uint32_t i = 0; i < bundle_count; i++) {
+    if ((bundle_index[i].name >= names_bytes) ||
+        (bundle_index[i].size > file_size - bundle_index[i].offset)) {
+      closeBundle();
+      return LVGL_ERR_FORMAT;
+    }
+  }
+  return LVGL_OK;
 }
 
-void Adafruit_LvGL_Glue_SD::initFileSystem() {
+// Frees the bundle index and closes the bundle file
+void Adafruit_LvGL_Glue_SD::closeBundle(void) {
+  free(bundle_index);
+  free(bundle_names);
+  bundle_index = NULL;
+  bundle_names = NULL;
+  bundle_count = 0;
+  if (bundle.isOpen()) {
+    waitForDisplay(this);
+    bundle.close();
+  }
+}
+
+// Sets up the pool of count file handles, each with a read-ahead cache
+LvGLStatus Adafruit_LvGL_Glue_SD::allocHandles(uint8_t count) {
+  fp_ *pool = new (std::nothrow) fp_[count]();
+  uint8_t *caches = (uint8_t *)malloc(count * read_ahead);
+  if (!pool || !caches) {
+    delete[] pool;
+    free(caches);
+    return LVGL_ERR_ALLOC;
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    pool[i].cache = caches + i * read_ahead;
+    pool[i].state = SD_HANDLE_FREE;
+  }
+  handles = pool;
+  handle_count = count;
+  return LVGL_OK;
+}
+
+// Frees the handle pool. Files LvGL still has open are closed, and handles
+// to them mustn't be used again.
+void Adafruit_LvGL_Glue_SD::freeHandles(void) {
+  fp_ *pool = (fp_ *)handles;
+  if (!pool) {
+    return;
+  }
+  for (uint8_t i = 0; i < handle_count; i++) {
+    if (pool[i].entry) {
+      if (!--pool[i].entry->users && pool[i].entry->stale) {
+        free(pool[i].entry);
+      }
+    } else if ((pool[i].state != SD_HANDLE_FREE) && !pool[i].bundled) {
+      handle_drop(this, &pool[i]);
+    }
+  }
+  free(pool[0].cache);
+  delete[] pool;
+  handles = NULL;
+  handle_count = 0;
+}
+
+LvGLStatus Adafruit_LvGL_Glue_SD::initFileSystem(const LvGLConfig &config) {
+  clearFileCache();
+  freeHandles();
+  file_cache_free(this);
+  uint32_t bytes = config.sd_read_ahead ? config.sd_read_ahead : SD_SECTOR;
+  read_ahead = min((bytes + SD_SECTOR - 1) & ~(uint32_t)(SD_SECTOR - 1),
+                   (uint32_t)0x10000 - SD_SECTOR);
+  keep_open = config.sd_keep_open;
+  LvGLStatus status =
+      allocHandles(config.sd_handles ? config.sd_handles : SD_HANDLES);
+  if (status != LVGL_OK) {
+    return status;
+  }
+  memset(&sd_stats, 0, sizeof sd_stats);
+  cache_budget = config.sd_cache_bytes;
+  stream_bytes =
+      config.sd_stream_bytes ? config.sd_stream_bytes : SD_STREAM_BYTES;
+  stream_rows = config.sd_stream_rows ? config.sd_stream_rows : SD_STREAM_ROWS;
+
   lv_fs_drv_init(&lv_fs_drv);
   lv_fs_drv.letter = 'S';
   lv_fs_drv.open_cb = sd_open;
   lv_fs_drv.close_cb = sd_close;
   lv_fs_drv.read_cb = sd_read;
+  lv_fs_drv.write_cb = sd_write;
   lv_fs_drv.seek_cb = sd_seek;
   lv_fs_drv.tell_cb = sd_tell;
+  lv_fs_drv.dir_open_cb = sd_dir_open;
+  lv_fs_drv.dir_read_cb = sd_dir_read;
+  lv_fs_drv.dir_close_cb = sd_dir_close;
   lv_fs_drv.user_data = this;
   lv_fs_drv_register(&lv_fs_drv);
+
+  if (!stream_decoder) {
+    if (!(stream_decoder = lv_image_decoder_create())) {
+      return LVGL_ERR_ALLOC;
+    }
+    lv_image_decoder_set_info_cb(stream_decoder, stream_info);
+    lv_image_decoder_set_open_cb(stream_decoder, stream_open);
+    lv_image_decoder_set_get_area_cb(stream_decoder, stream_get_area);
+    lv_image_decoder_set_close_cb(stream_decoder, stream_close);
+    stream_decoder->user_data = this;
+  }
+
+  closeBundle();
+  return config.sd_bundle ? openBundle(config.sd_bundle) : LVGL_OK;
 }
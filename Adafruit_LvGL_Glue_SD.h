@@ -2,8 +2,56 @@
 #define _ADAFRUIT_LVGL_GLUE_SD_H
 
 #include "Adafruit_LvGL_Glue.h"
+#include "Adafruit_LvGL_Glue_Assets.h"
 #include <SdFat.h>
 
+/**
+ * @brief Running totals kept by the SD card file system driver. Zero the
+ * glue's `sd_stats` member to restart counting.
+ *
+ */
+typedef struct {
+  uint32_t reads;     ///< Reads requested by LvGL
+  uint32_t hits;      ///< Reads served entirely from the read-ahead cache
+  uint32_t sd_reads;  ///< Reads issued to the card
+  uint32_t sd_bytes;  ///< Bytes read from the card
+  uint32_t bytes;     ///< Bytes handed to LvGL
+  uint32_t cache_hits;      ///< Opens served from the file cache
+  uint32_t cache_misses;    ///< Opens that had to go to the card
+  uint32_t cache_evictions; ///< Files dropped from the cache
+  uint32_t cache_used;      ///< Bytes of file data now in the cache
+  uint32_t bundle_opens;    ///< Opens resolved through the bundle index
+  uint32_t stream_bands;    ///< Bands decoded by the streaming decoder
+  uint32_t stream_skipped;  ///< Rows decoded only to reach a later band
+  uint32_t stream_rewinds;  ///< RLE decodes restarted from the top
+  uint32_t handle_reuses;   ///< Opens that took up an idle handle's file
+  uint32_t handle_fails;    ///< Opens refused as every handle was in use
+  uint32_t writes;          ///< Writes requested by LvGL
+  uint32_t sd_writes;       ///< Writes issued to the card
+  uint32_t sd_write_bytes;  ///< Bytes written to the card
+} LvGLSDStats;
+
+// Q565 image format, as written by extras/q565.py: a compressed RGB565
+// image that the SD driver decodes a band at a time as it's drawn, reading
+// fewer bytes from the card than a raw image would. It is an LvGL .bin
+// file: lv_image_header_t (cf LV_COLOR_FORMAT_RGB565, flags
+// LV_IMAGE_FLAGS_COMPRESSED), then a compression header (uint32_t method
+// = LVGL_COMPRESS_Q565, compressed_size, decompressed_size, all
+// little-endian), then ops encoding all stride / 2 * h pixels (row padding
+// included) in order. Each op derives pixels from the previous pixel,
+// which starts at 0, and the top two bits of its first byte pick it:
+//   00nnnnnn          RUN: previous pixel, repeated n + 1 times
+//   01rrggbb          DIFF: previous pixel plus r - 2, g - 2, b - 2 in
+//                     each 5/6/5-bit channel, wrapping around
+//   10gggggg rrrrbbbb LUMA: green plus g - 32; red and blue plus
+//                     (g - 32) / 2 (rounded down) + r - 8, b - 8
+//   11nnnnnn          LITERAL: n + 1 pixels follow, 2 bytes each, little-
+//                     endian RGB565 as in a raw .bin
+// Runs and literals may cross rows.
+#define LVGL_COMPRESS_Q565 15 ///< LvGL .bin compression method of Q565
+
+struct LvGLFileCacheEntry;
+
 /**
  * @brief Class to act as a "glue" layer between the LvGL graphics library and
  * most of Adafruit's TFT displays, with added support for reading from SD card.
@@ -11,6 +59,8 @@
  */
 class Adafruit_LvGL_Glue_SD : public Adafruit_LvGL_Glue {
 public:
+  Adafruit_LvGL_Glue_SD(void);
+  ~Adafruit_LvGL_Glue_SD(void);
   LvGLStatus begin(Adafruit_SPITFT *tft, Adafruit_STMPE610 *touch, SdFat *sdFat,
                    bool debug = false);
 
@@ -19,12 +69,43 @@ public:
 
   LvGLStatus begin(Adafruit_SPITFT *tft, SdFat *sdFat, bool debug = false);
 
+  // Same, with draw buffer settings
+  LvGLStatus begin(Adafruit_SPITFT *tft, Adafruit_STMPE610 *touch, SdFat *sdFat,
+                   const LvGLConfig &config, bool debug = false);
+
+  LvGLStatus begin(Adafruit_SPITFT *tft, TouchScreen *touch, SdFat *sdFat,
+                   const LvGLConfig &config, bool debug = false);
+
+  LvGLStatus begin(Adafruit_SPITFT *tft, SdFat *sdFat,
+                   const LvGLConfig &config, bool debug = false);
+
   // The following need to be public for internal callbacks
   SdFat *sd; ///< Pointer to SD card reader
+  uint16_t read_ahead; ///< Read-ahead cache bytes per open file
+  LvGLSDStats sd_stats; ///< File system counters, see LvGLSDStats
+  uint32_t cache_budget; ///< Copy of LvGLConfig::sd_cache_bytes
+  LvGLFileCacheEntry *file_cache; ///< Cached files, most recently used first
+  void clearFileCache(void); ///< Drop cached files no one has open
+  File32 bundle;               ///< Asset pack file, if open
+  LvGLPackEntry *bundle_index; ///< Asset pack index, sorted by hash
+  char *bundle_names;          ///< Asset pack path strings
+  uint32_t bundle_count;       ///< Number of entries in bundle_index
+  uint32_t stream_bytes; ///< Copy of LvGLConfig::sd_stream_bytes
+  uint16_t stream_rows;  ///< Copy of LvGLConfig::sd_stream_rows
+  void *stream_idle;     ///< Streamed image kept open between draws
+  void *handles;         ///< Pool of file handles
+  uint8_t handle_count;  ///< Number of handles in the pool
+  bool keep_open;        ///< Copy of LvGLConfig::sd_keep_open
+  uint32_t handle_clock; ///< Orders idle handles by when they were closed
 
 private:
-  void initFileSystem();
+  LvGLStatus initFileSystem(const LvGLConfig &config);
+  LvGLStatus openBundle(const char *path);
+  void closeBundle(void);
+  LvGLStatus allocHandles(uint8_t count);
+  void freeHandles(void);
   lv_fs_drv_t lv_fs_drv;
+  lv_image_decoder_t *stream_decoder;
 };
 
 #endif //_ADAFRUIT_LVGL_GLUE_SD_H
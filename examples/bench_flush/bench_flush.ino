@@ -0,0 +1,182 @@
+// Flush-path benchmark for Adafruit_LvGL_Glue on Adafruit PyPortal.
+// Requires LittlevGL, Adafruit_LvGL_Glue, Adafruit Touchscreen,
+// Adafruit_GFX and Adafruit_ILI9341 (PyPortal, PyPortal Pynt) or
+// Adafruit_HX8357 (PyPortal Titano) libraries.
+
+// Drives a few canned LittlevGL scenes through the glue and prints one
+// line of JSON per scene to the Serial console: pixels pushed per second,
+// flush latency percentiles, SPI transactions and bytes sent per frame.
+// Also times the glue's RGB565 byte-swap against a per-pixel loop.
+// Capture the output from a release build of your sketch settings and
+// keep it around, so changes to buffer size, refresh period or the glue
+// itself can be compared against real numbers rather than guesses.
+
+#include <Adafruit_LvGL_Glue.h> // Always include this BEFORE lvgl.h!
+#include <lvgl.h>
+#include <TouchScreen.h>
+
+#define TFT_ROTATION   3 // Landscape orientation on PyPortal
+#define TFT_D0        34 // PyPortal TFT pins
+#define TFT_WR        26
+#define TFT_DC        10
+#define TFT_CS        11
+#define TFT_RST       24
+#define TFT_RD         9
+#define TFT_BACKLIGHT 25
+#define YP            A4 // PyPortal touchscreen pins
+#define XP            A5
+#define YM            A6
+#define XM            A7
+
+#define FRAMES        60 // Frames rendered per scene
+
+#if defined(ADAFRUIT_PYPORTAL_M4_TITANO)
+  #include <Adafruit_HX8357.h>
+  Adafruit_HX8357  tft(tft8bitbus, TFT_D0, TFT_WR, TFT_DC, TFT_CS, TFT_RST,
+    TFT_RD);
+#else
+  #include <Adafruit_ILI9341.h>
+  Adafruit_ILI9341 tft(tft8bitbus, TFT_D0, TFT_WR, TFT_DC, TFT_CS, TFT_RST,
+    TFT_RD);
+#endif
+TouchScreen        ts(XP, YP, XM, YM, 300);
+Adafruit_LvGL_Glue glue;
+
+lv_obj_t *list, *arc, *labels[8];
+
+// Each scene changes something on screen, once per frame
+void scene_full_screen(uint16_t frame) {
+  lv_obj_invalidate(lv_screen_active());
+}
+
+void scene_scroll_list(uint16_t frame) {
+  lv_obj_scroll_by(list, 0, (frame < FRAMES / 2) ? -8 : 8, LV_ANIM_OFF);
+}
+
+void scene_arc(uint16_t frame) {
+  lv_arc_set_value(arc, frame * 100 / FRAMES);
+}
+
+void scene_labels(uint16_t frame) {
+  for (uint8_t i = 0; i < 8; i++) {
+    lv_label_set_text_fmt(labels[i], "%u", (unsigned)(frame * 7 + i * 13));
+  }
+}
+
+// Return the bucket bound (in microseconds) below which 'pct' percent
+// of the recorded flushes completed
+uint32_t latency_percentile(const LvGLFlushStats *stats, uint8_t pct) {
+  uint32_t target = (stats->flushes * pct + 99) / 100, count = 0;
+  for (uint8_t i = 0; i < LVGL_FLUSH_HIST_BUCKETS; i++) {
+    count += stats->latency_hist[i];
+    if (count >= target) return 1UL << i;
+  }
+  return 1UL << (LVGL_FLUSH_HIST_BUCKETS - 1);
+}
+
+void run_scene(const char *name, lv_obj_t *screen,
+               void (*step)(uint16_t frame)) {
+  lv_screen_load(screen);
+  lv_refr_now(NULL);             // Get the screen change out of the way
+  glue.waitForFlush();
+  memset(&glue.flush_stats, 0, sizeof glue.flush_stats);
+
+  uint32_t start = micros();
+  for (uint16_t frame = 0; frame < FRAMES; frame++) {
+    step(frame);
+    lv_refr_now(NULL);
+  }
+  glue.waitForFlush();           // Count the last transfer too
+  uint32_t elapsed = micros() - start;
+
+  const LvGLFlushStats *s = &glue.flush_stats;
+  Serial.printf("{\"scene\":\"%s\",\"frames\":%u,\"us\":%lu,"
+                "\"pixels_per_sec\":%lu,\"flushes\":%lu,"
+                "\"transactions\":%lu,\"addr_windows\":%lu,"
+                "\"windows_saved\":%lu,"
+                "\"bytes_per_frame\":%lu,\"latency_us\":{\"p50\":%lu,"
+                "\"p90\":%lu,\"p99\":%lu}}\r\n",
+                name, FRAMES, elapsed,
+                (uint32_t)((uint64_t)s->pixels * 1000000 / elapsed),
+                s->flushes, s->transactions, s->addr_windows, s->windows_saved,
+                s->bytes / FRAMES, latency_percentile(s, 50),
+                latency_percentile(s, 90), latency_percentile(s, 99));
+}
+
+// Compare the glue's byte-swap kernel with a plain per-pixel loop
+void bench_swap(void) {
+  static uint16_t buf[4096];
+  for (uint16_t i = 0; i < 4096; i++) buf[i] = i;
+
+  uint32_t start = micros();
+  for (uint8_t n = 0; n < 16; n++) {
+    for (uint16_t i = 0; i < 4096; i++) buf[i] = __builtin_bswap16(buf[i]);
+  }
+  uint32_t scalar_us = micros() - start;
+
+  start = micros();
+  for (uint8_t n = 0; n < 16; n++) {
+    Adafruit_LvGL_Glue::swapPixels(buf, buf, 4096);
+  }
+  uint32_t glue_us = micros() - start;
+
+  Serial.printf("{\"swap_pixels\":%u,\"scalar_us\":%lu,\"glue_us\":%lu}\r\n",
+                4096 * 16, scalar_us, glue_us);
+}
+
+void setup(void) {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  // Initialize display BEFORE glue setup
+  tft.begin();
+  tft.setRotation(TFT_ROTATION);
+  pinMode(TFT_BACKLIGHT, OUTPUT);
+  digitalWrite(TFT_BACKLIGHT, HIGH);
+
+  uint32_t start = micros();
+  LvGLStatus status = glue.begin(&tft, &ts);
+  uint32_t begin_us = micros() - start;
+  if(status != LVGL_OK) {
+    Serial.printf("Glue error %d\r\n", (int)status);
+    for(;;);
+  }
+  Serial.printf("{\"begin_us\":%lu,\"width\":%d,\"height\":%d,"
+                "\"refr_period_ms\":%d}\r\n", begin_us, tft.width(),
+                tft.height(), LV_DEF_REFR_PERIOD);
+
+  // Build one screen per scene
+  lv_obj_t *full = lv_obj_create(NULL);
+  lv_obj_t *label = lv_label_create(full);
+  lv_label_set_text(label, "Full screen");
+  lv_obj_center(label);
+
+  lv_obj_t *scroll = lv_obj_create(NULL);
+  list = lv_list_create(scroll);
+  lv_obj_set_size(list, LV_PCT(100), LV_PCT(100));
+  for (uint8_t i = 0; i < 40; i++) {
+    lv_list_add_button(list, LV_SYMBOL_FILE, "List item");
+  }
+
+  lv_obj_t *spin = lv_obj_create(NULL);
+  arc = lv_arc_create(spin);
+  lv_obj_set_size(arc, 150, 150);
+  lv_obj_center(arc);
+
+  lv_obj_t *churn = lv_obj_create(NULL);
+  for (uint8_t i = 0; i < 8; i++) {
+    labels[i] = lv_label_create(churn);
+    lv_obj_set_pos(labels[i], (i & 1) * 120 + 20, (i / 2) * 40 + 20);
+  }
+
+  run_scene("full_screen", full, scene_full_screen);
+  run_scene("scroll_list", scroll, scene_scroll_list);
+  run_scene("arc", spin, scene_arc);
+  run_scene("label_churn", churn, scene_labels);
+  bench_swap();
+}
+
+void loop(void) {
+  lv_task_handler(); // Call LittleVGL task handler periodically
+  delay(5);
+}
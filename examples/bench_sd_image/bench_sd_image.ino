@@ -0,0 +1,117 @@
+// Streaming image benchmark for Adafruit_LvGL_Glue_SD on Adafruit TFT
+// FeatherWings. Requires LittlevGL, Adafruit_LvGL_Glue, Adafruit_STMPE610,
+// Adafruit_GFX, SdFat - Adafruit Fork, and Adafruit_ILI9341 (2.4" TFT) or
+// Adafruit_HX8357 (3.5") libraries.
+
+// Draws a full-screen background image from the SD card, raw, RLE- and
+// Q565-compressed, and prints one line of JSON for each: time per full
+// redraw, bytes read from the card, peak LvGL heap use, and the SD
+// driver's streaming counters. The images are bigger than LvGL's heap, so
+// they can only be drawn streamed. Convert a screen-sized picture with
+// LvGL's scripts/LVGLImage.py and this library's extras/q565.py, and copy
+// all three files to the card:
+//   LVGLImage.py --ofmt BIN --cf RGB565 bg.png
+//   LVGLImage.py --ofmt BIN --cf RGB565 --compress RLE bg.png  (as bg_rle.bin)
+//   q565.py bg.bin bg_q565.bin
+
+#define BIG_FEATHERWING 1 // Set this to 1 for 3.5" (480x320) FeatherWing!
+
+// Always include this BEFORE lvgl.h
+#include <Adafruit_LvGL_Glue_SD.h>
+#include <lvgl.h>
+#include <Adafruit_STMPE610.h>
+#include <SdFat.h>
+
+#ifdef ESP32
+#define TFT_CS   15
+#define TFT_DC   33
+#define STMPE_CS 32
+#define SD_CS    14
+#else
+#define TFT_CS    9
+#define TFT_DC   10
+#define STMPE_CS  6
+#define SD_CS     5
+#endif
+#define TFT_ROTATION 1 // Landscape orientation on FeatherWing
+#define TFT_RST     -1
+
+#define FRAMES 10 // Full redraws per image
+
+#if BIG_FEATHERWING
+#include <Adafruit_HX8357.h>
+Adafruit_HX8357 tft(TFT_CS, TFT_DC, TFT_RST);
+#else
+#include <Adafruit_ILI9341.h>
+Adafruit_ILI9341 tft(TFT_CS, TFT_DC);
+#endif
+
+Adafruit_STMPE610 ts(STMPE_CS);
+Adafruit_LvGL_Glue_SD glue;
+SdFat sd;
+
+lv_obj_t *img;
+
+void bench_image(const char *name, const char *path) {
+  lv_image_set_src(img, path);
+  lv_refr_now(NULL);
+  glue.waitForFlush();
+  memset(&glue.sd_stats, 0, sizeof glue.sd_stats);
+  lv_mem_monitor_t mem;
+  lv_mem_monitor(&mem);
+  uint32_t heap_before = mem.max_used;
+
+  uint32_t start = micros();
+  for (uint8_t frame = 0; frame < FRAMES; frame++) {
+    lv_obj_invalidate(img);
+    lv_refr_now(NULL);
+  }
+  glue.waitForFlush();
+  uint32_t elapsed = micros() - start;
+
+  lv_mem_monitor(&mem);
+  const LvGLSDStats *s = &glue.sd_stats;
+  Serial.printf("{\"image\":\"%s\",\"us_per_frame\":%lu,\"heap_peak\":%lu,"
+                "\"heap_peak_before\":%lu,\"bands\":%lu,\"rows_skipped\":%lu,"
+                "\"rewinds\":%lu,\"sd_reads\":%lu,\"sd_bytes\":%lu}\r\n",
+                name, elapsed / FRAMES, (uint32_t)mem.max_used, heap_before,
+                s->stream_bands, s->stream_skipped, s->stream_rewinds,
+                s->sd_reads, s->sd_bytes);
+}
+
+void setup(void) {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  // Initialize display and touchscreen BEFORE glue setup
+  tft.begin();
+  tft.setRotation(TFT_ROTATION);
+  if(!ts.begin()) {
+    Serial.println("Couldn't start touchscreen controller");
+    for(;;);
+  }
+
+  // SD controller needs to be initialized before starting Glue
+  if (!sd.begin(SD_CS, SD_SCK_MHZ(25))) { // ESP32 requires 25 MHz limit
+    Serial.println("Couldn't start SD card controller");
+    for(;;);
+  }
+
+  LvGLConfig config = {};
+  config.sd_read_ahead = 4096;
+  LvGLStatus status = glue.begin(&tft, &ts, &sd, config);
+  if(status != LVGL_OK) {
+    Serial.printf("Glue error %d\r\n", (int)status);
+    for(;;);
+  }
+
+  img = lv_image_create(lv_screen_active());
+  bench_image("raw", "S:bg.bin");
+  bench_image("rle", "S:bg_rle.bin");
+  bench_image("q565", "S:bg_q565.bin");
+}
+
+void loop(void) {
+  lv_task_handler(); // Call LittleVGL task handler periodically
+  delay(5);
+}
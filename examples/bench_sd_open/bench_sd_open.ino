@@ -0,0 +1,117 @@
+// SD open-latency benchmark for Adafruit_LvGL_Glue_SD on Adafruit TFT
+// FeatherWings. Requires LittlevGL, Adafruit_LvGL_Glue, Adafruit_STMPE610,
+// Adafruit_GFX, SdFat - Adafruit Fork, and Adafruit_ILI9341 (2.4" TFT) or
+// Adafruit_HX8357 (3.5") libraries.
+
+// Times lv_fs_open() + lv_fs_close() on every asset in an asset bundle,
+// first through the bundle's index and then as separate files in a
+// directory on the card, and prints one line of JSON for each.
+// Prepare the card from the same directory of assets (hundreds of small
+// files show the difference best):
+//   cp -r assets/ /sdcard/assets/
+//   python3 extras/lvpack.py --align 512 assets/ /sdcard/assets.lvpk
+
+#define BIG_FEATHERWING 1 // Set this to 1 for 3.5" (480x320) FeatherWing!
+
+// Always include this BEFORE lvgl.h
+#include <Adafruit_LvGL_Glue_SD.h>
+#include <lvgl.h>
+#include <Adafruit_STMPE610.h>
+#include <SdFat.h>
+
+#ifdef ESP32
+#define TFT_CS   15
+#define TFT_DC   33
+#define STMPE_CS 32
+#define SD_CS    14
+#else
+#define TFT_CS    9
+#define TFT_DC   10
+#define STMPE_CS  6
+#define SD_CS     5
+#endif
+#define TFT_ROTATION 1 // Landscape orientation on FeatherWing
+#define TFT_RST     -1
+
+#define BUNDLE "assets.lvpk" // Asset bundle on the card
+#define DIR    "assets/"     // Same assets, as plain files
+
+#if BIG_FEATHERWING
+#include <Adafruit_HX8357.h>
+Adafruit_HX8357 tft(TFT_CS, TFT_DC, TFT_RST);
+#else
+#include <Adafruit_ILI9341.h>
+Adafruit_ILI9341 tft(TFT_CS, TFT_DC);
+#endif
+
+Adafruit_STMPE610 ts(STMPE_CS);
+Adafruit_LvGL_Glue_SD glue;
+SdFat sd;
+
+// Open and close every asset in the bundle, with 'prefix' in front of its
+// path, and print the time taken
+void bench_open(const char *name, const char *prefix) {
+  char path[128];
+  uint32_t opened = 0, failed = 0, worst_us = 0;
+  uint32_t sd_reads = glue.sd_stats.sd_reads;
+  uint32_t start = micros();
+  for (uint32_t i = 0; i < glue.bundle_count; i++) {
+    snprintf(path, sizeof path, "S:%s%s", prefix,
+             glue.bundle_names + glue.bundle_index[i].name);
+    uint32_t t = micros();
+    lv_fs_file_t f;
+    if (lv_fs_open(&f, path, LV_FS_MODE_RD) == LV_FS_RES_OK) {
+      lv_fs_close(&f);
+      opened++;
+    } else {
+      failed++;
+    }
+    worst_us = max(worst_us, micros() - t);
+  }
+  uint32_t elapsed = micros() - start;
+  Serial.printf("{\"lookup\":\"%s\",\"assets\":%lu,\"failed\":%lu,"
+                "\"us\":%lu,\"us_per_open\":%lu,\"worst_us\":%lu,"
+                "\"sd_reads\":%lu}\r\n",
+                name, opened, failed, elapsed,
+                opened ? elapsed / opened : 0, worst_us,
+                glue.sd_stats.sd_reads - sd_reads);
+}
+
+void setup(void) {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  // Initialize display and touchscreen BEFORE glue setup
+  tft.begin();
+  tft.setRotation(TFT_ROTATION);
+  if(!ts.begin()) {
+    Serial.println("Couldn't start touchscreen controller");
+    for(;;);
+  }
+
+  // SD controller needs to be initialized before starting Glue
+  if (!sd.begin(SD_CS, SD_SCK_MHZ(25))) { // ESP32 requires 25 MHz limit
+    Serial.println("Couldn't start SD card controller");
+    for(;;);
+  }
+
+  LvGLConfig config = {};
+  config.sd_bundle = BUNDLE;
+  uint32_t start = micros();
+  LvGLStatus status = glue.begin(&tft, &ts, &sd, config);
+  uint32_t begin_us = micros() - start;
+  if(status != LVGL_OK) {
+    Serial.printf("Glue error %d\r\n", (int)status);
+    for(;;);
+  }
+  Serial.printf("{\"begin_us\":%lu,\"bundle_assets\":%lu}\r\n", begin_us,
+                glue.bundle_count);
+
+  bench_open("bundle", "");
+  bench_open("files", DIR);
+}
+
+void loop(void) {
+  lv_task_handler(); // Call LittleVGL task handler periodically
+  delay(5);
+}
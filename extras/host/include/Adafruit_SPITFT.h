@@ -0,0 +1,70 @@
+// Host stand-in for Adafruit_SPITFT: a panel in RAM, behind a model of
+// GFX's SPI DMA. writePixels() of 16 or more pixels starts a transfer that
+// stays in flight, reading its pixels only when it completes (dmaWait(),
+// or the next DMA writePixels(), which waits for it as GFX does unless
+// dma_self_wait is cleared). Anything else that touches the bus meanwhile
+// counts as a violation, as does
+// drawing outside startWrite()/endWrite() or past the address window.
+// Define HOST_NO_DMA to build the library as for a board without DMA.
+#ifndef _HOST_ADAFRUIT_SPITFT_H_
+#define _HOST_ADAFRUIT_SPITFT_H_
+
+#include <Arduino.h>
+#include <vector>
+
+#ifndef HOST_NO_DMA
+#define USE_SPI_DMA
+#endif
+
+#define HOST_DMA_MIN 16 // Shortest writePixels() GFX sends by DMA
+#if defined(USE_SPI_DMA)
+#define HOST_DMA_DEFAULT true
+#else
+#define HOST_DMA_DEFAULT false
+#endif
+
+class Adafruit_SPITFT {
+public:
+  Adafruit_SPITFT(uint16_t w, uint16_t h) { init(w, h, HOST_DMA_DEFAULT); }
+  ~Adafruit_SPITFT(void);
+  void startWrite(void);
+  void endWrite(void);
+  void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+  void writePixels(uint16_t *colors, uint32_t len, bool block = true,
+                   bool bigEndian = false);
+  void dmaWait(void);
+  bool dmaBusy(void) const;
+  int16_t width(void) const;
+  int16_t height(void) const;
+  uint8_t getRotation(void) const;
+  void setRotation(uint8_t r);
+  void fillScreen(uint16_t color);
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+
+  // Host model --------------------------------------------------------
+  uint16_t pixel(int16_t x, int16_t y) const; // In current rotation
+  bool busBusy(void) const; // Transfer in flight or transaction open
+  void violation(const char *what); // Counts one, printing the first
+  bool dma;           // Model DMA; if false, every write blocks
+  bool dma_self_wait; // DMA writePixels() waits for the one in flight
+  uint8_t bus;        // Devices on the same bus number share it
+  uint32_t violations; // Bus or window misuse, see last_violation
+  const char *last_violation;
+  uint32_t transactions, windows, dma_transfers, pio_writes, waits;
+
+private:
+  void init(uint16_t w, uint16_t h, bool dma);
+  void put(const uint16_t *colors, uint32_t len, bool bigEndian);
+  void complete(void);
+  uint16_t native_w, native_h;
+  uint8_t rotation;
+  std::vector<uint16_t> ram; // Panel memory, in the current rotation
+  bool in_write;
+  int32_t wx, wy, ww, wh, cx, cy; // Address window and write position
+  const uint16_t *dma_pixels;     // Transfer in flight, or NULL
+  uint32_t dma_len;
+  bool dma_big;
+};
+
+#endif // _HOST_ADAFRUIT_SPITFT_H_
@@ -0,0 +1,28 @@
+// Host stand-in for the STMPE610 touch controller: a FIFO the test fills.
+// It sits on display bus 0, so reading it while a display transfer is in
+// flight counts as a violation on that display.
+#ifndef _HOST_ADAFRUIT_STMPE610_H_
+#define _HOST_ADAFRUIT_STMPE610_H_
+
+#include <Arduino.h>
+#include <deque>
+
+class TS_Point {
+public:
+  TS_Point(void) : x(0), y(0), z(0) {}
+  TS_Point(int16_t x, int16_t y, int16_t z) : x(x), y(y), z(z) {}
+  int16_t x, y, z;
+};
+
+class Adafruit_STMPE610 {
+public:
+  uint8_t bufferSize(void);
+  TS_Point getPoint(void);
+  bool touched(void);
+
+  // Host model
+  std::deque<TS_Point> fifo; // Points waiting, oldest first
+  uint32_t reads = 0;        // getPoint() calls
+};
+
+#endif // _HOST_ADAFRUIT_STMPE610_H_
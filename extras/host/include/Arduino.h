@@ -0,0 +1,31 @@
+// Host stand-in for the Arduino core: only what the library uses. Time
+// doesn't pass on its own; tests move it on with host_advance().
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(ESP32)
+#include <FreeRTOS.h> // As the ESP32 core brings in
+#endif
+
+using std::max;
+using std::min;
+
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+
+class HostSerial {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  size_t print(const char *s);
+  size_t println(const char *s);
+};
+extern HostSerial Serial;
+
+#endif // _HOST_ARDUINO_H_
@@ -0,0 +1,70 @@
+// Host stand-in for the FreeRTOS API that the ESP32 Arduino core brings in
+// through Arduino.h: only what the library uses. Nothing runs on its own:
+// creating a task records it, and a test runs a task's steps itself, with
+// host_task_current saying whose turn it is. A mutex taken while another
+// task holds it would block forever here, so it counts a violation instead.
+#ifndef _HOST_FREERTOS_H_
+#define _HOST_FREERTOS_H_
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFF
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms) / portTICK_PERIOD_MS)
+#define configMAX_PRIORITIES 25
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define portNUM_PROCESSORS host_cores // Set by tests: 1 for an S2 or C3
+
+struct HostTask {
+  const char *name;
+  TaskFunction_t fn;
+  void *arg;
+  uint32_t stack;       // Bytes, as ESP-IDF counts
+  UBaseType_t priority;
+  BaseType_t core;      // tskNO_AFFINITY if not pinned
+  uint32_t notified;    // Notifications pending, see ulTaskNotifyTake()
+  uint32_t notifies;    // Notifications given, ever
+  uint32_t stack_free;  // For uxTaskGetStackHighWaterMark()
+};
+typedef HostTask *TaskHandle_t;
+
+struct HostMutex {
+  TaskHandle_t holder; // NULL if free
+};
+typedef HostMutex *SemaphoreHandle_t;
+
+extern BaseType_t host_cores;
+extern TaskHandle_t host_task_current; // Defaults to the sketch's loop task
+extern uint32_t host_task_violations;  // Takes of a mutex held elsewhere
+extern bool host_task_fail;            // Make the next task creation fail
+
+TaskHandle_t host_task_find(const char *name); // Latest live task so named
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+                                   uint32_t stack, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *task,
+                                   BaseType_t core);
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack,
+                       void *arg, UBaseType_t priority, TaskHandle_t *task);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex);
+void vSemaphoreDelete(SemaphoreHandle_t mutex);
+
+#endif // _HOST_FREERTOS_H_
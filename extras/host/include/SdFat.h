@@ -0,0 +1,48 @@
+// Host stand-in for SdFat: a card held in memory (see host.h). The card
+// sits on display bus 0, so any access while a display transfer is in
+// flight, or its transaction is open, counts as a violation on that
+// display.
+#ifndef _HOST_SDFAT_H_
+#define _HOST_SDFAT_H_
+
+#include <Arduino.h>
+
+#define O_RDONLY 0x00
+#define O_WRONLY 0x01
+#define O_RDWR 0x02
+#define O_ACCMODE 0x03
+#define O_APPEND 0x08
+#define O_CREAT 0x10
+#define O_TRUNC 0x20
+#define O_READ O_RDONLY
+#define O_WRITE O_WRONLY
+typedef int oflag_t;
+
+class File32 {
+public:
+  File32(void) : node(-1), pos(0), flags(0), next(0) {}
+  bool isOpen(void) const { return node >= 0; }
+  bool isDir(void) const;
+  bool seek(uint32_t pos);
+  int read(void *buf, size_t count);
+  size_t write(const void *buf, size_t count);
+  uint32_t curPosition(void) const { return pos; }
+  uint32_t fileSize(void) const;
+  bool openNext(File32 *dir, oflag_t oflag = O_RDONLY);
+  size_t getName(char *name, size_t size);
+  bool close(void);
+
+private:
+  friend class SdFat;
+  int node; // Index of the file on the host card, -1 if not open
+  uint32_t pos;
+  oflag_t flags;
+  uint32_t next; // Directories: index of the next entry for openNext()
+};
+
+class SdFat {
+public:
+  File32 open(const char *path, oflag_t oflag = O_RDONLY);
+};
+
+#endif // _HOST_SDFAT_H_
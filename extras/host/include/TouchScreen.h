@@ -0,0 +1,29 @@
+// Host stand-in for the ADC TouchScreen library: getPoint() returns
+// whatever the test last put in `point`
+#ifndef _HOST_TOUCHSCREEN_H_
+#define _HOST_TOUCHSCREEN_H_
+
+#include <Arduino.h>
+
+class TSPoint {
+public:
+  TSPoint(void) : x(0), y(0), z(0) {}
+  TSPoint(int16_t x, int16_t y, int16_t z) : x(x), y(y), z(z) {}
+  int16_t x, y, z;
+};
+
+class TouchScreen {
+public:
+  TouchScreen(void) : pressureThreshhold(10), reads(0) {}
+  TSPoint getPoint(void) {
+    reads++;
+    return point;
+  }
+  int16_t pressureThreshhold;
+
+  // Host model
+  TSPoint point;  // Next reading
+  uint32_t reads; // getPoint() calls
+};
+
+#endif // _HOST_TOUCHSCREEN_H_
@@ -0,0 +1,372 @@
+// Host stand-in for LvGL 9: the parts of its API the library and the host
+// tests use, with the same names and signatures. Rendering is modelled,
+// not done: a refresh copies each display's scene (see host.h) into the
+// draw buffers, band by band as LvGL would, and calls the flush callbacks.
+#ifndef _HOST_LVGL_H_
+#define _HOST_LVGL_H_
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LVGL_VERSION_MAJOR 9
+#define LVGL_VERSION_MINOR 2
+#define LV_COLOR_DEPTH 16
+#define LV_USE_LOG 1
+#define LV_USE_LABEL 1
+#define LV_USE_TEXTAREA 1
+#define LV_USE_BAR 1
+#define LV_USE_ARC 1
+#define LV_DEF_REFR_PERIOD 33
+#define LV_INDEV_DEF_READ_PERIOD 30
+#define LV_NO_TIMER_READY 0xFFFFFFFF
+#define LV_COORD_MIN (-536870911)
+#define LV_ANIM_OFF 0
+
+static inline void lv_log_discard(const char *format, ...) { (void)format; }
+#define LV_LOG_ERROR(...) lv_log_discard(__VA_ARGS__)
+#define LV_LOG_WARN(...) lv_log_discard(__VA_ARGS__)
+#define LV_LOG_INFO(...) lv_log_discard(__VA_ARGS__)
+
+typedef int32_t lv_coord_t;
+typedef enum { LV_RESULT_INVALID = 0, LV_RESULT_OK } lv_result_t;
+
+typedef struct {
+  int32_t x1, y1, x2, y2;
+} lv_area_t;
+
+typedef struct {
+  int32_t x, y;
+} lv_point_t;
+
+static inline int32_t lv_area_get_width(const lv_area_t *a) {
+  return a->x2 - a->x1 + 1;
+}
+static inline int32_t lv_area_get_height(const lv_area_t *a) {
+  return a->y2 - a->y1 + 1;
+}
+
+// Core ----------------------------------------------------------------
+
+typedef int8_t lv_log_level_t;
+typedef void (*lv_log_print_g_cb_t)(lv_log_level_t level, const char *buf);
+typedef uint32_t (*lv_tick_get_cb_t)(void);
+
+void lv_init(void);
+bool lv_is_initialized(void);
+void lv_log_register_print_cb(lv_log_print_g_cb_t print_cb);
+void lv_tick_set_cb(lv_tick_get_cb_t cb);
+void lv_tick_inc(uint32_t tick_period);
+uint32_t lv_tick_get(void);
+
+typedef struct _lv_timer_t lv_timer_t;
+typedef void (*lv_timer_cb_t)(lv_timer_t *timer);
+lv_timer_t *lv_timer_create(lv_timer_cb_t cb, uint32_t period,
+                            void *user_data);
+void lv_timer_delete(lv_timer_t *timer);
+void *lv_timer_get_user_data(lv_timer_t *timer);
+uint32_t lv_timer_handler(void);
+static inline uint32_t lv_task_handler(void) { return lv_timer_handler(); }
+
+// Objects -------------------------------------------------------------
+
+typedef struct _lv_obj_class_t lv_obj_class_t;
+struct _lv_obj_class_t {
+  const lv_obj_class_t *base_class;
+  const char *name;
+};
+extern const lv_obj_class_t lv_obj_class, lv_label_class, lv_textarea_class,
+    lv_bar_class, lv_slider_class, lv_arc_class;
+
+typedef struct _lv_obj_t lv_obj_t;
+bool lv_obj_is_valid(const lv_obj_t *obj);
+bool lv_obj_has_class(const lv_obj_t *obj, const lv_obj_class_t *class_p);
+void lv_obj_invalidate(const lv_obj_t *obj);
+void lv_obj_delete(lv_obj_t *obj);
+lv_obj_t *lv_label_create(lv_obj_t *parent);
+void lv_label_set_text(lv_obj_t *obj, const char *text);
+const char *lv_label_get_text(const lv_obj_t *obj);
+lv_obj_t *lv_textarea_create(lv_obj_t *parent);
+void lv_textarea_set_text(lv_obj_t *obj, const char *text);
+const char *lv_textarea_get_text(const lv_obj_t *obj);
+lv_obj_t *lv_bar_create(lv_obj_t *parent);
+lv_obj_t *lv_slider_create(lv_obj_t *parent);
+void lv_bar_set_value(lv_obj_t *obj, int32_t value, int anim);
+int32_t lv_bar_get_value(const lv_obj_t *obj);
+lv_obj_t *lv_arc_create(lv_obj_t *parent);
+void lv_arc_set_value(lv_obj_t *obj, int32_t value);
+int32_t lv_arc_get_value(const lv_obj_t *obj);
+
+// Events --------------------------------------------------------------
+
+typedef enum {
+  LV_EVENT_ALL = 0,
+  LV_EVENT_INVALIDATE_AREA = 40,
+} lv_event_code_t;
+
+typedef struct _lv_event_t lv_event_t;
+typedef void (*lv_event_cb_t)(lv_event_t *e);
+lv_event_code_t lv_event_get_code(lv_event_t *e);
+void *lv_event_get_target(lv_event_t *e);
+void *lv_event_get_param(lv_event_t *e);
+void *lv_event_get_user_data(lv_event_t *e);
+
+// Display -------------------------------------------------------------
+
+typedef enum {
+  LV_DISPLAY_RENDER_MODE_PARTIAL,
+  LV_DISPLAY_RENDER_MODE_DIRECT,
+  LV_DISPLAY_RENDER_MODE_FULL
+} lv_display_render_mode_t;
+
+typedef struct _lv_display_t lv_display_t;
+typedef void (*lv_display_flush_cb_t)(lv_display_t *disp,
+                                      const lv_area_t *area, uint8_t *px_map);
+typedef void (*lv_display_flush_wait_cb_t)(lv_display_t *disp);
+
+lv_display_t *lv_display_create(int32_t hor_res, int32_t ver_res);
+void lv_display_delete(lv_display_t *disp);
+void lv_display_set_default(lv_display_t *disp);
+lv_display_t *lv_display_get_default(void);
+void lv_display_set_flush_cb(lv_display_t *disp,
+                             lv_display_flush_cb_t flush_cb);
+void lv_display_set_flush_wait_cb(lv_display_t *disp,
+                                  lv_display_flush_wait_cb_t wait_cb);
+void lv_display_set_buffers(lv_display_t *disp, void *buf1, void *buf2,
+                            uint32_t buf_size,
+                            lv_display_render_mode_t render_mode);
+void lv_display_set_user_data(lv_display_t *disp, void *user_data);
+void *lv_display_get_user_data(lv_display_t *disp);
+void lv_display_flush_ready(lv_display_t *disp);
+bool lv_display_flush_is_last(lv_display_t *disp);
+int32_t lv_display_get_horizontal_resolution(const lv_display_t *disp);
+int32_t lv_display_get_vertical_resolution(const lv_display_t *disp);
+void lv_display_add_event_cb(lv_display_t *disp, lv_event_cb_t event_cb,
+                             lv_event_code_t filter, void *user_data);
+lv_obj_t *lv_display_get_screen_active(lv_display_t *disp);
+lv_obj_t *lv_screen_active(void);
+void lv_refr_now(lv_display_t *disp);
+#define lv_disp_flush_ready lv_display_flush_ready
+
+// Input devices -------------------------------------------------------
+
+typedef enum {
+  LV_INDEV_STATE_RELEASED = 0,
+  LV_INDEV_STATE_PRESSED
+} lv_indev_state_t;
+#define LV_INDEV_STATE_REL LV_INDEV_STATE_RELEASED
+#define LV_INDEV_STATE_PR LV_INDEV_STATE_PRESSED
+
+typedef enum {
+  LV_INDEV_TYPE_NONE,
+  LV_INDEV_TYPE_POINTER,
+} lv_indev_type_t;
+
+typedef enum {
+  LV_INDEV_MODE_NONE,
+  LV_INDEV_MODE_TIMER,
+  LV_INDEV_MODE_EVENT
+} lv_indev_mode_t;
+
+typedef struct {
+  lv_point_t point;
+  lv_indev_state_t state;
+  bool continue_reading;
+} lv_indev_data_t;
+
+typedef struct _lv_indev_t lv_indev_t;
+typedef void (*lv_indev_read_cb_t)(lv_indev_t *indev, lv_indev_data_t *data);
+lv_indev_t *lv_indev_create(void);
+void lv_indev_delete(lv_indev_t *indev);
+lv_indev_t *lv_indev_get_next(lv_indev_t *indev);
+void lv_indev_set_type(lv_indev_t *indev, lv_indev_type_t type);
+void lv_indev_set_read_cb(lv_indev_t *indev, lv_indev_read_cb_t read_cb);
+lv_indev_read_cb_t lv_indev_get_read_cb(lv_indev_t *indev);
+void lv_indev_set_user_data(lv_indev_t *indev, void *user_data);
+void *lv_indev_get_user_data(const lv_indev_t *indev);
+void lv_indev_set_display(lv_indev_t *indev, lv_display_t *disp);
+void lv_indev_set_mode(lv_indev_t *indev, lv_indev_mode_t mode);
+lv_indev_mode_t lv_indev_get_mode(lv_indev_t *indev);
+void lv_indev_read(lv_indev_t *indev);
+
+// File system ---------------------------------------------------------
+
+typedef enum {
+  LV_FS_RES_OK = 0,
+  LV_FS_RES_HW_ERR,
+  LV_FS_RES_FS_ERR,
+  LV_FS_RES_NOT_EX,
+  LV_FS_RES_FULL,
+  LV_FS_RES_LOCKED,
+  LV_FS_RES_DENIED,
+  LV_FS_RES_BUSY,
+  LV_FS_RES_TOUT,
+  LV_FS_RES_NOT_IMP,
+  LV_FS_RES_OUT_OF_MEM,
+  LV_FS_RES_INV_PARAM,
+  LV_FS_RES_UNKNOWN,
+} lv_fs_res_t;
+
+typedef enum { LV_FS_MODE_WR = 0x01, LV_FS_MODE_RD = 0x02 } lv_fs_mode_t;
+
+typedef enum {
+  LV_FS_SEEK_SET = 0x00,
+  LV_FS_SEEK_CUR = 0x01,
+  LV_FS_SEEK_END = 0x02,
+} lv_fs_whence_t;
+
+typedef struct lv_fs_drv_t lv_fs_drv_t;
+struct lv_fs_drv_t {
+  char letter;
+  uint32_t cache_size;
+  bool (*ready_cb)(lv_fs_drv_t *drv);
+  void *(*open_cb)(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode);
+  lv_fs_res_t (*close_cb)(lv_fs_drv_t *drv, void *file_p);
+  lv_fs_res_t (*read_cb)(lv_fs_drv_t *drv, void *file_p, void *buf,
+                         uint32_t btr, uint32_t *br);
+  lv_fs_res_t (*write_cb)(lv_fs_drv_t *drv, void *file_p, const void *buf,
+                          uint32_t btw, uint32_t *bw);
+  lv_fs_res_t (*seek_cb)(lv_fs_drv_t *drv, void *file_p, uint32_t pos,
+                         lv_fs_whence_t whence);
+  lv_fs_res_t (*tell_cb)(lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p);
+  void *(*dir_open_cb)(lv_fs_drv_t *drv, const char *path);
+  lv_fs_res_t (*dir_read_cb)(lv_fs_drv_t *drv, void *rddir_p, char *fn,
+                             uint32_t fn_len);
+  lv_fs_res_t (*dir_close_cb)(lv_fs_drv_t *drv, void *rddir_p);
+  void *user_data;
+};
+
+typedef struct {
+  void *file_d;
+  lv_fs_drv_t *drv;
+} lv_fs_file_t;
+
+typedef struct {
+  void *dir_d;
+  lv_fs_drv_t *drv;
+} lv_fs_dir_t;
+
+void lv_fs_drv_init(lv_fs_drv_t *drv);
+void lv_fs_drv_register(lv_fs_drv_t *drv);
+lv_fs_res_t lv_fs_open(lv_fs_file_t *file_p, const char *path,
+                       lv_fs_mode_t mode);
+lv_fs_res_t lv_fs_close(lv_fs_file_t *file_p);
+lv_fs_res_t lv_fs_read(lv_fs_file_t *file_p, void *buf, uint32_t btr,
+                       uint32_t *br);
+lv_fs_res_t lv_fs_write(lv_fs_file_t *file_p, const void *buf, uint32_t btw,
+                        uint32_t *bw);
+lv_fs_res_t lv_fs_seek(lv_fs_file_t *file_p, uint32_t pos,
+                       lv_fs_whence_t whence);
+lv_fs_res_t lv_fs_tell(lv_fs_file_t *file_p, uint32_t *pos);
+lv_fs_res_t lv_fs_dir_open(lv_fs_dir_t *rddir_p, const char *path);
+lv_fs_res_t lv_fs_dir_read(lv_fs_dir_t *rddir_p, char *fn, uint32_t fn_len);
+lv_fs_res_t lv_fs_dir_close(lv_fs_dir_t *rddir_p);
+
+// Images --------------------------------------------------------------
+
+#define LV_IMAGE_HEADER_MAGIC 0x19
+#define LV_IMAGE_FLAGS_COMPRESSED 0x0008
+#define LV_STRIDE_AUTO 0
+
+typedef uint8_t lv_color_format_t;
+#define LV_COLOR_FORMAT_UNKNOWN 0x00
+#define LV_COLOR_FORMAT_RGB565 0x12
+
+typedef struct {
+  uint32_t magic : 8;
+  uint32_t cf : 8;
+  uint32_t flags : 16;
+  uint32_t w : 16;
+  uint32_t h : 16;
+  uint32_t stride : 16;
+  uint32_t reserved_2 : 16;
+} lv_image_header_t;
+
+typedef struct {
+  lv_image_header_t header;
+  uint32_t data_size;
+  const uint8_t *data;
+  const void *reserved;
+} lv_image_dsc_t;
+
+typedef struct {
+  lv_image_header_t header;
+  uint32_t data_size;
+  uint8_t *data;
+  void *unaligned_data;
+} lv_draw_buf_t;
+
+lv_result_t lv_draw_buf_init(lv_draw_buf_t *draw_buf, uint32_t w, uint32_t h,
+                             lv_color_format_t cf, uint32_t stride,
+                             void *data, uint32_t data_size);
+
+typedef enum {
+  LV_IMAGE_SRC_VARIABLE,
+  LV_IMAGE_SRC_FILE,
+  LV_IMAGE_SRC_SYMBOL,
+  LV_IMAGE_SRC_UNKNOWN,
+} lv_image_src_t;
+lv_image_src_t lv_image_src_get_type(const void *src);
+
+typedef struct _lv_image_decoder_t lv_image_decoder_t;
+
+typedef struct {
+  bool stride_auto;
+  bool premultiply;
+  bool no_cache;
+  bool use_indexed;
+  bool flush_cache;
+} lv_image_decoder_args_t;
+
+typedef struct {
+  lv_image_decoder_t *decoder;
+  lv_image_decoder_args_t args;
+  const void *src;
+  lv_image_src_t src_type;
+  lv_fs_file_t file;
+  lv_image_header_t header;
+  const lv_draw_buf_t *decoded;
+  const char *error_msg;
+  void *user_data;
+} lv_image_decoder_dsc_t;
+
+typedef lv_result_t (*lv_image_decoder_info_f_t)(
+    lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc,
+    lv_image_header_t *header);
+typedef lv_result_t (*lv_image_decoder_open_f_t)(lv_image_decoder_t *decoder,
+                                                 lv_image_decoder_dsc_t *dsc);
+typedef lv_result_t (*lv_image_decoder_get_area_cb_t)(
+    lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc,
+    const lv_area_t *full_area, lv_area_t *decoded_area);
+typedef void (*lv_image_decoder_close_f_t)(lv_image_decoder_t *decoder,
+                                           lv_image_decoder_dsc_t *dsc);
+
+struct _lv_image_decoder_t {
+  lv_image_decoder_info_f_t info_cb;
+  lv_image_decoder_open_f_t open_cb;
+  lv_image_decoder_get_area_cb_t get_area_cb;
+  lv_image_decoder_close_f_t close_cb;
+  const char *name;
+  void *user_data;
+};
+
+lv_image_decoder_t *lv_image_decoder_create(void);
+void lv_image_decoder_delete(lv_image_decoder_t *decoder);
+void lv_image_decoder_set_info_cb(lv_image_decoder_t *decoder,
+                                  lv_image_decoder_info_f_t info_cb);
+void lv_image_decoder_set_open_cb(lv_image_decoder_t *decoder,
+                                  lv_image_decoder_open_f_t open_cb);
+void lv_image_decoder_set_get_area_cb(lv_image_decoder_t *decoder,
+                                      lv_image_decoder_get_area_cb_t cb);
+void lv_image_decoder_set_close_cb(lv_image_decoder_t *decoder,
+                                   lv_image_decoder_close_f_t close_cb);
+lv_result_t lv_image_decoder_open(lv_image_decoder_dsc_t *dsc,
+                                  const void *src,
+                                  const lv_image_decoder_args_t *args);
+lv_result_t lv_image_decoder_get_area(lv_image_decoder_dsc_t *dsc,
+                                      const lv_area_t *full_area,
+                                      lv_area_t *decoded_area);
+void lv_image_decoder_close(lv_image_decoder_dsc_t *dsc);
+
+#endif // _HOST_LVGL_H_
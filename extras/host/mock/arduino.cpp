@@ -0,0 +1,48 @@
+// Arduino core stand-in: a clock that only moves when told to, which may
+// be from another thread than the one reading it
+#include "host.h"
+#include <atomic>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+HostSerial Serial;
+int host_failures = 0;
+void (*host_on_delay)(void) = NULL;
+static std::atomic<uint64_t> host_us(1000000); // Past zero, as on a board
+
+uint32_t millis(void) { return host_us / 1000; }
+
+uint32_t micros(void) { return (uint32_t)host_us; }
+
+void delay(uint32_t ms) {
+  host_advance(ms);
+  if (host_on_delay) {
+    host_on_delay();
+  }
+}
+
+void host_advance(uint32_t ms) { host_us += (uint64_t)ms * 1000; }
+
+void host_advance_us(uint32_t us) { host_us += us; }
+
+size_t HostSerial::print(const char *s) { return fputs(s, stdout) >= 0; }
+
+size_t HostSerial::println(const char *s) { return puts(s) >= 0; }
+
+size_t host_heap_used(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  return mallinfo2().uordblks;
+#else
+  return 0;
+#endif
+}
+
+int host_result(const char *test) {
+  if (host_failures) {
+    fprintf(stderr, "%s: %d check(s) failed\n", test, host_failures);
+    return 1;
+  }
+  printf("%s: ok\n", test);
+  return 0;
+}
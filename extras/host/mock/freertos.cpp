@@ -0,0 +1,95 @@
+// FreeRTOS stand-in, see include/FreeRTOS.h: tasks are records, and a
+// test steps them itself
+#include "host.h"
+#include <FreeRTOS.h>
+#include <string.h>
+#include <vector>
+
+static HostTask loop_task = {"loopTask", NULL, NULL, 8192, 1, 1, 0, 0, 4096};
+
+BaseType_t host_cores = 2;
+TaskHandle_t host_task_current = &loop_task;
+uint32_t host_task_violations = 0;
+bool host_task_fail = false;
+static std::vector<TaskHandle_t> tasks; // Created and not deleted
+
+TaskHandle_t host_task_find(const char *name) {
+  for (auto it = tasks.rbegin(); it != tasks.rend(); ++it) {
+    if (!strcmp((*it)->name, name)) {
+      return *it;
+    }
+  }
+  return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+                                   uint32_t stack, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *task,
+                                   BaseType_t core) {
+  if (host_task_fail) {
+    host_task_fail = false;
+    return pdFAIL;
+  }
+  // A real task's high water mark also depends on what it ran; half will
+  // do for tests
+  *task = new HostTask{name, fn, arg, stack, priority, core, 0, 0, stack / 2};
+  tasks.push_back(*task);
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack,
+                       void *arg, UBaseType_t priority, TaskHandle_t *task) {
+  return xTaskCreatePinnedToCore(fn, name, stack, arg, priority, task,
+                                 tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (task == host_task_current) {
+    host_task_current = &loop_task;
+  }
+  tasks.erase(std::find(tasks.begin(), tasks.end(), task));
+  delete task;
+}
+
+void vTaskDelay(TickType_t ticks) { host_advance(ticks * portTICK_PERIOD_MS); }
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return host_task_current; }
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  task->notified++;
+  task->notifies++;
+  return pdPASS;
+}
+
+// Doesn't block: returns what was pending, as a task woken by it would
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+  uint32_t notified = host_task_current->notified;
+  if (notified) {
+    host_task_current->notified = clear ? 0 : notified - 1;
+  }
+  return notified;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  return task->stack_free;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return new HostMutex{NULL}; }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks) {
+  if (mutex->holder) {
+    host_task_violations++; // Would wait for a task that isn't running
+  }
+  mutex->holder = host_task_current;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+  if (mutex->holder != host_task_current) {
+    host_task_violations++; // Not the holder's to give
+  }
+  mutex->holder = NULL;
+  return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t mutex) { delete mutex; }
@@ -0,0 +1,88 @@
+// Host test harness: what tests use to drive the stand-ins for the Arduino
+// core, GFX, the touch controllers, SdFat and LvGL (see include/), and to
+// check the results.
+#ifndef _HOST_H_
+#define _HOST_H_
+
+#include <Adafruit_SPITFT.h>
+#include <Arduino.h>
+#include <lvgl.h>
+#include <vector>
+
+// Checks ---------------------------------------------------------------
+
+extern int host_failures;
+
+#define CHECK(cond)                                                          \
+  do {                                                                       \
+    if (!(cond)) {                                                           \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,       \
+              #cond);                                                        \
+      host_failures++;                                                       \
+    }                                                                        \
+  } while (0)
+
+// Prints a summary; the test's exit status
+int host_result(const char *test);
+
+// Bytes of heap in use, for leak checks; 0 where the C library can't tell
+size_t host_heap_used(void);
+
+// Time -----------------------------------------------------------------
+
+void host_advance(uint32_t ms);    // Move millis() (and micros()) on
+void host_advance_us(uint32_t us); // Move micros() (and millis()) on
+extern void (*host_on_delay)(void); // Called by delay(), e.g. to feed touch
+
+// Shared bus -----------------------------------------------------------
+
+// Counts a violation on each display on 'bus' that has a transfer in flight
+// or a transaction open. Called by the SD card and STMPE610 stand-ins.
+void host_bus_check(uint8_t bus, const char *who);
+
+// LvGL -----------------------------------------------------------------
+
+// What LvGL draws on a display: hor x ver RGB565 pixels, row by row. A
+// refresh copies the invalidated areas of this into the draw buffers.
+uint16_t *host_scene(lv_display_t *disp);
+
+// Invalidates an area, as a widget changing would; the next
+// lv_timer_handler() or lv_refr_now() redraws it
+void host_invalidate(lv_display_t *disp, int32_t x1, int32_t y1, int32_t x2,
+                     int32_t y2);
+
+typedef struct {
+  uint32_t refreshes;     // Refreshes that drew something
+  uint32_t flushes;       // flush_cb calls
+  uint32_t flush_waits;   // flush_wait_cb calls
+  uint32_t flush_readies; // lv_display_flush_ready() calls
+  uint32_t stray_readies; // Of those, with no flush handed over
+  uint32_t hazards; // Renders into a buffer still handed over for flushing
+} HostDisplayStats;
+HostDisplayStats *host_display_stats(lv_display_t *disp);
+
+// Times an object was invalidated, e.g. by a posted command
+uint32_t host_obj_invalidations(const lv_obj_t *obj);
+
+// Readings LvGL took from an input device, oldest first
+const std::vector<lv_indev_data_t> &host_indev_log(lv_indev_t *indev);
+
+// SD card --------------------------------------------------------------
+
+typedef struct {
+  uint32_t opens;       // Files and directories opened
+  uint32_t closes;      // Of those, closed
+  uint32_t reads;       // read() calls
+  uint32_t read_bytes;  // Bytes read
+  uint32_t small_reads; // read() calls for less than a 512-byte sector
+  uint32_t writes;      // write() calls
+  uint32_t write_bytes; // Bytes written
+} HostSDStats;
+extern HostSDStats host_sd;
+
+void host_sd_reset(void); // Empty card, zeroed host_sd
+void host_sd_put(const char *path, const void *data, size_t len);
+bool host_sd_get(const char *path, std::vector<uint8_t> *data);
+void host_sd_mkdir(const char *path);
+
+#endif // _HOST_H_
@@ -0,0 +1,983 @@
+// LvGL stand-in, see include/lvgl.h. The refresh, flush and buffer logic
+// follows LvGL 9.2's lv_refr.c closely, since that is what the glue's flush
+// pipeline has to get along with; widgets only keep their values.
+#include "host.h"
+#include <string>
+
+struct _lv_timer_t {
+  lv_timer_cb_t cb;
+  uint32_t period;
+  uint32_t last;
+  void *user_data;
+};
+
+struct _lv_event_t {
+  lv_event_code_t code;
+  void *target;
+  void *param;
+  void *user_data;
+};
+
+struct _lv_obj_t {
+  const lv_obj_class_t *class_p;
+  lv_display_t *disp;
+  std::string text;
+  int32_t value;
+  uint32_t invalidations;
+};
+
+struct HostEventDsc {
+  lv_event_cb_t cb;
+  lv_event_code_t filter;
+  void *user_data;
+};
+
+struct HostArea {
+  lv_area_t area;
+  bool joined;
+};
+
+struct _lv_display_t {
+  int32_t hor, ver;
+  lv_display_flush_cb_t flush_cb;
+  lv_display_flush_wait_cb_t wait_cb;
+  void *user_data;
+  uint8_t *buf[2];
+  uint32_t buf_size;
+  uint8_t *buf_act;
+  uint8_t *buf_flushing;   // Buffer last handed to flush_cb
+  lv_area_t area_flushing; // and the area in it
+  lv_display_render_mode_t mode;
+  std::vector<HostEventDsc> events;
+  std::vector<HostArea> inv;
+  bool synced; // DIRECT double-buffered: a refresh is left to sync from
+  volatile bool flushing, flushing_last;
+  bool last_area, last_part;
+  uint32_t last_refr;
+  lv_obj_t *screen;
+  std::vector<uint16_t> scene;
+  HostDisplayStats stats;
+};
+
+struct _lv_indev_t {
+  lv_indev_type_t type;
+  lv_indev_read_cb_t read_cb;
+  void *user_data;
+  lv_display_t *disp;
+  lv_indev_mode_t mode;
+  uint32_t last_read;
+  std::vector<lv_indev_data_t> log;
+};
+
+const lv_obj_class_t lv_obj_class = {NULL, "obj"};
+const lv_obj_class_t lv_label_class = {&lv_obj_class, "label"};
+const lv_obj_class_t lv_textarea_class = {&lv_obj_class, "textarea"};
+const lv_obj_class_t lv_bar_class = {&lv_obj_class, "bar"};
+const lv_obj_class_t lv_slider_class = {&lv_bar_class, "slider"};
+const lv_obj_class_t lv_arc_class = {&lv_obj_class, "arc"};
+
+#define LV_INV_BUF_SIZE 32 // As in lv_conf_internal.h
+
+static bool initialized;
+static lv_tick_get_cb_t tick_cb;
+static uint32_t tick_count;
+static std::vector<lv_timer_t *> timers;
+static std::vector<lv_display_t *> displays;
+static std::vector<lv_indev_t *> indevs;
+static std::vector<lv_obj_t *> objs;
+static std::vector<lv_fs_drv_t *> fs_drvs;          // Newest first
+static std::vector<lv_image_decoder_t *> decoders; // Newest first
+static lv_display_t *disp_def;
+
+// LvGL's heap: timers still running at exit (the glue's shared one is
+// never deleted) go with it, rather than showing up as leaks
+static struct HostHeap {
+  ~HostHeap(void) {
+    for (lv_timer_t *timer : timers) {
+      delete timer;
+    }
+  }
+} host_heap;
+
+template <typename T> static void host_erase(std::vector<T> &v, T item) {
+  auto it = std::find(v.begin(), v.end(), item);
+  if (it != v.end()) {
+    v.erase(it);
+  }
+}
+
+// Core ----------------------------------------------------------------
+
+void lv_init(void) { initialized = true; }
+
+bool lv_is_initialized(void) { return initialized; }
+
+void lv_log_register_print_cb(lv_log_print_g_cb_t print_cb) {}
+
+void lv_tick_set_cb(lv_tick_get_cb_t cb) { tick_cb = cb; }
+
+void lv_tick_inc(uint32_t tick_period) { tick_count += tick_period; }
+
+uint32_t lv_tick_get(void) { return tick_cb ? tick_cb() : tick_count; }
+
+lv_timer_t *lv_timer_create(lv_timer_cb_t cb, uint32_t period,
+                            void *user_data) {
+  lv_timer_t *timer = new lv_timer_t{cb, period, lv_tick_get(), user_data};
+  timers.push_back(timer);
+  return timer;
+}
+
+void lv_timer_delete(lv_timer_t *timer) {
+  host_erase(timers, timer);
+  delete timer;
+}
+
+void *lv_timer_get_user_data(lv_timer_t *timer) { return timer->user_data; }
+
+// Areas ---------------------------------------------------------------
+
+static uint32_t area_size(const lv_area_t *a) {
+  return (uint32_t)lv_area_get_width(a) * lv_area_get_height(a);
+}
+
+static bool area_intersect(lv_area_t *res, const lv_area_t *a,
+                           const lv_area_t *b) {
+  res->x1 = max(a->x1, b->x1);
+  res->y1 = max(a->y1, b->y1);
+  res->x2 = min(a->x2, b->x2);
+  res->y2 = min(a->y2, b->y2);
+  return (res->x1 <= res->x2) && (res->y1 <= res->y2);
+}
+
+static bool area_is_in(const lv_area_t *in, const lv_area_t *holder) {
+  return (in->x1 >= holder->x1) && (in->y1 >= holder->y1) &&
+         (in->x2 <= holder->x2) && (in->y2 <= holder->y2);
+}
+
+static bool area_is_on(const lv_area_t *a, const lv_area_t *b) {
+  return (a->x1 <= b->x2) && (a->x2 >= b->x1) && (a->y1 <= b->y2) &&
+         (a->y2 >= b->y1);
+}
+
+// Events --------------------------------------------------------------
+
+lv_event_code_t lv_event_get_code(lv_event_t *e) { return e->code; }
+
+void *lv_event_get_target(lv_event_t *e) { return e->target; }
+
+void *lv_event_get_param(lv_event_t *e) { return e->param; }
+
+void *lv_event_get_user_data(lv_event_t *e) { return e->user_data; }
+
+static void display_send_event(lv_display_t *disp, lv_event_code_t code,
+                               void *param) {
+  for (const HostEventDsc &dsc : disp->events) {
+    if ((dsc.filter == LV_EVENT_ALL) || (dsc.filter == code)) {
+      lv_event_t e = {code, disp, param, dsc.user_data};
+      dsc.cb(&e);
+    }
+  }
+}
+
+// Display -------------------------------------------------------------
+
+static void display_invalidate(lv_display_t *disp, const lv_area_t *area) {
+  lv_area_t scr = {0, 0, disp->hor - 1, disp->ver - 1}, com;
+  if (!area_intersect(&com, area, &scr)) {
+    return;
+  }
+  if (disp->mode == LV_DISPLAY_RENDER_MODE_FULL) {
+    com = scr;
+  }
+  display_send_event(disp, LV_EVENT_INVALIDATE_AREA, &com);
+  for (const HostArea &a : disp->inv) {
+    if (area_is_in(&com, &a.area)) {
+      return;
+    }
+  }
+  if (disp->inv.size() >= LV_INV_BUF_SIZE) {
+    disp->inv.clear(); // No room: redraw the whole screen
+    com = scr;
+  }
+  disp->inv.push_back({com, false});
+}
+
+lv_display_t *lv_display_create(int32_t hor_res, int32_t ver_res) {
+  lv_display_t *disp = new lv_display_t();
+  disp->hor = hor_res;
+  disp->ver = ver_res;
+  disp->mode = LV_DISPLAY_RENDER_MODE_PARTIAL;
+  disp->last_refr = lv_tick_get();
+  disp->scene.assign((size_t)hor_res * ver_res, 0);
+  disp->screen = new lv_obj_t{&lv_obj_class, disp, "", 0, 0};
+  objs.push_back(disp->screen);
+  displays.push_back(disp);
+  if (!disp_def) {
+    disp_def = disp;
+  }
+  lv_obj_invalidate(disp->screen);
+  return disp;
+}
+
+void lv_display_delete(lv_display_t *disp) {
+  host_erase(displays, disp);
+  host_erase(objs, disp->screen);
+  delete disp->screen;
+  if (disp_def == disp) {
+    disp_def = displays.empty() ? NULL : displays[0];
+  }
+  delete disp;
+}
+
+void lv_display_set_default(lv_display_t *disp) { disp_def = disp; }
+
+lv_display_t *lv_display_get_default(void) { return disp_def; }
+
+void lv_display_set_flush_cb(lv_display_t *disp,
+                             lv_display_flush_cb_t flush_cb) {
+  disp->flush_cb = flush_cb;
+}
+
+void lv_display_set_flush_wait_cb(lv_display_t *disp,
+                                  lv_display_flush_wait_cb_t wait_cb) {
+  disp->wait_cb = wait_cb;
+}
+
+void lv_display_set_buffers(lv_display_t *disp, void *buf1, void *buf2,
+                            uint32_t buf_size,
+                            lv_display_render_mode_t render_mode) {
+  disp->buf[0] = (uint8_t *)buf1;
+  disp->buf[1] = (uint8_t *)buf2;
+  disp->buf_act = disp->buf[0];
+  disp->buf_size = buf_size;
+  disp->mode = render_mode;
+}
+
+void lv_display_set_user_data(lv_display_t *disp, void *user_data) {
+  disp->user_data = user_data;
+}
+
+void *lv_display_get_user_data(lv_display_t *disp) { return disp->user_data; }
+
+void lv_display_flush_ready(lv_display_t *disp) {
+  disp->stats.flush_readies++;
+  if (!disp->flushing) {
+    disp->stats.stray_readies++;
+  }
+  disp->flushing = false;
+  disp->flushing_last = false;
+}
+
+bool lv_display_flush_is_last(lv_display_t *disp) {
+  return disp->flushing_last;
+}
+
+int32_t lv_display_get_horizontal_resolution(const lv_display_t *disp) {
+  return disp->hor;
+}
+
+int32_t lv_display_get_vertical_resolution(const lv_display_t *disp) {
+  return disp->ver;
+}
+
+void lv_display_add_event_cb(lv_display_t *disp, lv_event_cb_t event_cb,
+                             lv_event_code_t filter, void *user_data) {
+  disp->events.push_back({event_cb, filter, user_data});
+}
+
+lv_obj_t *lv_display_get_screen_active(lv_display_t *disp) {
+  return disp ? disp->screen : NULL;
+}
+
+lv_obj_t *lv_screen_active(void) {
+  return lv_display_get_screen_active(disp_def);
+}
+
+uint16_t *host_scene(lv_display_t *disp) { return disp->scene.data(); }
+
+void host_invalidate(lv_display_t *disp, int32_t x1, int32_t y1, int32_t x2,
+                     int32_t y2) {
+  lv_area_t area = {x1, y1, x2, y2};
+  display_invalidate(disp, &area);
+}
+
+HostDisplayStats *host_display_stats(lv_display_t *disp) {
+  return &disp->stats;
+}
+
+// Refresh -------------------------------------------------------------
+
+static bool double_buffered(lv_display_t *disp) {
+  return disp->buf[0] && disp->buf[1];
+}
+
+// Waits for the flush in progress, as LvGL does before touching a buffer
+static void wait_for_flushing(lv_display_t *disp) {
+  if (disp->wait_cb) {
+    if (disp->flushing) {
+      disp->stats.flush_waits++;
+      disp->wait_cb(disp);
+    }
+    disp->flushing = false;
+  } else if (disp->flushing) {
+    // LvGL would spin here for good; the flush was never made ready
+    fprintf(stderr, "LvGL: waiting for a flush no one will finish\n");
+    host_failures++;
+    disp->flushing = false;
+  }
+  disp->flushing_last = false;
+}
+
+// Draws the scene's pixels for 'area' into the active buffer: at the
+// buffer's start for 'buf_area' (PARTIAL), or in place (DIRECT)
+static void render(lv_display_t *disp, const lv_area_t *area,
+                   const lv_area_t *buf_area) {
+  uint16_t *buf = (uint16_t *)disp->buf_act;
+  int32_t stride = lv_area_get_width(buf_area);
+  if (disp->flushing && (disp->buf_act == disp->buf_flushing)) {
+    // Still going out to the display. In DIRECT mode only the area being
+    // sent is, and LvGL redraws areas that overlap with the same pixels:
+    // a hazard only if one of them changes.
+    lv_area_t com;
+    if (disp->mode != LV_DISPLAY_RENDER_MODE_DIRECT) {
+      disp->stats.hazards++;
+    } else if (area_intersect(&com, area, &disp->area_flushing)) {
+      for (int32_t y = com.y1; y <= com.y2; y++) {
+        if (memcmp(buf + (y - buf_area->y1) * stride + (com.x1 - buf_area->x1),
+                   &disp->scene[(size_t)y * disp->hor + com.x1],
+                   lv_area_get_width(&com) * sizeof(uint16_t))) {
+          disp->stats.hazards++;
+          break;
+        }
+      }
+    }
+  }
+  for (int32_t y = area->y1; y <= area->y2; y++) {
+    memcpy(buf + (y - buf_area->y1) * stride + (area->x1 - buf_area->x1),
+           &disp->scene[(size_t)y * disp->hor + area->x1],
+           lv_area_get_width(area) * sizeof(uint16_t));
+  }
+}
+
+static void draw_buf_flush(lv_display_t *disp, const lv_area_t *area) {
+  if (double_buffered(disp)) {
+    wait_for_flushing(disp);
+  }
+  disp->flushing = true;
+  disp->flushing_last = disp->last_area && disp->last_part;
+  bool flushing_last = disp->flushing_last;
+  disp->buf_flushing = disp->buf_act;
+  disp->area_flushing = *area;
+  if (disp->flush_cb) {
+    disp->stats.flushes++;
+    disp->flush_cb(disp, area, disp->buf_act);
+  }
+  if (double_buffered(disp) &&
+      ((disp->mode != LV_DISPLAY_RENDER_MODE_DIRECT) || flushing_last)) {
+    disp->buf_act =
+        (disp->buf_act == disp->buf[0]) ? disp->buf[1] : disp->buf[0];
+  }
+}
+
+static void refr_area_part(lv_display_t *disp, const lv_area_t *area,
+                           const lv_area_t *buf_area) {
+  if (!double_buffered(disp)) {
+    wait_for_flushing(disp);
+  }
+  render(disp, area, buf_area);
+  draw_buf_flush(disp, area);
+}
+
+// Rows of an area w wide that fit the buffer, rounded by the display's
+// INVALIDATE_AREA handlers the way LvGL does it
+static int32_t get_max_row(lv_display_t *disp, int32_t area_w,
+                           int32_t area_h) {
+  int32_t max_row = disp->buf_size / (area_w * sizeof(uint16_t));
+  max_row = min(max_row, area_h);
+  lv_area_t tmp = {0, 0, 0, 0};
+  int32_t h_tmp = max_row;
+  do {
+    tmp.x1 = tmp.x2 = tmp.y1 = 0;
+    tmp.y2 = h_tmp - 1;
+    display_send_event(disp, LV_EVENT_INVALIDATE_AREA, &tmp);
+    if (lv_area_get_height(&tmp) <= max_row) {
+      break;
+    }
+    h_tmp--;
+  } while (h_tmp > 0);
+  return (h_tmp <= 0) ? 0 : tmp.y2 + 1;
+}
+
+static void refr_area(lv_display_t *disp, const lv_area_t *area) {
+  if (disp->mode != LV_DISPLAY_RENDER_MODE_PARTIAL) {
+    lv_area_t scr = {0, 0, disp->hor - 1, disp->ver - 1};
+    disp->last_part = disp->last_area;
+    refr_area_part(disp, area, &scr);
+    return;
+  }
+  int32_t y2 = area->y2;
+  int32_t max_row = get_max_row(disp, lv_area_get_width(area),
+                                lv_area_get_height(area));
+  if (max_row <= 0) {
+    fprintf(stderr, "LvGL: buffer too small for a rounded area\n");
+    host_failures++;
+    return;
+  }
+  int32_t row, row_last = 0;
+  lv_area_t sub = *area;
+  for (row = area->y1; row + max_row - 1 <= y2; row += max_row) {
+    sub.y1 = row;
+    sub.y2 = min(row + max_row - 1, y2);
+    row_last = sub.y2;
+    if (y2 == row_last) {
+      disp->last_part = true;
+    }
+    refr_area_part(disp, &sub, &sub);
+  }
+  if (y2 != row_last) {
+    sub.y1 = row;
+    sub.y2 = y2;
+    disp->last_part = true;
+    refr_area_part(disp, &sub, &sub);
+  }
+}
+
+// Joins areas where one box is cheaper than the two, as lv_refr does
+static void refr_join_areas(lv_display_t *disp) {
+  for (size_t join_in = 0; join_in < disp->inv.size(); join_in++) {
+    if (disp->inv[join_in].joined) {
+      continue;
+    }
+    for (size_t join_from = 0; join_from < disp->inv.size(); join_from++) {
+      HostArea &from = disp->inv[join_from], &in = disp->inv[join_in];
+      if (from.joined || (join_in == join_from) ||
+          !area_is_on(&in.area, &from.area)) {
+        continue;
+      }
+      lv_area_t joined = {min(in.area.x1, from.area.x1),
+                          min(in.area.y1, from.area.y1),
+                          max(in.area.x2, from.area.x2),
+                          max(in.area.y2, from.area.y2)};
+      if (area_size(&joined) < area_size(&in.area) + area_size(&from.area)) {
+        in.area = joined;
+        from.joined = true;
+      }
+    }
+  }
+}
+
+static void display_refr(lv_display_t *disp) {
+  disp->last_refr = lv_tick_get();
+  if (disp->inv.empty() || !disp->buf_act) {
+    return;
+  }
+  if ((disp->mode == LV_DISPLAY_RENDER_MODE_DIRECT) &&
+      double_buffered(disp) && disp->synced) {
+    wait_for_flushing(disp); // Before syncing the other buffer
+  }
+  refr_join_areas(disp);
+  int32_t last_i = -1;
+  for (size_t i = 0; i < disp->inv.size(); i++) {
+    if (!disp->inv[i].joined) {
+      last_i = i;
+    }
+  }
+  disp->last_area = false;
+  disp->last_part = false;
+  std::vector<HostArea> inv;
+  inv.swap(disp->inv); // Areas invalidated while flushing wait for next time
+  for (int32_t i = 0; i <= last_i; i++) {
+    if (inv[i].joined) {
+      continue;
+    }
+    if (i == last_i) {
+      disp->last_area = true;
+    }
+    disp->last_part = false;
+    refr_area(disp, &inv[i].area);
+  }
+  disp->synced = true;
+  disp->stats.refreshes++;
+}
+
+void lv_refr_now(lv_display_t *disp) {
+  if (disp) {
+    display_refr(disp);
+  } else {
+    for (lv_display_t *d : std::vector<lv_display_t *>(displays)) {
+      display_refr(d);
+    }
+  }
+}
+
+// Input devices -------------------------------------------------------
+
+lv_indev_t *lv_indev_create(void) {
+  lv_indev_t *indev = new lv_indev_t();
+  indev->disp = disp_def;
+  indev->mode = LV_INDEV_MODE_TIMER;
+  indev->last_read = lv_tick_get();
+  indevs.push_back(indev);
+  return indev;
+}
+
+void lv_indev_delete(lv_indev_t *indev) {
+  host_erase(indevs, indev);
+  delete indev;
+}
+
+lv_indev_t *lv_indev_get_next(lv_indev_t *indev) {
+  if (!indev) {
+    return indevs.empty() ? NULL : indevs[0];
+  }
+  auto it = std::find(indevs.begin(), indevs.end(), indev);
+  return ((it == indevs.end()) || (++it == indevs.end())) ? NULL : *it;
+}
+
+void lv_indev_set_type(lv_indev_t *indev, lv_indev_type_t type) {
+  indev->type = type;
+}
+
+void lv_indev_set_read_cb(lv_indev_t *indev, lv_indev_read_cb_t read_cb) {
+  indev->read_cb = read_cb;
+}
+
+lv_indev_read_cb_t lv_indev_get_read_cb(lv_indev_t *indev) {
+  return indev->read_cb;
+}
+
+void lv_indev_set_user_data(lv_indev_t *indev, void *user_data) {
+  indev->user_data = user_data;
+}
+
+void *lv_indev_get_user_data(const lv_indev_t *indev) {
+  return indev->user_data;
+}
+
+void lv_indev_set_display(lv_indev_t *indev, lv_display_t *disp) {
+  indev->disp = disp;
+}
+
+void lv_indev_set_mode(lv_indev_t *indev, lv_indev_mode_t mode) {
+  indev->mode = mode;
+}
+
+lv_indev_mode_t lv_indev_get_mode(lv_indev_t *indev) { return indev->mode; }
+
+// Reads until the device has nothing more buffered, as LvGL does
+void lv_indev_read(lv_indev_t *indev) {
+  indev->last_read = lv_tick_get();
+  if (!indev->read_cb) {
+    return;
+  }
+  lv_indev_data_t data;
+  do {
+    memset(&data, 0, sizeof data);
+    if (!indev->log.empty()) { // LvGL keeps the last point and state
+      data.point = indev->log.back().point;
+      data.state = indev->log.back().state;
+    }
+    indev->read_cb(indev, &data);
+    indev->log.push_back(data);
+  } while (data.continue_reading);
+}
+
+const std::vector<lv_indev_data_t> &host_indev_log(lv_indev_t *indev) {
+  return indev->log;
+}
+
+// Timers --------------------------------------------------------------
+
+// Runs whatever is due: timers, input device reads and display refreshes.
+// Returns ms until the next one is due.
+uint32_t lv_timer_handler(void) {
+  uint32_t now = lv_tick_get(), next = LV_NO_TIMER_READY;
+  for (lv_timer_t *timer : std::vector<lv_timer_t *>(timers)) {
+    if (std::find(timers.begin(), timers.end(), timer) == timers.end()) {
+      continue; // Deleted by an earlier timer
+    }
+    if (now - timer->last >= timer->period) {
+      timer->last = now;
+      timer->cb(timer);
+    }
+    next = min(next, timer->period - (now - timer->last));
+  }
+  for (lv_indev_t *indev : std::vector<lv_indev_t *>(indevs)) {
+    if (indev->mode != LV_INDEV_MODE_TIMER) {
+      continue;
+    }
+    if (now - indev->last_read >= LV_INDEV_DEF_READ_PERIOD) {
+      lv_indev_read(indev);
+    }
+    next = min(next, LV_INDEV_DEF_READ_PERIOD - (now - indev->last_read));
+  }
+  // LvGL pauses a display's refresh timer while nothing is invalid
+  for (lv_display_t *disp : std::vector<lv_display_t *>(displays)) {
+    if (!disp->inv.empty() && (now - disp->last_refr >= LV_DEF_REFR_PERIOD)) {
+      display_refr(disp);
+    }
+    if (!disp->inv.empty()) {
+      next = min(next, LV_DEF_REFR_PERIOD - (now - disp->last_refr));
+    }
+  }
+  return next;
+}
+
+// Objects -------------------------------------------------------------
+
+static lv_obj_t *obj_create(const lv_obj_class_t *class_p, lv_obj_t *parent) {
+  lv_display_t *disp = parent ? parent->disp : disp_def;
+  lv_obj_t *obj = new lv_obj_t{class_p, disp, "", 0, 0};
+  objs.push_back(obj);
+  return obj;
+}
+
+bool lv_obj_is_valid(const lv_obj_t *obj) {
+  return std::find(objs.begin(), objs.end(), obj) != objs.end();
+}
+
+bool lv_obj_has_class(const lv_obj_t *obj, const lv_obj_class_t *class_p) {
+  for (const lv_obj_class_t *c = obj->class_p; c; c = c->base_class) {
+    if (c == class_p) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Widgets have no geometry here, so redrawing one redraws its screen
+void lv_obj_invalidate(const lv_obj_t *obj) {
+  ((lv_obj_t *)obj)->invalidations++;
+  if (obj->disp) {
+    host_invalidate(obj->disp, 0, 0, obj->disp->hor - 1, obj->disp->ver - 1);
+  }
+}
+
+void lv_obj_delete(lv_obj_t *obj) {
+  host_erase(objs, obj);
+  delete obj;
+}
+
+uint32_t host_obj_invalidations(const lv_obj_t *obj) {
+  return obj->invalidations;
+}
+
+lv_obj_t *lv_label_create(lv_obj_t *parent) {
+  return obj_create(&lv_label_class, parent);
+}
+
+void lv_label_set_text(lv_obj_t *obj, const char *text) {
+  obj->text = text;
+  lv_obj_invalidate(obj);
+}
+
+const char *lv_label_get_text(const lv_obj_t *obj) { return obj->text.c_str(); }
+
+lv_obj_t *lv_textarea_create(lv_obj_t *parent) {
+  return obj_create(&lv_textarea_class, parent);
+}
+
+void lv_textarea_set_text(lv_obj_t *obj, const char *text) {
+  lv_label_set_text(obj, text);
+}
+
+const char *lv_textarea_get_text(const lv_obj_t *obj) {
+  return lv_label_get_text(obj);
+}
+
+lv_obj_t *lv_bar_create(lv_obj_t *parent) {
+  return obj_create(&lv_bar_class, parent);
+}
+
+lv_obj_t *lv_slider_create(lv_obj_t *parent) {
+  return obj_create(&lv_slider_class, parent);
+}
+
+void lv_bar_set_value(lv_obj_t *obj, int32_t value, int anim) {
+  obj->value = value;
+  lv_obj_invalidate(obj);
+}
+
+int32_t lv_bar_get_value(const lv_obj_t *obj) { return obj->value; }
+
+lv_obj_t *lv_arc_create(lv_obj_t *parent) {
+  return obj_create(&lv_arc_class, parent);
+}
+
+void lv_arc_set_value(lv_obj_t *obj, int32_t value) {
+  lv_bar_set_value(obj, value, LV_ANIM_OFF);
+}
+
+int32_t lv_arc_get_value(const lv_obj_t *obj) { return obj->value; }
+
+// File system ---------------------------------------------------------
+
+void lv_fs_drv_init(lv_fs_drv_t *drv) { memset(drv, 0, sizeof *drv); }
+
+// Registering a driver again (e.g. a second begin()) moves it to the front
+void lv_fs_drv_register(lv_fs_drv_t *drv) {
+  host_erase(fs_drvs, drv);
+  fs_drvs.insert(fs_drvs.begin(), drv);
+}
+
+static lv_fs_drv_t *fs_get_drv(char letter) {
+  for (lv_fs_drv_t *drv : fs_drvs) {
+    if (drv->letter == letter) {
+      return drv;
+    }
+  }
+  return NULL;
+}
+
+lv_fs_res_t lv_fs_open(lv_fs_file_t *file_p, const char *path,
+                       lv_fs_mode_t mode) {
+  file_p->drv = NULL;
+  file_p->file_d = NULL;
+  if (!path || !path[0] || (path[1] != ':')) {
+    return LV_FS_RES_INV_PARAM;
+  }
+  lv_fs_drv_t *drv = fs_get_drv(path[0]);
+  if (!drv) {
+    return LV_FS_RES_NOT_EX;
+  }
+  if (drv->ready_cb && !drv->ready_cb(drv)) {
+    return LV_FS_RES_HW_ERR;
+  }
+  if (!drv->open_cb) {
+    return LV_FS_RES_NOT_IMP;
+  }
+  void *file_d = drv->open_cb(drv, path + 2, mode);
+  if (!file_d) {
+    return LV_FS_RES_UNKNOWN;
+  }
+  file_p->drv = drv;
+  file_p->file_d = file_d;
+  return LV_FS_RES_OK;
+}
+
+lv_fs_res_t lv_fs_close(lv_fs_file_t *file_p) {
+  if (!file_p->drv) {
+    return LV_FS_RES_INV_PARAM;
+  }
+  lv_fs_res_t res = file_p->drv->close_cb
+                        ? file_p->drv->close_cb(file_p->drv, file_p->file_d)
+                        : LV_FS_RES_NOT_IMP;
+  file_p->file_d = NULL;
+  file_p->drv = NULL;
+  return res;
+}
+
+lv_fs_res_t lv_fs_read(lv_fs_file_t *file_p, void *buf, uint32_t btr,
+                       uint32_t *br) {
+  uint32_t n = 0;
+  lv_fs_res_t res = LV_FS_RES_INV_PARAM;
+  if (file_p->drv) {
+    res = file_p->drv->read_cb
+              ? file_p->drv->read_cb(file_p->drv, file_p->file_d, buf, btr, &n)
+              : LV_FS_RES_NOT_IMP;
+  }
+  if (br) {
+    *br = n;
+  }
+  return res;
+}
+
+lv_fs_res_t lv_fs_write(lv_fs_file_t *file_p, const void *buf, uint32_t btw,
+                        uint32_t *bw) {
+  uint32_t n = 0;
+  lv_fs_res_t res = LV_FS_RES_INV_PARAM;
+  if (file_p->drv) {
+    res = file_p->drv->write_cb ? file_p->drv->write_cb(
+                                      file_p->drv, file_p->file_d, buf, btw, &n)
+                                : LV_FS_RES_NOT_IMP;
+  }
+  if (bw) {
+    *bw = n;
+  }
+  return res;
+}
+
+lv_fs_res_t lv_fs_seek(lv_fs_file_t *file_p, uint32_t pos,
+                       lv_fs_whence_t whence) {
+  if (!file_p->drv) {
+    return LV_FS_RES_INV_PARAM;
+  }
+  return file_p->drv->seek_cb
+             ? file_p->drv->seek_cb(file_p->drv, file_p->file_d, pos, whence)
+             : LV_FS_RES_NOT_IMP;
+}
+
+lv_fs_res_t lv_fs_tell(lv_fs_file_t *file_p, uint32_t *pos) {
+  if (!file_p->drv) {
+    return LV_FS_RES_INV_PARAM;
+  }
+  return file_p->drv->tell_cb
+             ? file_p->drv->tell_cb(file_p->drv, file_p->file_d, pos)
+             : LV_FS_RES_NOT_IMP;
+}
+
+lv_fs_res_t lv_fs_dir_open(lv_fs_dir_t *rddir_p, const char *path) {
+  rddir_p->drv = NULL;
+  rddir_p->dir_d = NULL;
+  if (!path || !path[0] || (path[1] != ':')) {
+    return LV_FS_RES_INV_PARAM;
+  }
+  lv_fs_drv_t *drv = fs_get_drv(path[0]);
+  if (!drv) {
+    return LV_FS_RES_NOT_EX;
+  }
+  if (!drv->dir_open_cb) {
+    return LV_FS_RES_NOT_IMP;
+  }
+  void *dir_d = drv->dir_open_cb(drv, path + 2);
+  if (!dir_d) {
+    return LV_FS_RES_UNKNOWN;
+  }
+  rddir_p->drv = drv;
+  rddir_p->dir_d = dir_d;
+  return LV_FS_RES_OK;
+}
+
+lv_fs_res_t lv_fs_dir_read(lv_fs_dir_t *rddir_p, char *fn, uint32_t fn_len) {
+  if (!rddir_p->drv || !rddir_p->dir_d) {
+    return LV_FS_RES_INV_PARAM;
+  }
+  return rddir_p->drv->dir_read_cb
+             ? rddir_p->drv->dir_read_cb(rddir_p->drv, rddir_p->dir_d, fn,
+                                         fn_len)
+             : LV_FS_RES_NOT_IMP;
+}
+
+lv_fs_res_t lv_fs_dir_close(lv_fs_dir_t *rddir_p) {
+  if (!rddir_p->drv || !rddir_p->dir_d) {
+    return LV_FS_RES_INV_PARAM;
+  }
+  lv_fs_res_t res =
+      rddir_p->drv->dir_close_cb
+          ? rddir_p->drv->dir_close_cb(rddir_p->drv, rddir_p->dir_d)
+          : LV_FS_RES_NOT_IMP;
+  rddir_p->drv = NULL;
+  rddir_p->dir_d = NULL;
+  return res;
+}
+
+// Images --------------------------------------------------------------
+
+lv_result_t lv_draw_buf_init(lv_draw_buf_t *draw_buf, uint32_t w, uint32_t h,
+                             lv_color_format_t cf, uint32_t stride,
+                             void *data, uint32_t data_size) {
+  if (stride == LV_STRIDE_AUTO) {
+    stride = w * sizeof(uint16_t);
+  }
+  if (!data || (stride * h > data_size)) {
+    return LV_RESULT_INVALID;
+  }
+  memset(draw_buf, 0, sizeof *draw_buf);
+  draw_buf->header.magic = LV_IMAGE_HEADER_MAGIC;
+  draw_buf->header.cf = cf;
+  draw_buf->header.w = w;
+  draw_buf->header.h = h;
+  draw_buf->header.stride = stride;
+  draw_buf->data = (uint8_t *)data;
+  draw_buf->data_size = data_size;
+  draw_buf->unaligned_data = data;
+  return LV_RESULT_OK;
+}
+
+lv_image_src_t lv_image_src_get_type(const void *src) {
+  if (!src) {
+    return LV_IMAGE_SRC_UNKNOWN;
+  }
+  uint8_t u8 = *(const uint8_t *)src;
+  if ((u8 >= 0x20) && (u8 <= 0x7F)) {
+    return LV_IMAGE_SRC_FILE;
+  }
+  return (u8 >= 0x80) ? LV_IMAGE_SRC_SYMBOL : LV_IMAGE_SRC_VARIABLE;
+}
+
+lv_image_decoder_t *lv_image_decoder_create(void) {
+  lv_image_decoder_t *decoder = new lv_image_decoder_t();
+  decoders.insert(decoders.begin(), decoder);
+  return decoder;
+}
+
+void lv_image_decoder_delete(lv_image_decoder_t *decoder) {
+  host_erase(decoders, decoder);
+  delete decoder;
+}
+
+void lv_image_decoder_set_info_cb(lv_image_decoder_t *decoder,
+                                  lv_image_decoder_info_f_t info_cb) {
+  decoder->info_cb = info_cb;
+}
+
+void lv_image_decoder_set_open_cb(lv_image_decoder_t *decoder,
+                                  lv_image_decoder_open_f_t open_cb) {
+  decoder->open_cb = open_cb;
+}
+
+void lv_image_decoder_set_get_area_cb(lv_image_decoder_t *decoder,
+                                      lv_image_decoder_get_area_cb_t cb) {
+  decoder->get_area_cb = cb;
+}
+
+void lv_image_decoder_set_close_cb(lv_image_decoder_t *decoder,
+                                   lv_image_decoder_close_f_t close_cb) {
+  decoder->close_cb = close_cb;
+}
+
+// Asks each decoder, newest first, whether it takes the image, rewinding
+// the file between them; then opens it with the one that does
+lv_result_t lv_image_decoder_open(lv_image_decoder_dsc_t *dsc,
+                                  const void *src,
+                                  const lv_image_decoder_args_t *args) {
+  memset(dsc, 0, sizeof *dsc);
+  dsc->src = src;
+  dsc->src_type = lv_image_src_get_type(src);
+  if (args) {
+    dsc->args = *args;
+  }
+  if ((dsc->src_type == LV_IMAGE_SRC_FILE) &&
+      (lv_fs_open(&dsc->file, (const char *)src, LV_FS_MODE_RD) !=
+       LV_FS_RES_OK)) {
+    return LV_RESULT_INVALID;
+  }
+  for (lv_image_decoder_t *decoder : decoders) {
+    if (decoder->info_cb && decoder->open_cb &&
+        (decoder->info_cb(decoder, dsc, &dsc->header) == LV_RESULT_OK)) {
+      dsc->decoder = decoder;
+      break;
+    }
+    if (dsc->src_type == LV_IMAGE_SRC_FILE) {
+      lv_fs_seek(&dsc->file, 0, LV_FS_SEEK_SET);
+    }
+  }
+  if (!dsc->decoder ||
+      (dsc->decoder->open_cb(dsc->decoder, dsc) != LV_RESULT_OK)) {
+    if (dsc->src_type == LV_IMAGE_SRC_FILE) {
+      lv_fs_close(&dsc->file);
+    }
+    dsc->decoder = NULL;
+    return LV_RESULT_INVALID;
+  }
+  return LV_RESULT_OK;
+}
+
+lv_result_t lv_image_decoder_get_area(lv_image_decoder_dsc_t *dsc,
+                                      const lv_area_t *full_area,
+                                      lv_area_t *decoded_area) {
+  if (!dsc->decoder || !dsc->decoder->get_area_cb) {
+    return LV_RESULT_INVALID;
+  }
+  return dsc->decoder->get_area_cb(dsc->decoder, dsc, full_area,
+                                   decoded_area);
+}
+
+void lv_image_decoder_close(lv_image_decoder_dsc_t *dsc) {
+  if (dsc->decoder && dsc->decoder->close_cb) {
+    dsc->decoder->close_cb(dsc->decoder, dsc);
+  }
+  if (dsc->src_type == LV_IMAGE_SRC_FILE) {
+    lv_fs_close(&dsc->file);
+  }
+}
@@ -0,0 +1,205 @@
+// SdFat stand-in: a card in memory, on the display's shared bus
+#include "host.h"
+#include <SdFat.h>
+#include <string>
+
+struct HostNode {
+  std::string path; // No leading or trailing '/'; "" is the root
+  bool dir;
+  std::vector<uint8_t> data;
+};
+
+static std::vector<HostNode> card; // Nodes are never removed, but by reset
+HostSDStats host_sd;
+
+static void host_sd_check(void) {
+  host_bus_check(0, "SD access during a display transfer");
+}
+
+static std::string host_sd_path(const char *path) {
+  while (*path == '/') {
+    path++;
+  }
+  std::string p(path);
+  while (!p.empty() && (p.back() == '/')) {
+    p.pop_back();
+  }
+  return p;
+}
+
+static int host_sd_find(const std::string &path) {
+  if (card.empty()) {
+    card.push_back({"", true, {}});
+  }
+  for (size_t i = 0; i < card.size(); i++) {
+    if (card[i].path == path) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void host_sd_reset(void) {
+  card.clear();
+  card.push_back({"", true, {}});
+  memset(&host_sd, 0, sizeof host_sd);
+}
+
+// Makes the directories path is in, as a card that holds it would have
+static void host_sd_parents(const std::string &path) {
+  for (size_t slash = path.find('/'); slash != std::string::npos;
+       slash = path.find('/', slash + 1)) {
+    host_sd_mkdir(path.substr(0, slash).c_str());
+  }
+}
+
+void host_sd_put(const char *path, const void *data, size_t len) {
+  std::string p = host_sd_path(path);
+  host_sd_parents(p);
+  int n = host_sd_find(p);
+  if (n < 0) {
+    card.push_back({p, false, {}});
+    n = card.size() - 1;
+  }
+  card[n].data.assign((const uint8_t *)data, (const uint8_t *)data + len);
+}
+
+bool host_sd_get(const char *path, std::vector<uint8_t> *data) {
+  int n = host_sd_find(host_sd_path(path));
+  if ((n < 0) || card[n].dir) {
+    return false;
+  }
+  *data = card[n].data;
+  return true;
+}
+
+void host_sd_mkdir(const char *path) {
+  std::string p = host_sd_path(path);
+  host_sd_parents(p);
+  if (host_sd_find(p) < 0) {
+    card.push_back({p, true, {}});
+  }
+}
+
+File32 SdFat::open(const char *path, oflag_t oflag) {
+  host_sd_check();
+  File32 file;
+  std::string p = host_sd_path(path);
+  int n = host_sd_find(p);
+  bool writing = (oflag & O_ACCMODE) != O_RDONLY;
+  if (n < 0) {
+    if (!(oflag & O_CREAT)) {
+      return file;
+    }
+    card.push_back({p, false, {}});
+    n = card.size() - 1;
+  } else if (card[n].dir && writing) {
+    return file;
+  }
+  if (writing && (oflag & O_TRUNC)) {
+    card[n].data.clear();
+  }
+  file.node = n;
+  file.flags = oflag;
+  file.pos = (oflag & O_APPEND) ? card[n].data.size() : 0;
+  host_sd.opens++;
+  return file;
+}
+
+bool File32::isDir(void) const { return isOpen() && card[node].dir; }
+
+uint32_t File32::fileSize(void) const {
+  return isOpen() ? card[node].data.size() : 0;
+}
+
+// As in SdFat, files can't be seeked past their end
+bool File32::seek(uint32_t pos) {
+  host_sd_check();
+  if (!isOpen() || (pos > fileSize())) {
+    return false;
+  }
+  this->pos = pos;
+  return true;
+}
+
+int File32::read(void *buf, size_t count) {
+  host_sd_check();
+  if (!isOpen() || isDir()) {
+    return -1;
+  }
+  size_t n = min(count, (size_t)(fileSize() - pos));
+  memcpy(buf, card[node].data.data() + pos, n);
+  pos += n;
+  host_sd.reads++;
+  host_sd.read_bytes += n;
+  host_sd.small_reads += (count < 512);
+  return n;
+}
+
+size_t File32::write(const void *buf, size_t count) {
+  host_sd_check();
+  if (!isOpen() || isDir() || ((flags & O_ACCMODE) == O_RDONLY)) {
+    return 0;
+  }
+  std::vector<uint8_t> &data = card[node].data;
+  if (pos + count > data.size()) {
+    data.resize(pos + count);
+  }
+  memcpy(data.data() + pos, buf, count);
+  pos += count;
+  host_sd.writes++;
+  host_sd.write_bytes += count;
+  return count;
+}
+
+// Opens the next file or directory in dir, in name order
+bool File32::openNext(File32 *dir, oflag_t oflag) {
+  host_sd_check();
+  if (isOpen() || !dir->isDir()) {
+    return false;
+  }
+  const std::string &base = card[dir->node].path;
+  std::string prefix = base.empty() ? "" : base + "/";
+  std::vector<int> entries;
+  for (size_t i = 0; i < card.size(); i++) {
+    const std::string &p = card[i].path;
+    if (!p.empty() && (p.size() > prefix.size()) &&
+        !p.compare(0, prefix.size(), prefix) &&
+        (p.find('/', prefix.size()) == std::string::npos)) {
+      entries.push_back(i);
+    }
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](int a, int b) { return card[a].path < card[b].path; });
+  if (dir->next >= entries.size()) {
+    return false;
+  }
+  node = entries[dir->next++];
+  pos = 0;
+  flags = oflag;
+  host_sd.opens++;
+  return true;
+}
+
+size_t File32::getName(char *name, size_t size) {
+  host_sd_check();
+  if (!isOpen() || !size) {
+    return 0;
+  }
+  const std::string &p = card[node].path;
+  std::string base = p.substr(p.rfind('/') + 1); // npos + 1 is 0
+  size_t n = min(base.size(), size - 1);
+  memcpy(name, base.data(), n);
+  name[n] = 0;
+  return n;
+}
+
+bool File32::close(void) {
+  if (!isOpen()) {
+    return false;
+  }
+  host_sd_check();
+  node = -1;
+  host_sd.closes++;
+  return true;
+}
@@ -0,0 +1,194 @@
+// GFX stand-in: a panel in RAM behind a model of SPI DMA, see
+// include/Adafruit_SPITFT.h
+#include "host.h"
+
+static std::vector<Adafruit_SPITFT *> host_displays;
+
+void Adafruit_SPITFT::init(uint16_t w, uint16_t h, bool dma) {
+  this->dma = dma;
+  dma_self_wait = true;
+  bus = 0;
+  violations = 0;
+  last_violation = NULL;
+  transactions = windows = dma_transfers = pio_writes = waits = 0;
+  native_w = w;
+  native_h = h;
+  rotation = 0;
+  ram.assign((size_t)w * h, 0);
+  in_write = false;
+  wx = wy = ww = wh = cx = cy = 0;
+  dma_pixels = NULL;
+  dma_len = 0;
+  dma_big = false;
+  host_displays.push_back(this);
+}
+
+Adafruit_SPITFT::~Adafruit_SPITFT(void) {
+  host_displays.erase(
+      std::find(host_displays.begin(), host_displays.end(), this));
+}
+
+void Adafruit_SPITFT::violation(const char *what) {
+  if (!violations) {
+    fprintf(stderr, "display violation: %s\n", what); // First one only
+  }
+  violations++;
+  last_violation = what;
+}
+
+// Sends pixels into the address window, as the panel would take them
+void Adafruit_SPITFT::put(const uint16_t *colors, uint32_t len,
+                          bool bigEndian) {
+  for (; len; len--, colors++) {
+    if (cy >= wh) {
+      violation("write past the address window");
+      return;
+    }
+    uint16_t c = bigEndian ? __builtin_bswap16(*colors) : *colors;
+    ram[(size_t)(wy + cy) * width() + wx + cx] = c;
+    if (++cx == ww) {
+      cx = 0;
+      cy++;
+    }
+  }
+}
+
+// Ends the transfer in flight; only now are its pixels read
+void Adafruit_SPITFT::complete(void) {
+  const uint16_t *pixels = dma_pixels;
+  dma_pixels = NULL;
+  put(pixels, dma_len, dma_big);
+}
+
+void Adafruit_SPITFT::startWrite(void) {
+  if (in_write) {
+    violation("startWrite inside a transaction");
+  }
+  if (dma_pixels) {
+    violation("startWrite during DMA");
+  }
+  in_write = true;
+  transactions++;
+}
+
+void Adafruit_SPITFT::endWrite(void) {
+  if (!in_write) {
+    violation("endWrite outside a transaction");
+  }
+  if (dma_pixels) {
+    violation("endWrite during DMA");
+  }
+  in_write = false;
+}
+
+void Adafruit_SPITFT::setAddrWindow(uint16_t x, uint16_t y, uint16_t w,
+                                    uint16_t h) {
+  if (!in_write) {
+    violation("setAddrWindow outside a transaction");
+  }
+  if (dma_pixels) {
+    violation("setAddrWindow during DMA");
+  }
+  if (!w || !h || (x + w > width()) || (y + h > height())) {
+    violation("address window off the panel");
+    w = h = 0;
+  }
+  wx = x;
+  wy = y;
+  ww = w;
+  wh = h;
+  cx = cy = 0;
+  windows++;
+}
+
+void Adafruit_SPITFT::writePixels(uint16_t *colors, uint32_t len, bool block,
+                                  bool bigEndian) {
+  if (!in_write) {
+    violation("writePixels outside a transaction");
+  }
+  if (!len) {
+    return;
+  }
+  if (dma && (len >= HOST_DMA_MIN)) {
+    if (dma_pixels) {
+      if (!dma_self_wait) {
+        violation("writePixels by DMA during DMA");
+      }
+      complete(); // GFX waits for the previous transfer itself
+    }
+    dma_pixels = colors;
+    dma_len = len;
+    dma_big = bigEndian;
+    dma_transfers++;
+    if (block) {
+      complete();
+    }
+  } else {
+    if (dma_pixels) {
+      violation("writePixels by PIO during DMA");
+    }
+    put(colors, len, bigEndian);
+    pio_writes++;
+  }
+}
+
+void Adafruit_SPITFT::dmaWait(void) {
+  waits++;
+  if (dma_pixels) {
+    complete();
+  }
+}
+
+bool Adafruit_SPITFT::dmaBusy(void) const { return dma_pixels != NULL; }
+
+int16_t Adafruit_SPITFT::width(void) const {
+  return (rotation & 1) ? native_h : native_w;
+}
+
+int16_t Adafruit_SPITFT::height(void) const {
+  return (rotation & 1) ? native_w : native_h;
+}
+
+uint8_t Adafruit_SPITFT::getRotation(void) const { return rotation; }
+
+void Adafruit_SPITFT::setRotation(uint8_t r) { rotation = r & 3; }
+
+void Adafruit_SPITFT::fillScreen(uint16_t color) {
+  if (busBusy()) {
+    violation("drawing during a flush");
+  }
+  std::fill(ram.begin(), ram.end(), color);
+}
+
+void Adafruit_SPITFT::drawFastHLine(int16_t x, int16_t y, int16_t w,
+                                    uint16_t color) {
+  if (busBusy()) {
+    violation("drawing during a flush");
+  }
+  for (; w > 0; w--, x++) {
+    if ((x >= 0) && (x < width()) && (y >= 0) && (y < height())) {
+      ram[(size_t)y * width() + x] = color;
+    }
+  }
+}
+
+void Adafruit_SPITFT::drawFastVLine(int16_t x, int16_t y, int16_t h,
+                                    uint16_t color) {
+  for (; h > 0; h--, y++) {
+    drawFastHLine(x, y, 1, color);
+  }
+}
+
+uint16_t Adafruit_SPITFT::pixel(int16_t x, int16_t y) const {
+  return ram[(size_t)y * width() + x];
+}
+
+bool Adafruit_SPITFT::busBusy(void) const { return dma_pixels || in_write; }
+
+void host_bus_check(uint8_t bus, const char *who) {
+  for (Adafruit_SPITFT *display : host_displays) {
+    if ((display->bus == bus) && display->busBusy()) {
+      display->violation(who);
+    }
+  }
+}
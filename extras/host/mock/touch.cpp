@@ -0,0 +1,24 @@
+// STMPE610 stand-in: a FIFO of points, on the display's shared bus
+#include "host.h"
+#include <Adafruit_STMPE610.h>
+
+uint8_t Adafruit_STMPE610::bufferSize(void) {
+  host_bus_check(0, "touch read during a display transfer");
+  return min(fifo.size(), (size_t)255);
+}
+
+TS_Point Adafruit_STMPE610::getPoint(void) {
+  host_bus_check(0, "touch read during a display transfer");
+  reads++;
+  if (fifo.empty()) {
+    return TS_Point();
+  }
+  TS_Point p = fifo.front();
+  fifo.pop_front();
+  return p;
+}
+
+bool Adafruit_STMPE610::touched(void) {
+  host_bus_check(0, "touch read during a display transfer");
+  return !fifo.empty();
+}
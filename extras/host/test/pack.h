@@ -0,0 +1,197 @@
+// Builders for what the SD and asset tests read: asset packs laid out as
+// extras/lvpack.py writes them, and RGB565 .bin images, raw or compressed
+// with LvGL's RLE or with Q565 as extras/q565.py does
+#ifndef _HOST_PACK_H_
+#define _HOST_PACK_H_
+
+#include <Adafruit_LvGL_Glue_Assets.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+typedef std::vector<uint8_t> Bytes;
+
+struct PackAsset {
+  std::string path;
+  Bytes data;
+};
+
+inline void put_bytes(Bytes *out, const void *data, size_t len) {
+  const uint8_t *p = (const uint8_t *)data;
+  out->insert(out->end(), p, p + len);
+}
+
+// An asset pack of the given assets: header, index sorted by hash, paths,
+// then the data, each on a multiple of align bytes
+inline Bytes make_pack(const std::vector<PackAsset> &assets,
+                       uint16_t align = 4) {
+  std::vector<LvGLPackEntry> index;
+  std::string names;
+  for (const PackAsset &asset : assets) {
+    LvGLPackEntry entry = {};
+    entry.hash = Adafruit_LvGL_Assets::hashPath(asset.path.c_str());
+    entry.name = names.size();
+    entry.size = asset.data.size();
+    names += asset.path;
+    names += '\0';
+    index.push_back(entry);
+  }
+  LvGLPackHeader header = {};
+  header.magic = LVGL_PACK_MAGIC;
+  header.version = LVGL_PACK_VERSION;
+  header.align = align;
+  header.count = assets.size();
+  header.names = sizeof header + index.size() * sizeof(LvGLPackEntry);
+  uint32_t at = header.names + names.size();
+  for (size_t i = 0; i < assets.size(); i++) {
+    while (at % align) {
+      at++;
+    }
+    index[i].offset = at;
+    at += assets[i].data.size();
+  }
+  std::vector<size_t> order(assets.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return index[a].hash < index[b].hash;
+  });
+  Bytes pack;
+  put_bytes(&pack, &header, sizeof header);
+  for (size_t i : order) {
+    put_bytes(&pack, &index[i], sizeof index[i]);
+  }
+  put_bytes(&pack, names.data(), names.size());
+  for (size_t i = 0; i < assets.size(); i++) {
+    pack.resize(index[i].offset);
+    put_bytes(&pack, assets[i].data.data(), assets[i].data.size());
+  }
+  return pack;
+}
+
+// RGB565 pixels of a test image, w x h, with runs, small steps and jumps,
+// so every kind of compressed block gets used
+inline std::vector<uint16_t> image_pixels(uint32_t w, uint32_t h) {
+  std::vector<uint16_t> pixels(w * h);
+  for (uint32_t y = 0; y < h; y++) {
+    for (uint32_t x = 0; x < w; x++) {
+      uint16_t p;
+      if (x < w / 4) {
+        p = 0x1234 + (y / 4); // Runs
+      } else if (x < w / 2) {
+        p = ((x & 3) << 11) | ((y & 7) << 5) | (x & 1); // Small steps
+      } else {
+        p = ((x * 31 + y * 977) * 2654435761UL) >> 16; // Anything
+      }
+      pixels[y * w + x] = p;
+    }
+  }
+  return pixels;
+}
+
+inline Bytes image_header(uint32_t w, uint32_t h, bool compressed) {
+  lv_image_header_t header = {};
+  header.magic = LV_IMAGE_HEADER_MAGIC;
+  header.cf = LV_COLOR_FORMAT_RGB565;
+  header.flags = compressed ? LV_IMAGE_FLAGS_COMPRESSED : 0;
+  header.w = w;
+  header.h = h;
+  header.stride = w * 2;
+  Bytes out;
+  put_bytes(&out, &header, sizeof header);
+  return out;
+}
+
+inline Bytes image_raw(const std::vector<uint16_t> &pixels, uint32_t w,
+                       uint32_t h) {
+  Bytes out = image_header(w, h, false);
+  put_bytes(&out, pixels.data(), pixels.size() * 2);
+  return out;
+}
+
+// Compressed image: header, compression header, then the data
+inline Bytes image_compressed(uint32_t method, const Bytes &data,
+                              uint32_t w, uint32_t h) {
+  Bytes out = image_header(w, h, true);
+  uint32_t comp[3] = {method, (uint32_t)data.size(), w * h * 2};
+  put_bytes(&out, comp, sizeof comp);
+  put_bytes(&out, data.data(), data.size());
+  return out;
+}
+
+// LvGL's RLE with 2-byte blocks: a repeated pixel is a count (under 128)
+// then the pixel; anything else is 0x80 | count then that many pixels
+inline Bytes rle_encode(const std::vector<uint16_t> &pixels) {
+  Bytes out;
+  size_t i = 0, n = pixels.size();
+  while (i < n) {
+    size_t run = 1;
+    while ((i + run < n) && (run < 127) && (pixels[i + run] == pixels[i])) {
+      run++;
+    }
+    if (run >= 3) {
+      out.push_back(run);
+      put_bytes(&out, &pixels[i], 2);
+      i += run;
+      continue;
+    }
+    size_t lit = 0;
+    while ((i + lit < n) && (lit < 127) &&
+           !((i + lit + 2 < n) && (pixels[i + lit] == pixels[i + lit + 1]) &&
+             (pixels[i + lit] == pixels[i + lit + 2]))) {
+      lit++;
+    }
+    out.push_back(0x80 | lit);
+    put_bytes(&out, &pixels[i], lit * 2);
+    i += lit;
+  }
+  return out;
+}
+
+// Q565 (see Adafruit_LvGL_Glue_SD.h), greedily: a run if the pixel repeats,
+// else DIFF or LUMA if the step fits, else a literal
+inline Bytes q565_encode(const std::vector<uint16_t> &pixels) {
+  Bytes out;
+  uint16_t prev = 0;
+  size_t i = 0, n = pixels.size();
+  while (i < n) {
+    uint16_t p = pixels[i];
+    if (p == prev) {
+      size_t run = 1;
+      while ((i + run < n) && (run < 64) && (pixels[i + run] == prev)) {
+        run++;
+      }
+      out.push_back(run - 1);
+      i += run;
+      continue;
+    }
+    int dr = (((p >> 11) - (prev >> 11)) + 16) % 32 - 16;
+    int dg = ((((p >> 5) & 0x3F) - ((prev >> 5) & 0x3F)) + 32) % 64 - 32;
+    int db = (((p & 0x1F) - (prev & 0x1F)) + 16) % 32 - 16;
+    int lr = dr - (dg >> 1) + 8, lb = db - (dg >> 1) + 8;
+    if ((dr >= -2) && (dr <= 1) && (dg >= -2) && (dg <= 1) && (db >= -2) &&
+        (db <= 1)) {
+      out.push_back(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+    } else if ((lr >= 0) && (lr < 16) && (lb >= 0) && (lb < 16)) {
+      out.push_back(0x80 | (dg + 32));
+      out.push_back(lr << 4 | lb);
+    } else {
+      size_t lit = 1;
+      while ((i + lit < n) && (lit < 64) &&
+             (pixels[i + lit] != pixels[i + lit - 1])) {
+        lit++;
+      }
+      out.push_back(0xC0 | (lit - 1));
+      put_bytes(&out, &pixels[i], lit * 2);
+      prev = pixels[i + lit - 1];
+      i += lit;
+      continue;
+    }
+    prev = p;
+    i++;
+  }
+  return out;
+}
+
+#endif // _HOST_PACK_H_
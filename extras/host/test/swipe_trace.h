@@ -0,0 +1,52 @@
+// A swipe as an ADC touchscreen might report it, sampled every 5 ms, in
+// pixels (replayed through a calibration that passes readings straight
+// through): held at the start for 10 samples, across at 2.5 pixels a
+// sample, held at the end. Readings carry Gaussian noise of 1.5 pixels
+// and, every 13 samples, a wild one 20-30 pixels out. Each row is the
+// reading, then where the finger really was.
+#ifndef _HOST_SWIPE_TRACE_H_
+#define _HOST_SWIPE_TRACE_H_
+
+#include <stdint.h>
+
+#define SWIPE_MS 5 // Between samples
+
+typedef struct {
+  int16_t x, y;           // Reading
+  int16_t true_x, true_y; // Finger
+} SwipeSample;
+
+static const SwipeSample swipe_trace[] = {
+    {21, 30, 20, 30}, {25, 31, 20, 30}, {20, 31, 20, 30}, {19, 29, 20, 30},
+    {21, 29, 20, 30}, {21, 30, 20, 30}, {17, 48, 20, 30}, {20, 30, 20, 30},
+    {20, 32, 20, 30}, {20, 31, 20, 30}, {18, 30, 20, 30}, {26, 30, 22, 30},
+    {26, 31, 25, 30}, {27, 31, 27, 30}, {27, 32, 30, 30}, {35, 27, 32, 30},
+    {34, 30, 35, 30}, {37, 32, 37, 30}, {39, 32, 40, 31}, {71, 30, 42, 31},
+    {44, 34, 45, 31}, {44, 33, 47, 31}, {51, 33, 50, 31}, {52, 31, 52, 31},
+    {53, 30, 55, 31}, {55, 31, 57, 31}, {61, 31, 60, 32}, {63, 33, 62, 32},
+    {67, 34, 65, 32}, {70, 33, 67, 32}, {70, 33, 70, 32}, {74, 32, 72, 32},
+    {75, 57, 75, 32}, {78, 35, 77, 32}, {79, 32, 80, 33}, {83, 33, 82, 33},
+    {85, 31, 85, 33}, {87, 32, 87, 33}, {90, 34, 90, 33}, {93, 35, 92, 33},
+    {96, 33, 95, 33}, {97, 32, 97, 33}, {100, 36, 100, 34}, {103, 33, 102, 34},
+    {107, 35, 105, 34}, {129, 34, 107, 34}, {112, 34, 110, 34},
+    {111, 33, 112, 34}, {116, 36, 115, 34}, {116, 34, 117, 34},
+    {124, 36, 120, 35}, {122, 36, 122, 35}, {125, 36, 125, 35},
+    {128, 34, 127, 35}, {130, 36, 130, 35}, {131, 35, 132, 35},
+    {134, 37, 135, 35}, {140, 34, 137, 35}, {141, 13, 140, 36},
+    {143, 38, 142, 36}, {143, 38, 145, 36}, {147, 34, 147, 36},
+    {150, 37, 150, 36}, {152, 37, 152, 36}, {155, 35, 155, 36},
+    {159, 35, 157, 36}, {162, 38, 160, 37}, {162, 37, 162, 37},
+    {165, 37, 165, 37}, {167, 37, 167, 37}, {167, 34, 170, 37},
+    {195, 36, 172, 37}, {174, 38, 175, 37}, {179, 37, 177, 37},
+    {179, 36, 180, 38}, {184, 40, 182, 38}, {187, 37, 185, 38},
+    {186, 37, 187, 38}, {191, 37, 190, 38}, {192, 40, 192, 38},
+    {193, 40, 195, 38}, {195, 38, 197, 38}, {201, 40, 200, 39},
+    {201, 39, 202, 39}, {205, 17, 205, 39}, {210, 41, 207, 39},
+    {210, 39, 210, 39}, {209, 39, 212, 39}, {215, 40, 215, 39},
+    {217, 39, 217, 39}, {219, 42, 220, 40}, {221, 41, 220, 40},
+    {222, 41, 220, 40}, {222, 41, 220, 40}, {221, 39, 220, 40},
+    {220, 41, 220, 40}, {222, 39, 220, 40}, {248, 40, 220, 40},
+    {222, 39, 220, 40}, {222, 38, 220, 40},
+};
+
+#endif // _HOST_SWIPE_TRACE_H_
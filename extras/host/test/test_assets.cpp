@@ -0,0 +1,191 @@
+// Asset packs in memory: lookups, image descriptors and the drive must
+// serve each asset's bytes straight out of the pack
+#include "host.h"
+#include "pack.h"
+
+#define TFT_W 64
+#define TFT_H 48
+
+static Bytes data_of(size_t len, uint32_t seed) {
+  Bytes data(len);
+  for (size_t i = 0; i < len; i++) {
+    data[i] = (i * 37 + seed * 101) & 0xFF;
+  }
+  return data;
+}
+
+// Keeps a pack 4-byte aligned, as a const array in flash would be
+struct AlignedPack {
+  explicit AlignedPack(const Bytes &pack)
+      : words((pack.size() + 3) / 4), size(pack.size()) {
+    memcpy(words.data(), pack.data(), pack.size());
+  }
+  const void *data(void) const { return words.data(); }
+  std::vector<uint32_t> words;
+  size_t size;
+};
+
+// find() and getImage(): pointers into the pack itself
+static void test_find(void) {
+  std::vector<uint16_t> pixels = image_pixels(8, 6);
+  Bytes a = data_of(100, 1), b = data_of(33, 2);
+  Bytes image = image_raw(pixels, 8, 6);
+  AlignedPack pack(
+      make_pack({{"a.txt", a}, {"dir/b.txt", b}, {"img/i.bin", image}}));
+  Adafruit_LvGL_Assets assets;
+  CHECK(assets.find("a.txt") == NULL); // Not begun
+  CHECK(assets.begin(pack.data(), pack.size) == LVGL_OK);
+  CHECK(assets.count == 3);
+  uint32_t size = 0;
+  const uint8_t *found = assets.find("dir/b.txt", &size);
+  CHECK(found && (size == b.size()) && !memcmp(found, b.data(), size));
+  CHECK((found >= (const uint8_t *)pack.data()) &&
+        (found < (const uint8_t *)pack.data() + pack.size));
+  CHECK(assets.find("/a.txt", &size) && (size == a.size()));
+  CHECK(!assets.find("b.txt"));
+  CHECK(!assets.find("dir/b.tx"));
+
+  lv_image_dsc_t dsc;
+  CHECK(assets.getImage("img/i.bin", &dsc));
+  CHECK((dsc.header.w == 8) && (dsc.header.h == 6));
+  CHECK(dsc.data_size == pixels.size() * 2);
+  CHECK(!memcmp(dsc.data, pixels.data(), dsc.data_size));
+  CHECK(!assets.getImage("a.txt", &dsc)); // Not an image
+  CHECK(!assets.getImage("none.bin", &dsc));
+}
+
+// Many assets: every one is found through the sorted index
+static void test_index(void) {
+  std::vector<PackAsset> list;
+  for (int i = 0; i < 200; i++) {
+    char path[32];
+    snprintf(path, sizeof path, "icons/%03d.bin", i);
+    list.push_back({path, data_of(i % 17 + 1, i)});
+  }
+  AlignedPack pack(make_pack(list, 16));
+  Adafruit_LvGL_Assets assets;
+  CHECK(assets.begin(pack.data(), pack.size) == LVGL_OK);
+  for (int i = 1; i < 200; i++) {
+    CHECK(assets.index[i - 1].hash <= assets.index[i].hash);
+  }
+  for (const PackAsset &asset : list) {
+    uint32_t size;
+    const uint8_t *found = assets.find(asset.path.c_str(), &size);
+    CHECK(found && (size == asset.data.size()) &&
+          !memcmp(found, asset.data.data(), size));
+    CHECK(!(((const uint8_t *)found - (const uint8_t *)pack.data()) % 16));
+  }
+}
+
+// Packs that aren't, or are cut short, are refused
+static void test_bad_packs(void) {
+  Bytes good = make_pack({{"a.txt", data_of(10, 1)}});
+  Adafruit_LvGL_Assets assets;
+  AlignedPack short_pack(good);
+  CHECK(assets.begin(short_pack.data(), sizeof(LvGLPackHeader) - 1) ==
+        LVGL_ERR_FORMAT);
+  Bytes bad = good;
+  bad[0] ^= 1; // Magic
+  AlignedPack bad_magic(bad);
+  CHECK(assets.begin(bad_magic.data(), bad_magic.size) == LVGL_ERR_FORMAT);
+  bad = good;
+  bad[4] ^= 1; // Version
+  AlignedPack bad_version(bad);
+  CHECK(assets.begin(bad_version.data(), bad_version.size) == LVGL_ERR_FORMAT);
+  AlignedPack ok(good);
+  CHECK(assets.begin((const uint8_t *)ok.data() + 1, ok.size - 1) ==
+        LVGL_ERR_FORMAT); // Misaligned
+  CHECK(assets.find("a.txt") == NULL);
+}
+
+// Sets a 32-bit field of a pack
+static void poke(Bytes *pack, size_t at, uint32_t value) {
+  memcpy(&(*pack)[at], &value, sizeof value);
+}
+
+// Packs whose index points outside them are refused up front
+static void test_bad_entries(void) {
+  Bytes good =
+      make_pack({{"a.txt", data_of(10, 1)}, {"b.txt", data_of(20, 2)}});
+  const LvGLPackHeader *header = (const LvGLPackHeader *)good.data();
+  size_t names = header->names;
+  size_t entry = sizeof(LvGLPackHeader) + sizeof(LvGLPackEntry); // Second
+  struct {
+    size_t at;
+    uint32_t value;
+  } bad[] = {
+      {12, sizeof(LvGLPackHeader)},                 // Names on the index
+      {entry + 4, (uint32_t)(good.size() - names)}, // Name past the end
+      {entry + 8, (uint32_t)good.size() + 1},       // Data past the end
+      {entry + 12, (uint32_t)good.size()},          // Data runs off it
+      {entry + 12, 0xFFFFFFFF},                     // Size wraps around
+  };
+  Adafruit_LvGL_Assets assets;
+  for (auto &b : bad) {
+    Bytes pack = good;
+    poke(&pack, b.at, b.value);
+    AlignedPack aligned(pack);
+    CHECK(assets.begin(aligned.data(), aligned.size) == LVGL_ERR_FORMAT);
+  }
+  // A path that runs to the end of the pack without its NUL
+  Bytes pack = good;
+  pack.resize(names + 3);
+  poke(&pack, entry + 8, 0);
+  poke(&pack, entry + 12, 0);
+  poke(&pack, sizeof(LvGLPackHeader) + 8, 0);
+  poke(&pack, sizeof(LvGLPackHeader) + 12, 0);
+  AlignedPack cut(pack);
+  CHECK(assets.begin(cut.data(), cut.size) == LVGL_ERR_FORMAT);
+  CHECK(assets.find("a.txt") == NULL);
+}
+
+// The drive: assets read as files, in pieces, with seeks; read only
+static void test_drive(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  CHECK(glue.begin(&tft, config) == LVGL_OK);
+  Bytes a = data_of(1000, 3);
+  AlignedPack pack(make_pack({{"fonts/a.fnt", a}}));
+  Adafruit_LvGL_Assets assets;
+  CHECK(assets.begin(pack.data(), pack.size, 'Q') == LVGL_OK);
+
+  lv_fs_file_t file;
+  uint8_t buf[300];
+  uint32_t br, pos;
+  Bytes got;
+  CHECK(lv_fs_open(&file, "Q:fonts/a.fnt", LV_FS_MODE_RD) == LV_FS_RES_OK);
+  while ((lv_fs_read(&file, buf, sizeof buf, &br) == LV_FS_RES_OK) && br) {
+    got.insert(got.end(), buf, buf + br);
+  }
+  CHECK(got == a);
+  CHECK(lv_fs_seek(&file, 10, LV_FS_SEEK_END) == LV_FS_RES_OK);
+  CHECK((lv_fs_read(&file, buf, 1, &br) == LV_FS_RES_OK) && (br == 0));
+  CHECK(lv_fs_seek(&file, 500, LV_FS_SEEK_SET) == LV_FS_RES_OK);
+  CHECK(lv_fs_seek(&file, 20, LV_FS_SEEK_CUR) == LV_FS_RES_OK);
+  CHECK((lv_fs_tell(&file, &pos) == LV_FS_RES_OK) && (pos == 520));
+  CHECK((lv_fs_read(&file, buf, 4, &br) == LV_FS_RES_OK) && (br == 4));
+  CHECK(!memcmp(buf, &a[520], 4));
+  CHECK(lv_fs_close(&file) == LV_FS_RES_OK);
+  CHECK(lv_fs_open(&file, "Q:fonts/b.fnt", LV_FS_MODE_RD) != LV_FS_RES_OK);
+  CHECK(lv_fs_open(&file, "Q:fonts/a.fnt", LV_FS_MODE_WR) != LV_FS_RES_OK);
+
+  // begin() again: the drive serves the new pack, on its new letter
+  Bytes b = data_of(50, 4);
+  AlignedPack pack2(make_pack({{"fonts/b.fnt", b}}));
+  CHECK(assets.begin(pack2.data(), pack2.size, 'R') == LVGL_OK);
+  CHECK(!assets.find("fonts/a.fnt"));
+  CHECK(lv_fs_open(&file, "R:fonts/b.fnt", LV_FS_MODE_RD) == LV_FS_RES_OK);
+  CHECK((lv_fs_read(&file, buf, sizeof buf, &br) == LV_FS_RES_OK) &&
+        (br == b.size()) && !memcmp(buf, b.data(), br));
+  CHECK(lv_fs_close(&file) == LV_FS_RES_OK);
+}
+
+int main(void) {
+  test_find();
+  test_index();
+  test_bad_packs();
+  test_bad_entries();
+  test_drive();
+  return host_result("test_assets");
+}
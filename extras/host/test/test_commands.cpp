@@ -0,0 +1,130 @@
+// Posted widget updates: commands from many threads at once must each be
+// applied exactly once, in the order each thread posted them, by the
+// lv_task_handler() timer that stands in for the GUI task here
+#include "host.h"
+#include <Adafruit_LvGL_Glue.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#define TFT_W 64
+#define TFT_H 48
+#define PRODUCERS 4
+#define POSTS 20000 // Per producer
+
+// Runs LvGL's timers once, as the sketch's loop() would
+static void run_lvgl(void) {
+  host_advance(LV_DEF_REFR_PERIOD);
+  lv_timer_handler();
+}
+
+// Fills the queue with no one applying it, then checks it drains in order
+// and that updates to deleted objects are dropped
+static void test_queue(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  CHECK(glue.begin(&tft, config) == LVGL_OK);
+  run_lvgl(); // Apply anything left by earlier tests
+  lv_obj_t *bar = lv_bar_create(lv_screen_active());
+  lv_obj_t *gone = lv_bar_create(lv_screen_active());
+  CHECK(glue.postValue(gone, 7));
+  lv_obj_delete(gone);
+  for (int i = 1; i < LVGL_COMMAND_QUEUE; i++) {
+    CHECK(glue.postValue(bar, i));
+  }
+  CHECK(!glue.postValue(bar, 1000)); // Full
+  char text[LVGL_COMMAND_TEXT + 1];
+  memset(text, 'x', LVGL_COMMAND_TEXT);
+  text[LVGL_COMMAND_TEXT] = 0;
+  CHECK(!glue.postText(bar, text)); // Too long
+  run_lvgl();
+  CHECK(lv_bar_get_value(bar) == LVGL_COMMAND_QUEUE - 1);
+  CHECK(host_obj_invalidations(bar) == LVGL_COMMAND_QUEUE - 1);
+  CHECK(glue.postValue(bar, 5)); // Room again
+  run_lvgl();
+  CHECK(lv_bar_get_value(bar) == 5);
+  lv_obj_delete(bar);
+}
+
+// Threads post values, texts and redraws as fast as they can, retrying
+// when the queue is full, while the main thread applies them. Each thread
+// has its own object: every update that object sees is one more than the
+// last, and the count matches what the thread posted.
+static void test_stress(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  CHECK(glue.begin(&tft, config) == LVGL_OK);
+  run_lvgl();
+  lv_obj_t *objs[PRODUCERS];
+  for (int p = 0; p < PRODUCERS; p++) {
+    switch (p % 3) {
+    case 0:
+      objs[p] = lv_bar_create(lv_screen_active());
+      break;
+    case 1:
+      objs[p] = lv_label_create(lv_screen_active());
+      break;
+    default:
+      objs[p] = lv_label_create(lv_screen_active()); // Only redrawn
+      break;
+    }
+  }
+  std::atomic<int> running(PRODUCERS);
+  std::atomic<uint32_t> full(0);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < PRODUCERS; p++) {
+    threads.emplace_back([&, p]() {
+      for (int i = 1; i <= POSTS; i++) {
+        char text[16];
+        snprintf(text, sizeof text, "%d", i);
+        bool ok;
+        while (!(ok = (p % 3 == 0)   ? glue.postValue(objs[p], i)
+                      : (p % 3 == 1) ? glue.postText(objs[p], text)
+                                     : glue.postInvalidate(objs[p]))) {
+          full++;
+          std::this_thread::yield();
+        }
+      }
+      running--;
+    });
+  }
+  int32_t seen[PRODUCERS] = {};
+  bool ordered = true, applied;
+  do {
+    run_lvgl();
+    applied = true;
+    for (int p = 0; p < PRODUCERS; p++) {
+      // Every update applied so far has been counted; the latest value
+      // posted must be that count
+      int32_t count = host_obj_invalidations(objs[p]);
+      int32_t value = (p % 3 == 0)   ? lv_bar_get_value(objs[p])
+                      : (p % 3 == 1) ? atoi(lv_label_get_text(objs[p]))
+                                     : count;
+      if ((value != count) || (count < seen[p])) {
+        ordered = false;
+      }
+      seen[p] = count;
+      applied = applied && (count == POSTS);
+    }
+  } while (running || !applied);
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  run_lvgl();
+  CHECK(ordered);
+  for (int p = 0; p < PRODUCERS; p++) {
+    CHECK(host_obj_invalidations(objs[p]) == POSTS);
+  }
+  CHECK(full > 0); // The queue did fill, so producers raced for slots
+  for (int p = 0; p < PRODUCERS; p++) {
+    lv_obj_delete(objs[p]);
+  }
+}
+
+int main(void) {
+  test_queue();
+  test_stress();
+  return host_result("test_commands");
+}
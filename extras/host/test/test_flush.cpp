@@ -0,0 +1,486 @@
+// Flush pipeline: every buffer layout, rotation and flush option must put
+// LvGL's frame on the panel pixel for pixel, without misusing the bus
+#include "host.h"
+#include <Adafruit_LvGL_Glue.h>
+
+#define TFT_W 64
+#define TFT_H 48
+
+// Fills the scene with a pattern that differs per pixel, and per seed
+static void paint(lv_display_t *disp, int32_t x1, int32_t y1, int32_t x2,
+                  int32_t y2, uint32_t seed) {
+  uint16_t *scene = host_scene(disp);
+  int32_t w = lv_display_get_horizontal_resolution(disp);
+  for (int32_t y = y1; y <= y2; y++) {
+    for (int32_t x = x1; x <= x2; x++) {
+      scene[y * w + x] = ((x + y * 1000 + seed * 7919) * 2654435761UL) >> 16;
+    }
+  }
+}
+
+// Changes an area of the scene and has LvGL redraw it
+static void change(lv_display_t *disp, int32_t x1, int32_t y1, int32_t x2,
+                   int32_t y2, uint32_t seed) {
+  paint(disp, x1, y1, x2, y2, seed);
+  host_invalidate(disp, x1, y1, x2, y2);
+}
+
+// Redraws the whole scene with a new pattern
+static void change_all(lv_display_t *disp, uint32_t seed) {
+  change(disp, 0, 0, lv_display_get_horizontal_resolution(disp) - 1,
+         lv_display_get_vertical_resolution(disp) - 1, seed);
+}
+
+// True if the panel shows the scene, turned for the glue's rotation
+static bool matches(Adafruit_SPITFT &tft, lv_display_t *disp,
+                    uint8_t rotation) {
+  const uint16_t *scene = host_scene(disp);
+  int32_t w = lv_display_get_horizontal_resolution(disp);
+  int32_t h = lv_display_get_vertical_resolution(disp);
+  int32_t nw = tft.width(), nh = tft.height();
+  for (int32_t y = 0; y < h; y++) {
+    for (int32_t x = 0; x < w; x++) {
+      int32_t px = x, py = y;
+      switch (rotation) {
+      case 1:
+        px = nw - 1 - y, py = x;
+        break;
+      case 2:
+        px = nw - 1 - x, py = nh - 1 - y;
+        break;
+      case 3:
+        px = y, py = nh - 1 - x;
+        break;
+      }
+      if (tft.pixel(px, py) != scene[y * w + x]) {
+        fprintf(stderr, "pixel %d,%d: panel %04X, scene %04X\n", (int)x,
+                (int)y, tft.pixel(px, py), scene[y * w + x]);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Refreshes and waits for the last transfer, so the panel is complete
+static void refresh(Adafruit_LvGL_Glue &glue) {
+  lv_refr_now(glue.getLvDisplay());
+  glue.waitForFlush();
+}
+
+// Checks that nothing went wrong on the bus or in LvGL's buffer handling
+static void check_clean(Adafruit_SPITFT &tft, lv_display_t *disp) {
+  HostDisplayStats *stats = host_display_stats(disp);
+  CHECK(tft.violations == 0);
+  CHECK(stats->hazards == 0);
+  CHECK(stats->stray_readies == 0);
+  CHECK(stats->flush_readies == stats->flushes);
+  CHECK(!tft.busBusy());
+}
+
+// Full redraws, then changes in a few places, in each buffer layout. Areas
+// are kept at least HOST_DMA_MIN wide.
+static void test_modes(void) {
+  const LvGLBufferMode modes[] = {LVGL_BUFFER_AUTO, LVGL_BUFFER_SINGLE,
+                                  LVGL_BUFFER_DOUBLE, LVGL_BUFFER_FULL_FRAME};
+  for (LvGLBufferMode mode : modes) {
+    Adafruit_SPITFT tft(TFT_W, TFT_H);
+    Adafruit_LvGL_Glue glue;
+    LvGLConfig config = {};
+    config.buffer_mode = mode;
+    CHECK(glue.begin(&tft, config) == LVGL_OK);
+    lv_display_t *disp = glue.getLvDisplay();
+    CHECK(glue.direct_mode == (mode == LVGL_BUFFER_FULL_FRAME));
+    for (uint32_t seed = 1; seed <= 3; seed++) {
+      change_all(disp, seed);
+      refresh(glue);
+      CHECK(matches(tft, disp, 0));
+    }
+    change(disp, 4, 4, 27, 9, 10);
+    change(disp, 30, 20, 60, 40, 11);
+    change(disp, 0, 44, 63, 47, 12);
+    refresh(glue);
+    CHECK(matches(tft, disp, 0));
+    check_clean(tft, disp);
+  }
+}
+
+// Buffers in the caller's memory, one or two depending on its size
+static void test_caller_buffer(void) {
+  static uint8_t mem[TFT_W * 2 * 16 + 2];
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  config.buffer_mode = LVGL_BUFFER_DOUBLE;
+  config.buffer = mem + 2; // Misaligned on purpose
+  config.buffer_size = sizeof mem - 2;
+  CHECK(glue.begin(&tft, config) == LVGL_OK);
+  CHECK(glue.buffer_count == 2);
+  lv_display_t *disp = glue.getLvDisplay();
+  change_all(disp, 5);
+  refresh(glue);
+  CHECK(matches(tft, disp, 0));
+  check_clean(tft, disp);
+}
+
+// Caller's memory with room for only one buffer of the size asked for:
+// DOUBLE is refused, AUTO and FULL_FRAME settle for one
+static void test_caller_buffer_short(void) {
+  static uint8_t mem[TFT_W * 2 * TFT_H + 2];
+  const LvGLBufferMode modes[] = {LVGL_BUFFER_DOUBLE, LVGL_BUFFER_AUTO,
+                                  LVGL_BUFFER_FULL_FRAME};
+  for (LvGLBufferMode mode : modes) {
+    Adafruit_SPITFT tft(TFT_W, TFT_H);
+    Adafruit_LvGL_Glue glue;
+    LvGLConfig config = {};
+    config.buffer_mode = mode;
+    config.buffer_rows = TFT_H;
+    config.buffer = mem;
+    config.buffer_size = sizeof mem;
+    if (mode == LVGL_BUFFER_DOUBLE) {
+      CHECK(glue.begin(&tft, config) == LVGL_ERR_ALLOC);
+      continue;
+    }
+    CHECK(glue.begin(&tft, config) == LVGL_OK);
+    CHECK(glue.buffer_count == 1);
+    lv_display_t *disp = glue.getLvDisplay();
+    change_all(disp, 6);
+    refresh(glue);
+    CHECK(matches(tft, disp, 0));
+    check_clean(tft, disp);
+  }
+}
+
+// The flush counters agree with what LvGL and the panel saw
+static void test_stats(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  config.buffer_rows = 8;
+  CHECK(glue.begin(&tft, config) == LVGL_OK);
+  lv_display_t *disp = glue.getLvDisplay();
+  change_all(disp, 1);
+  refresh(glue);
+  LvGLFlushStats *stats = &glue.flush_stats;
+  CHECK(stats->flushes == TFT_H / 8);
+  CHECK(stats->flushes == host_display_stats(disp)->flushes);
+  CHECK(stats->pixels == TFT_W * TFT_H);
+  CHECK(stats->bytes == TFT_W * TFT_H * 2);
+  CHECK(stats->transactions == 1); // The bands continue one window
+  CHECK(stats->addr_windows == 1);
+  CHECK(stats->windows_saved == stats->flushes - 1);
+  uint32_t timed = 0;
+  for (uint32_t n : stats->latency_hist) {
+    timed += n;
+  }
+  CHECK(timed == stats->flushes);
+  CHECK(tft.transactions == stats->transactions);
+  CHECK(tft.windows == stats->addr_windows);
+#if defined(USE_SPI_DMA)
+  CHECK(tft.dma_transfers == stats->flushes); // Each one left running
+  CHECK(host_display_stats(disp)->flush_waits > 0);
+#else
+  CHECK(tft.dma_transfers == 0);
+#endif
+  check_clean(tft, disp);
+}
+
+// With DMA a flush is only reported done when LvGL waits for it, after
+// its transfer, so LvGL renders the next band while it's sent; the
+// refresh's last transfer is still going when lv_refr_now() returns.
+// Without DMA each flush is done on return.
+static void test_flush_wait(void) {
+  const LvGLBufferMode modes[] = {LVGL_BUFFER_SINGLE, LVGL_BUFFER_DOUBLE};
+  for (LvGLBufferMode mode : modes) {
+    Adafruit_SPITFT tft(TFT_W, TFT_H);
+    Adafruit_LvGL_Glue glue;
+    LvGLConfig config = {};
+    config.buffer_mode = mode;
+    config.buffer_rows = 8;
+    CHECK(glue.begin(&tft, config) == LVGL_OK);
+    lv_display_t *disp = glue.getLvDisplay();
+    HostDisplayStats *stats = host_display_stats(disp);
+    for (uint32_t seed = 1; seed <= 2; seed++) {
+      memset(stats, 0, sizeof *stats);
+      change_all(disp, seed);
+      lv_refr_now(disp);
+      CHECK(stats->flushes == TFT_H / 8);
+#if defined(USE_SPI_DMA)
+      CHECK(tft.dmaBusy());
+      CHECK(stats->flush_readies == stats->flushes - 1);
+      CHECK(stats->flush_waits == stats->flushes - 1);
+      // The next refresh waits for the last transfer itself
+      change(disp, 0, 0, TFT_W - 1, 3, seed + 10);
+      lv_refr_now(disp);
+      CHECK(stats->flush_waits == stats->flushes - 1);
+#else
+      CHECK(!tft.dmaBusy());
+      CHECK(stats->flush_readies == stats->flushes);
+      CHECK(stats->flush_waits == 0);
+#endif
+      glue.waitForFlush();
+      CHECK(stats->flush_readies == stats->flushes);
+      CHECK(matches(tft, disp, 0)); // No buffer reused mid-transfer
+      check_clean(tft, disp);
+    }
+  }
+}
+
+// Frame-diff: unchanged tiles aren't sent, and the panel stays right. One
+// run of changed tiles per band.
+static void test_tiles(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  config.buffer_rows = 8;
+  config.diff_tile = 8;
+  CHECK(glue.begin(&tft, config) == LVGL_OK);
+  lv_display_t *disp = glue.getLvDisplay();
+  change_all(disp, 1);
+  refresh(glue);
+  CHECK(matches(tft, disp, 0));
+  uint32_t tiles = (TFT_W / 8) * (TFT_H / 8);
+  CHECK(glue.flush_stats.tiles_sent == tiles);
+
+  // Redraw everything with only a block of 3x2 tiles changed
+  memset(&glue.flush_stats, 0, sizeof glue.flush_stats);
+  paint(disp, 8, 16, 31, 31, 2);
+  host_invalidate(disp, 0, 0, TFT_W - 1, TFT_H - 1);
+  refresh(glue);
+  CHECK(matches(tft, disp, 0));
+  CHECK(glue.flush_stats.tiles_sent == 6);
+  CHECK(glue.flush_stats.tiles_skipped == tiles - 6);
+  CHECK(glue.flush_stats.pixels == 6 * 8 * 8);
+
+  // An off-grid area is rounded out to whole tiles
+  change(disp, 13, 3, 20, 5, 3);
+  refresh(glue);
+  CHECK(matches(tft, disp, 0));
+
+  // After resetTileHashes() everything is sent again
+  memset(&glue.flush_stats, 0, sizeof glue.flush_stats);
+  glue.resetTileHashes();
+  host_invalidate(disp, 0, 0, TFT_W - 1, TFT_H - 1);
+  refresh(glue);
+  CHECK(glue.flush_stats.tiles_sent == tiles);
+  CHECK(matches(tft, disp, 0));
+  check_clean(tft, disp);
+}
+
+// Frame-diff with two runs of changed tiles in one band: the second run's
+// address window mustn't be set while the first is still going out
+static void test_tile_runs(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  config.buffer_rows = 8;
+  config.diff_tile = 8;
+  CHECK(glue.begin(&tft, config) == LVGL_OK);
+  lv_display_t *disp = glue.getLvDisplay();
+  change_all(disp, 1);
+  refresh(glue);
+  memset(&glue.flush_stats, 0, sizeof glue.flush_stats);
+  paint(disp, 0, 0, 15, 7, 2);
+  paint(disp, 32, 0, 63, 7, 3);
+  paint(disp, 16, 24, 39, 31, 4);
+  paint(disp, 56, 24, 63, 31, 5);
+  host_invalidate(disp, 0, 0, TFT_W - 1, TFT_H - 1);
+  refresh(glue);
+  CHECK(glue.flush_stats.tiles_sent == 2 + 4 + 3 + 1);
+  CHECK(glue.flush_stats.addr_windows == 4);
+  CHECK(matches(tft, disp, 0));
+  check_clean(tft, disp);
+}
+
+// Areas sent row by row, out of a wider buffer: with a GFX port that
+// doesn't wait for the transfer in flight itself, each row must still
+// start only once the one before is out, whether it goes by DMA or PIO
+static void test_strided_rows(void) {
+  for (int direct = 0; direct < 2; direct++) {
+    Adafruit_SPITFT tft(TFT_W, TFT_H);
+    tft.dma_self_wait = false;
+    Adafruit_LvGL_Glue glue;
+    LvGLConfig config = {};
+    if (direct) {
+      config.buffer_mode = LVGL_BUFFER_FULL_FRAME;
+    } else {
+      config.buffer_rows = 8;
+      config.diff_tile = 8;
+    }
+    CHECK(glue.begin(&tft, config) == LVGL_OK);
+    lv_display_t *disp = glue.getLvDisplay();
+    change_all(disp, 1);
+    refresh(glue);
+    paint(disp, 16, 8, 39, 23, 2); // Rows of 24 pixels
+    paint(disp, 48, 32, 55, 39, 3); // Rows of 8
+    if (direct) {
+      host_invalidate(disp, 16, 8, 39, 23);
+      host_invalidate(disp, 48, 32, 55, 39);
+    } else {
+      host_invalidate(disp, 0, 0, TFT_W - 1, TFT_H - 1);
+    }
+    refresh(glue);
+    CHECK(matches(tft, disp, 0));
+    check_clean(tft, disp);
+  }
+}
+
+// Glue rotation on top of each GFX rotation
+static void test_rotation(void) {
+  for (uint8_t gfx = 0; gfx < 2; gfx++) {
+    for (uint8_t rotation = 1; rotation < 4; rotation++) {
+      Adafruit_SPITFT tft(TFT_W, TFT_H);
+      tft.setRotation(gfx);
+      Adafruit_LvGL_Glue glue;
+      LvGLConfig config = {};
+      config.rotation = rotation;
+      config.buffer_rows = 10;
+      CHECK(glue.begin(&tft, config) == LVGL_OK);
+      lv_display_t *disp = glue.getLvDisplay();
+      int32_t w = lv_display_get_horizontal_resolution(disp);
+      int32_t h = lv_display_get_vertical_resolution(disp);
+      CHECK(w == ((rotation & 1) ? tft.height() : tft.width()));
+      CHECK(h == ((rotation & 1) ? tft.width() : tft.height()));
+      change_all(disp, rotation);
+      refresh(glue);
+      CHECK(matches(tft, disp, rotation));
+      change(disp, 5, 7, 20, 30, 9);
+      refresh(glue);
+      CHECK(matches(tft, disp, rotation));
+      check_clean(tft, disp);
+    }
+  }
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  config.rotation = 1;
+  config.buffer_mode = LVGL_BUFFER_FULL_FRAME;
+  CHECK(glue.begin(&tft, config) == LVGL_ERR_CONFIG);
+}
+
+// Full-row widening: a small area costs less than another window
+static void test_window_cost(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  config.window_cost = 1000;
+  CHECK(glue.begin(&tft, config) == LVGL_OK);
+  lv_display_t *disp = glue.getLvDisplay();
+  change_all(disp, 1);
+  refresh(glue);
+  memset(&glue.flush_stats, 0, sizeof glue.flush_stats);
+  change(disp, 10, 10, 19, 13, 2); // 40 pixels, 216 more to widen
+  change(disp, 40, 14, 49, 15, 3); // Right below: continues the window
+  refresh(glue);
+  CHECK(matches(tft, disp, 0));
+  CHECK(glue.flush_stats.pixels == TFT_W * 6);
+  CHECK(glue.flush_stats.addr_windows == 1);
+  check_clean(tft, disp);
+}
+
+// Captures get LvGL's frame, whatever frame-diff sends
+static void test_capture(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  config.diff_tile = 8;
+  CHECK(glue.begin(&tft, config) == LVGL_OK);
+  lv_display_t *disp = glue.getLvDisplay();
+  change_all(disp, 4);
+  refresh(glue);
+
+  std::vector<uint16_t> frame(TFT_W * TFT_H);
+  LvGLCaptureRAM ram(frame.data(), frame.size() * sizeof(uint16_t));
+  CHECK(glue.captureFrame(ram));
+  CHECK(!memcmp(frame.data(), host_scene(disp), frame.size() * 2));
+  LvGLCaptureRAM small(frame.data(), 100);
+  CHECK(!glue.captureFrame(small));
+
+  LvGLCaptureHash hash;
+  CHECK(glue.captureFrame(hash));
+  uint32_t expect = 2166136261UL;
+  for (uint16_t pixel : frame) {
+    expect = (expect ^ pixel) * 16777619UL;
+  }
+  CHECK(hash.hash == expect);
+  CHECK(matches(tft, disp, 0));
+  check_clean(tft, disp);
+}
+
+// Changes a random area at least HOST_DMA_MIN wide, from a xorshift state
+static void change_random(lv_display_t *disp, uint32_t *state) {
+  int32_t w = lv_display_get_horizontal_resolution(disp);
+  int32_t h = lv_display_get_vertical_resolution(disp);
+  uint32_t r[4];
+  for (uint32_t &v : r) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    v = *state;
+  }
+  int32_t x1 = r[0] % (w - HOST_DMA_MIN + 1);
+  int32_t x2 = x1 + HOST_DMA_MIN - 1 + r[1] % (w - x1 - HOST_DMA_MIN + 1);
+  int32_t y1 = r[2] % h;
+  int32_t y2 = y1 + r[3] % (h - y1);
+  change(disp, x1, y1, x2, y2, *state);
+}
+
+// Two displays at once, each on its own bus, in each buffer layout, with
+// frame-diff and glue rotation: interleaved changes to both must each end
+// up on their own panel only
+static void test_instances(void) {
+  struct {
+    LvGLBufferMode mode;
+    uint16_t diff_tile;
+    uint8_t rotation;
+  } const setups[] = {
+      {LVGL_BUFFER_AUTO, 0, 0},       {LVGL_BUFFER_SINGLE, 0, 0},
+      {LVGL_BUFFER_DOUBLE, 0, 0},     {LVGL_BUFFER_FULL_FRAME, 0, 0},
+      {LVGL_BUFFER_DOUBLE, 8, 0},     {LVGL_BUFFER_FULL_FRAME, 8, 0},
+      {LVGL_BUFFER_SINGLE, 0, 1},     {LVGL_BUFFER_DOUBLE, 8, 3},
+  };
+  uint32_t state = 1;
+  for (const auto &setup : setups) {
+    Adafruit_SPITFT tft1(TFT_W, TFT_H), tft2(32, 32);
+    tft2.bus = 1;
+    Adafruit_LvGL_Glue glue1, glue2;
+    LvGLConfig config = {};
+    config.buffer_mode = setup.mode;
+    config.diff_tile = setup.diff_tile;
+    config.rotation = setup.rotation;
+    CHECK(glue1.begin(&tft1, config) == LVGL_OK);
+    CHECK(glue2.begin(&tft2, config) == LVGL_OK);
+    lv_display_t *disp1 = glue1.getLvDisplay(), *disp2 = glue2.getLvDisplay();
+    CHECK(disp1 != disp2);
+    change_all(disp1, 1);
+    change_all(disp2, 2);
+    for (int round = 0; round < 20; round++) {
+      for (int i = 0; i < 3; i++) {
+        change_random((state & 1) ? disp1 : disp2, &state);
+      }
+      lv_refr_now(NULL);
+      glue1.waitForFlush();
+      glue2.waitForFlush();
+      CHECK(matches(tft1, disp1, setup.rotation));
+      CHECK(matches(tft2, disp2, setup.rotation));
+    }
+    check_clean(tft1, disp1);
+    check_clean(tft2, disp2);
+  }
+}
+
+int main(void) {
+  test_modes();
+  test_caller_buffer();
+  test_caller_buffer_short();
+  test_stats();
+  test_flush_wait();
+  test_tiles();
+  test_tile_runs();
+  test_strided_rows();
+  test_rotation();
+  test_window_cost();
+  test_capture();
+  test_instances();
+  return host_result("test_flush");
+}
@@ -0,0 +1,524 @@
+// SD card drive: what LvGL reads and writes through S: must match the card,
+// through the read-ahead and file caches, idle handles, the bundle and the
+// streaming image decoder, with the card never used mid-transfer
+#include "host.h"
+#include "pack.h"
+#include <Adafruit_LvGL_Glue_SD.h>
+
+#define TFT_W 64
+#define TFT_H 48
+
+// Test file contents: bytes that differ per offset and per seed
+static Bytes file_data(size_t len, uint32_t seed) {
+  Bytes data(len);
+  for (size_t i = 0; i < len; i++) {
+    data[i] = (i * 131 + seed * 71 + (i >> 8)) & 0xFF;
+  }
+  return data;
+}
+
+static void put(const char *path, const Bytes &data) {
+  host_sd_put(path, data.data(), data.size());
+}
+
+// Reads a whole file through LvGL, in chunks of 'chunk' bytes
+static bool read_all(const char *path, uint32_t chunk, Bytes *out) {
+  lv_fs_file_t file;
+  if (lv_fs_open(&file, path, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+    return false;
+  }
+  out->clear();
+  Bytes buf(chunk);
+  uint32_t br;
+  bool ok;
+  while ((ok = (lv_fs_read(&file, buf.data(), chunk, &br) == LV_FS_RES_OK)) &&
+         br) {
+    out->insert(out->end(), buf.begin(), buf.begin() + br);
+  }
+  return (lv_fs_close(&file) == LV_FS_RES_OK) && ok;
+}
+
+static bool write_all(const char *path, const Bytes &data, uint32_t chunk,
+                      lv_fs_mode_t mode = LV_FS_MODE_WR) {
+  lv_fs_file_t file;
+  if (lv_fs_open(&file, path, mode) != LV_FS_RES_OK) {
+    return false;
+  }
+  bool ok = true;
+  if (mode & LV_FS_MODE_RD) {
+    ok = lv_fs_seek(&file, 0, LV_FS_SEEK_END) == LV_FS_RES_OK;
+  }
+  for (size_t at = 0; ok && (at < data.size()); at += chunk) {
+    uint32_t n = std::min((size_t)chunk, data.size() - at), bw;
+    ok = (lv_fs_write(&file, &data[at], n, &bw) == LV_FS_RES_OK) && (bw == n);
+  }
+  return (lv_fs_close(&file) == LV_FS_RES_OK) && ok;
+}
+
+static bool card_has(const char *path, const Bytes &data) {
+  Bytes on_card;
+  return host_sd_get(path, &on_card) && (on_card == data);
+}
+
+// Starts a full redraw and leaves its last transfer in flight, so the
+// next card access has to wait for the bus
+static void busy_display(Adafruit_LvGL_Glue &glue) {
+  host_invalidate(glue.getLvDisplay(), 0, 0, TFT_W - 1, TFT_H - 1);
+  lv_refr_now(glue.getLvDisplay());
+}
+
+// Reads: small reads come out of the read-ahead cache, big ones go
+// straight to the card, seeking works, and the card is only touched once
+// the display's transfer is over
+static void test_read(void) {
+  host_sd_reset();
+  Bytes data = file_data(3000, 1);
+  put("dir/a.bin", data);
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  SdFat sd;
+  Adafruit_LvGL_Glue_SD glue;
+  LvGLConfig config = {};
+  CHECK(glue.begin(&tft, &sd, config) == LVGL_OK);
+  Bytes got;
+  busy_display(glue);
+  CHECK(read_all("S:dir/a.bin", 100, &got) && (got == data));
+  CHECK(glue.sd_stats.sd_reads == 6); // 512-byte read-ahead
+  CHECK(glue.sd_stats.hits > glue.sd_stats.sd_reads);
+  CHECK(read_all("S:/dir/a.bin", 1024, &got) && (got == data));
+
+  lv_fs_file_t file;
+  uint8_t buf[10];
+  uint32_t br, pos;
+  CHECK(lv_fs_open(&file, "S:dir/a.bin", LV_FS_MODE_RD) == LV_FS_RES_OK);
+  CHECK(lv_fs_seek(&file, 2995, LV_FS_SEEK_SET) == LV_FS_RES_OK);
+  CHECK((lv_fs_read(&file, buf, 10, &br) == LV_FS_RES_OK) && (br == 5));
+  CHECK(!memcmp(buf, &data[2995], 5));
+  CHECK((lv_fs_tell(&file, &pos) == LV_FS_RES_OK) && (pos == 3000));
+  CHECK(lv_fs_seek(&file, 700, LV_FS_SEEK_SET) == LV_FS_RES_OK);
+  CHECK((lv_fs_read(&file, buf, 10, &br) == LV_FS_RES_OK) && (br == 10));
+  CHECK(!memcmp(buf, &data[700], 10));
+  CHECK(lv_fs_close(&file) == LV_FS_RES_OK);
+  CHECK(lv_fs_open(&file, "S:dir/none.bin", LV_FS_MODE_RD) != LV_FS_RES_OK);
+  CHECK(host_sd.opens == host_sd.closes);
+  CHECK(tft.violations == 0);
+}
+
+// Writes are gathered into whole cache-fulls, appends keep what's there,
+// what's written reads back, and seeks stay within the file
+static void test_write(void) {
+  host_sd_reset();
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  SdFat sd;
+  Adafruit_LvGL_Glue_SD glue;
+  LvGLConfig config = {};
+  CHECK(glue.begin(&tft, &sd, config) == LVGL_OK);
+  Bytes data = file_data(1500, 2), more = file_data(700, 3), got;
+  busy_display(glue);
+  CHECK(write_all("S:log.txt", data, 10));
+  CHECK(card_has("log.txt", data));
+  CHECK(glue.sd_stats.writes == 150);
+  CHECK(glue.sd_stats.sd_writes == 3);
+  busy_display(glue);
+  CHECK(write_all("S:log.txt", more, 100,
+                  (lv_fs_mode_t)(LV_FS_MODE_WR | LV_FS_MODE_RD)));
+  Bytes both = data;
+  both.insert(both.end(), more.begin(), more.end());
+  CHECK(card_has("log.txt", both));
+  CHECK(write_all("S:log.txt", more, 2000)); // Big write, and truncates
+  CHECK(card_has("log.txt", more));
+  CHECK(read_all("S:log.txt", 64, &got) && (got == more));
+
+  lv_fs_file_t file;
+  uint32_t bw, br, pos;
+  uint8_t buf[10];
+  CHECK(lv_fs_open(&file, "S:log.txt", LV_FS_MODE_RD) == LV_FS_RES_OK);
+  CHECK(lv_fs_write(&file, "x", 1, &bw) == LV_FS_RES_DENIED);
+
+  // Seeks from the current position or the end go either way, but not
+  // before the start or past the end
+  CHECK(lv_fs_seek(&file, 100, LV_FS_SEEK_SET) == LV_FS_RES_OK);
+  CHECK(lv_fs_seek(&file, (uint32_t)-40, LV_FS_SEEK_CUR) == LV_FS_RES_OK);
+  CHECK((lv_fs_read(&file, buf, 10, &br) == LV_FS_RES_OK) && (br == 10));
+  CHECK(!memcmp(buf, &more[60], 10));
+  CHECK(lv_fs_seek(&file, (uint32_t)-71, LV_FS_SEEK_CUR) ==
+        LV_FS_RES_INV_PARAM);
+  CHECK(lv_fs_seek(&file, (uint32_t)-701, LV_FS_SEEK_END) ==
+        LV_FS_RES_INV_PARAM);
+  CHECK(lv_fs_seek(&file, 1, LV_FS_SEEK_END) == LV_FS_RES_INV_PARAM);
+  CHECK(lv_fs_seek(&file, 701, LV_FS_SEEK_SET) == LV_FS_RES_INV_PARAM);
+  CHECK(lv_fs_seek(&file, 631, LV_FS_SEEK_CUR) == LV_FS_RES_INV_PARAM);
+  CHECK((lv_fs_tell(&file, &pos) == LV_FS_RES_OK) && (pos == 70));
+  CHECK(lv_fs_seek(&file, (uint32_t)-10, LV_FS_SEEK_END) == LV_FS_RES_OK);
+  CHECK((lv_fs_read(&file, buf, 10, &br) == LV_FS_RES_OK) && (br == 10));
+  CHECK(!memcmp(buf, &more[690], 10));
+  CHECK(lv_fs_close(&file) == LV_FS_RES_OK);
+
+  // Writing: back over what's there is fine, past the end is refused
+  // rather than left to fail at the card
+  CHECK(lv_fs_open(&file, "S:log.txt",
+                   (lv_fs_mode_t)(LV_FS_MODE_WR | LV_FS_MODE_RD)) ==
+        LV_FS_RES_OK);
+  CHECK(lv_fs_seek(&file, 1, LV_FS_SEEK_END) == LV_FS_RES_INV_PARAM);
+  CHECK(lv_fs_seek(&file, 0, LV_FS_SEEK_END) == LV_FS_RES_OK);
+  CHECK(lv_fs_seek(&file, (uint32_t)-2, LV_FS_SEEK_CUR) == LV_FS_RES_OK);
+  CHECK((lv_fs_write(&file, "xyz", 3, &bw) == LV_FS_RES_OK) && (bw == 3));
+  CHECK(lv_fs_seek(&file, (uint32_t)-702, LV_FS_SEEK_CUR) ==
+        LV_FS_RES_INV_PARAM);
+  CHECK(lv_fs_close(&file) == LV_FS_RES_OK);
+  Bytes patched = more;
+  patched.resize(698);
+  patched.insert(patched.end(), {'x', 'y', 'z'});
+  CHECK(card_has("log.txt", patched));
+  CHECK(host_sd.opens == host_sd.closes);
+  CHECK(tft.violations == 0);
+}
+
+// File cache: a file read again comes from RAM, and writing it drops the
+// stale copy
+static void test_file_cache(void) {
+  host_sd_reset();
+  Bytes data = file_data(1000, 4), other = file_data(900, 5), got;
+  put("icon.bin", data);
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  SdFat sd;
+  Adafruit_LvGL_Glue_SD glue;
+  LvGLConfig config = {};
+  config.sd_cache_bytes = 4096;
+  CHECK(glue.begin(&tft, &sd, config) == LVGL_OK);
+  CHECK(read_all("S:icon.bin", 100, &got) && (got == data));
+  uint32_t opens = host_sd.opens;
+  CHECK(read_all("S:icon.bin", 100, &got) && (got == data));
+  CHECK(host_sd.opens == opens);
+  CHECK(glue.sd_stats.cache_hits == 1);
+  CHECK(glue.sd_stats.cache_used == 1000);
+  CHECK(write_all("S:icon.bin", other, 100));
+  CHECK(glue.sd_stats.cache_used == 0);
+  CHECK(read_all("S:icon.bin", 100, &got) && (got == other));
+
+  // Over half the budget isn't cached; the least recently used goes first
+  put("big.bin", file_data(2100, 6));
+  CHECK(read_all("S:big.bin", 512, &got));
+  CHECK(glue.sd_stats.cache_used == 900);
+  for (int i = 0; i < 4; i++) {
+    char path[16];
+    snprintf(path, sizeof path, "f%d.bin", i);
+    put(path, file_data(1000, 10 + i));
+    snprintf(path, sizeof path, "S:f%d.bin", i);
+    CHECK(read_all(path, 100, &got) && (got == file_data(1000, 10 + i)));
+  }
+  CHECK(glue.sd_stats.cache_evictions == 1); // icon.bin, to fit f3.bin
+  CHECK(glue.sd_stats.cache_used == 4000);
+  glue.clearFileCache();
+  CHECK(glue.sd_stats.cache_used == 0);
+  CHECK(host_sd.opens == host_sd.closes);
+}
+
+// Files LvGL still has open when the glue is destroyed don't keep their
+// cache entries
+static void test_cache_teardown(void) {
+  host_sd_reset();
+  put("a.bin", file_data(1000, 1));
+  put("b.bin", file_data(800, 2));
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  SdFat sd;
+  LvGLConfig config = {};
+  config.sd_cache_bytes = 4096;
+  for (int round = 0; round < 2; round++) {
+    size_t heap = host_heap_used();
+    {
+      Adafruit_LvGL_Glue_SD glue;
+      CHECK(glue.begin(&tft, &sd, config) == LVGL_OK);
+      lv_fs_file_t a, b;
+      CHECK(lv_fs_open(&a, "S:a.bin", LV_FS_MODE_RD) == LV_FS_RES_OK);
+      CHECK(lv_fs_open(&b, "S:b.bin", LV_FS_MODE_RD) == LV_FS_RES_OK);
+      CHECK(lv_fs_close(&b) == LV_FS_RES_OK);
+      CHECK(glue.sd_stats.cache_used == 1800);
+    } // a.bin left open
+    if (round) { // The first round may set up things that stay
+      CHECK(host_heap_used() == heap);
+    }
+  }
+}
+
+// Idle handles: a file opened again soon is picked up where it was left,
+// without the card; writing the file drops the idle handle
+static void test_keep_open(void) {
+  host_sd_reset();
+  Bytes data = file_data(800, 7), other = file_data(600, 8), got;
+  put("font.bin", data);
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  SdFat sd;
+  Adafruit_LvGL_Glue_SD glue;
+  LvGLConfig config = {};
+  config.sd_keep_open = true;
+  CHECK(glue.begin(&tft, &sd, config) == LVGL_OK);
+  CHECK(read_all("S:font.bin", 100, &got) && (got == data));
+  uint32_t opens = host_sd.opens;
+  CHECK(read_all("S:font.bin", 100, &got) && (got == data));
+  CHECK(host_sd.opens == opens);
+  CHECK(glue.sd_stats.handle_reuses == 1);
+  CHECK(write_all("S:font.bin", other, 100));
+  CHECK(read_all("S:font.bin", 100, &got) && (got == other));
+  CHECK(glue.sd_stats.handle_reuses == 1);
+  glue.clearFileCache();
+  CHECK(host_sd.opens == host_sd.closes);
+}
+
+// A fixed pool of handles: when they're all open, the next open fails
+// cleanly; an idle one is taken over
+static void test_handles(void) {
+  host_sd_reset();
+  put("a", file_data(10, 1));
+  put("b", file_data(10, 2));
+  put("c", file_data(10, 3));
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  SdFat sd;
+  Adafruit_LvGL_Glue_SD glue;
+  LvGLConfig config = {};
+  config.sd_handles = 2;
+  config.sd_keep_open = true;
+  CHECK(glue.begin(&tft, &sd, config) == LVGL_OK);
+  lv_fs_file_t a, b, c;
+  CHECK(lv_fs_open(&a, "S:a", LV_FS_MODE_RD) == LV_FS_RES_OK);
+  CHECK(lv_fs_open(&b, "S:b", LV_FS_MODE_RD) == LV_FS_RES_OK);
+  CHECK(lv_fs_open(&c, "S:c", LV_FS_MODE_RD) != LV_FS_RES_OK);
+  CHECK(glue.sd_stats.handle_fails == 1);
+  CHECK(lv_fs_close(&a) == LV_FS_RES_OK); // Kept open, idle
+  CHECK(lv_fs_open(&c, "S:c", LV_FS_MODE_RD) == LV_FS_RES_OK);
+  CHECK(lv_fs_close(&b) == LV_FS_RES_OK);
+  CHECK(lv_fs_close(&c) == LV_FS_RES_OK);
+  glue.clearFileCache();
+  CHECK(host_sd.opens == host_sd.closes);
+}
+
+// Directory listing: subdirectories get a '/' in front, then ""
+static void test_dir(void) {
+  host_sd_reset();
+  put("d/x.bin", file_data(1, 1));
+  put("d/y.txt", file_data(1, 1));
+  host_sd_mkdir("d/sub");
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  SdFat sd;
+  Adafruit_LvGL_Glue_SD glue;
+  LvGLConfig config = {};
+  CHECK(glue.begin(&tft, &sd, config) == LVGL_OK);
+  lv_fs_dir_t dir;
+  char name[32];
+  std::vector<std::string> names;
+  CHECK(lv_fs_dir_open(&dir, "S:d") == LV_FS_RES_OK);
+  while ((lv_fs_dir_read(&dir, name, sizeof name) == LV_FS_RES_OK) &&
+         name[0]) {
+    names.push_back(name);
+  }
+  CHECK(lv_fs_dir_close(&dir) == LV_FS_RES_OK);
+  CHECK(names == std::vector<std::string>({"/sub", "x.bin", "y.txt"}));
+  CHECK(lv_fs_dir_open(&dir, "S:d/x.bin") != LV_FS_RES_OK);
+  CHECK(host_sd.opens == host_sd.closes);
+}
+
+// Bundle: assets in it open through its index with no card lookup; other
+// paths still go to the card; a damaged bundle is refused
+static void test_bundle(void) {
+  host_sd_reset();
+  Bytes a = file_data(300, 1), b = file_data(1200, 2), loose = file_data(50, 3);
+  Bytes pack = make_pack({{"icons/a.bin", a}, {"b.bin", b}}, 512);
+  put("assets.pak", pack);
+  put("loose.bin", loose);
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  SdFat sd;
+  Adafruit_LvGL_Glue_SD glue;
+  LvGLConfig config = {};
+  config.sd_bundle = "assets.pak";
+  CHECK(glue.begin(&tft, &sd, config) == LVGL_OK);
+  CHECK(glue.bundle_count == 2);
+  Bytes got;
+  uint32_t opens = host_sd.opens;
+  CHECK(read_all("S:icons/a.bin", 64, &got) && (got == a));
+  CHECK(read_all("S:/b.bin", 100, &got) && (got == b));
+  CHECK(host_sd.opens == opens);
+  CHECK(glue.sd_stats.bundle_opens == 2);
+  CHECK(read_all("S:loose.bin", 64, &got) && (got == loose));
+
+  Bytes bad = pack;
+  bad.resize(pack.size() - 1); // Last asset runs off the end
+  put("bad.pak", bad);
+  Adafruit_LvGL_Glue_SD glue2;
+  config.sd_bundle = "bad.pak";
+  CHECK(glue2.begin(&tft, &sd, config) == LVGL_ERR_FORMAT);
+  config.sd_bundle = "none.pak";
+  Adafruit_LvGL_Glue_SD glue3;
+  CHECK(glue3.begin(&tft, &sd, config) == LVGL_ERR_CONFIG);
+}
+
+// Draws a file image through LvGL's decoders band by band, as LvGL does,
+// into pixels; false if no decoder took it
+static bool draw_image(const char *path, uint32_t w, uint32_t h,
+                       uint32_t y1, std::vector<uint16_t> *pixels) {
+  lv_image_decoder_dsc_t dsc;
+  if (lv_image_decoder_open(&dsc, path, NULL) != LV_RESULT_OK) {
+    return false;
+  }
+  bool ok = (dsc.header.w == w) && (dsc.header.h == h);
+  lv_area_t full = {0, (int32_t)y1, (int32_t)w - 1, (int32_t)h - 1};
+  lv_area_t part = {LV_COORD_MIN, LV_COORD_MIN, LV_COORD_MIN, LV_COORD_MIN};
+  pixels->assign(w * h, 0);
+  while (ok && (part.y2 != full.y2) &&
+         (lv_image_decoder_get_area(&dsc, &full, &part) == LV_RESULT_OK)) {
+    for (int32_t y = part.y1; y <= part.y2; y++) {
+      memcpy(&(*pixels)[y * w],
+             dsc.decoded->data + (y - part.y1) * dsc.decoded->header.stride,
+             w * 2);
+    }
+  }
+  ok = ok && (part.y2 == full.y2);
+  lv_image_decoder_close(&dsc);
+  return ok;
+}
+
+// Streaming decoder: big raw images and RLE and Q565 ones decode band by
+// band to the right pixels; an image drawn again picks up where it was;
+// small raw images are left to LvGL
+static void test_stream(void) {
+  host_sd_reset();
+  uint32_t w = 40, h = 30;
+  std::vector<uint16_t> pixels = image_pixels(w, h), got;
+  put("raw.bin", image_raw(pixels, w, h));
+  put("rle.bin", image_compressed(1, rle_encode(pixels), w, h));
+  put("q565.bin",
+      image_compressed(LVGL_COMPRESS_Q565, q565_encode(pixels), w, h));
+  put("small.bin", image_raw(image_pixels(4, 4), 4, 4));
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  SdFat sd;
+  Adafruit_LvGL_Glue_SD glue;
+  LvGLConfig config = {};
+  config.sd_stream_bytes = 1024;
+  config.sd_stream_rows = 7;
+  CHECK(glue.begin(&tft, &sd, config) == LVGL_OK);
+  const char *paths[] = {"S:raw.bin", "S:rle.bin", "S:q565.bin"};
+  for (const char *path : paths) {
+    CHECK(draw_image(path, w, h, 0, &got) && (got == pixels));
+  }
+  CHECK(glue.sd_stats.stream_bands == 3 * 5);
+  CHECK(glue.sd_stats.stream_rewinds == 0);
+
+  // Again, lower half only: the same image resumes, but it has to be
+  // decoded from the top to get back to row 15
+  uint32_t bands = glue.sd_stats.stream_bands;
+  CHECK(draw_image("S:q565.bin", w, h, 0, &got) && (got == pixels));
+  CHECK(glue.sd_stats.stream_bands == bands + 5);
+  CHECK(glue.sd_stats.stream_rewinds == 1);
+  CHECK(draw_image("S:q565.bin", w, h, 15, &got));
+  CHECK(!memcmp(&got[15 * w], &pixels[15 * w], 15 * w * 2));
+  CHECK(glue.sd_stats.stream_rewinds == 2);
+  CHECK(glue.sd_stats.stream_skipped >= 15);
+
+  // Replaced through S: while left open, here by a raw image: drawn
+  // again, it's the new image
+  std::vector<uint16_t> other(pixels.rbegin(), pixels.rend());
+  CHECK(write_all("S:q565.bin", image_raw(other, w, h), 256));
+  CHECK(draw_image("S:q565.bin", w, h, 0, &got) && (got == other));
+
+  CHECK(!draw_image("S:small.bin", 4, 4, 0, &got));
+  glue.clearFileCache();
+  CHECK(host_sd.opens == host_sd.closes);
+}
+
+// File sink that notes whether the display still had the bus whenever it
+// was handed an area
+class BusCheckFile : public LvGLCaptureFile {
+public:
+  BusCheckFile(const char *path, Adafruit_LvGL_Glue &glue)
+      : LvGLCaptureFile(path), glue(glue), busy(0) {}
+  bool write(const lv_area_t *area, const uint16_t *pixels, uint32_t stride) {
+    busy += glue.dma_busy || glue.in_transaction;
+    return LvGLCaptureFile::write(area, pixels, stride);
+  }
+  Adafruit_LvGL_Glue &glue;
+  uint32_t busy;
+};
+
+// A capture written to S: matches one kept in RAM. The file sink writes to
+// the card from within LvGL's flushes, each time finding the bus free.
+static void test_capture_file(void) {
+  host_sd_reset();
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  SdFat sd;
+  Adafruit_LvGL_Glue_SD glue;
+  LvGLConfig config = {};
+  config.buffer_rows = 10; // Several areas, the last one short
+  CHECK(glue.begin(&tft, &sd, config) == LVGL_OK);
+  lv_display_t *disp = glue.getLvDisplay();
+  uint16_t *scene = host_scene(disp);
+  for (uint32_t i = 0; i < TFT_W * TFT_H; i++) {
+    scene[i] = (i * 2654435761UL) >> 16;
+  }
+  std::vector<uint16_t> frame(TFT_W * TFT_H);
+  LvGLCaptureRAM ram(frame.data(), frame.size() * sizeof(uint16_t));
+  CHECK(glue.captureFrame(ram));
+
+  HostDisplayStats *stats = host_display_stats(disp);
+  uint32_t flushes = stats->flushes;
+  LvGLBusStats bus = glue.bus_stats;
+  BusCheckFile file("S:shot.bin", glue);
+  CHECK(glue.captureFrame(file));
+  CHECK(file.busy == 0);
+  CHECK(glue.bus_stats.claims[LVGL_BUS_SD] >=
+        bus.claims[LVGL_BUS_SD] + (stats->flushes - flushes));
+  CHECK(glue.bus_stats.waited[LVGL_BUS_SD] == bus.waited[LVGL_BUS_SD]);
+
+  Bytes shot;
+  CHECK(host_sd_get("shot.bin", &shot));
+  CHECK(shot.size() == sizeof(lv_image_header_t) + TFT_W * TFT_H * 2);
+  lv_image_header_t header;
+  memcpy(&header, shot.data(), sizeof header);
+  CHECK(header.magic == LV_IMAGE_HEADER_MAGIC);
+  CHECK(header.cf == LV_COLOR_FORMAT_RGB565);
+  CHECK(!header.flags);
+  CHECK((header.w == TFT_W) && (header.h == TFT_H));
+  CHECK(header.stride == TFT_W * 2);
+  CHECK(!memcmp(shot.data() + sizeof header, frame.data(),
+                frame.size() * 2));
+  CHECK(!memcmp(frame.data(), scene, frame.size() * 2));
+  CHECK(tft.violations == 0);
+  CHECK(stats->hazards == 0);
+  CHECK(stats->stray_readies == 0);
+  CHECK(stats->flush_readies == stats->flushes);
+  CHECK(host_sd.opens == host_sd.closes);
+}
+
+// Touch calibration saved to the card and loaded back
+static void test_touch_calibration(void) {
+  host_sd_reset();
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  TouchScreen touch;
+  SdFat sd;
+  Adafruit_LvGL_Glue_SD glue;
+  LvGLConfig config = {};
+  CHECK(glue.begin(&tft, &touch, &sd, config) == LVGL_OK);
+  LvGLTouchCalibration cal = glue.getTouchCalibration();
+  cal.matrix[2] += 65536 * 3;
+  CHECK(glue.setTouchCalibration(cal));
+  CHECK(glue.saveTouchCalibration("S:touch.cal"));
+  Bytes saved;
+  CHECK(host_sd_get("touch.cal", &saved) && (saved.size() == sizeof cal));
+  Adafruit_LvGL_Glue_SD glue2;
+  CHECK(glue2.begin(&tft, &touch, &sd, config) == LVGL_OK);
+  CHECK(glue2.loadTouchCalibration("S:touch.cal"));
+  CHECK(!memcmp(&glue2.getTouchCalibration(), &cal, sizeof cal));
+  CHECK(!glue2.loadTouchCalibration("S:none.cal"));
+}
+
+int main(void) {
+  test_read();
+  test_write();
+  test_file_cache();
+  test_cache_teardown();
+  test_keep_open();
+  test_handles();
+  test_dir();
+  test_bundle();
+  test_stream();
+  test_capture_file();
+  test_touch_calibration();
+  return host_result("test_sd");
+}
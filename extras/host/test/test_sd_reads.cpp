@@ -0,0 +1,176 @@
+// Card traffic: a fixed pattern of icon reads and background draws (raw,
+// RLE and Q565), as a screen redrawn a few times would make, counted at
+// the card with and without the file cache. The read-ahead cache must turn
+// LvGL's small reads into whole sectors, the file cache must leave only
+// the first frame's icon reads, and streamed images must be read in
+// sectors or more.
+#include "host.h"
+#include "pack.h"
+#include <Adafruit_LvGL_Glue_SD.h>
+
+#define TFT_W 64
+#define TFT_H 48
+#define FRAMES 10
+#define ICONS 4
+#define BG_W 160
+#define BG_H 120
+
+// Reads at the card, from host_sd
+typedef struct {
+  uint32_t opens;
+  uint32_t reads;
+  uint32_t small_reads;
+  uint32_t bytes;
+} Traffic;
+
+static Traffic traffic_since(const Traffic &start) {
+  return {host_sd.opens - start.opens, host_sd.reads - start.reads,
+          host_sd.small_reads - start.small_reads,
+          host_sd.read_bytes - start.bytes};
+}
+
+static Traffic traffic_now(void) { return traffic_since(Traffic{}); }
+
+static void report(const char *what, const Traffic &t) {
+  printf("%-28s %5u opens %5u reads (%u small) %7u bytes\n", what,
+         (unsigned)t.opens, (unsigned)t.reads, (unsigned)t.small_reads,
+         (unsigned)t.bytes);
+}
+
+// Reads an icon as LvGL's image decoder does: the header, then the rest
+// in chunks
+static bool read_icon(const char *path) {
+  lv_fs_file_t file;
+  uint8_t buf[256];
+  uint32_t br;
+  if (lv_fs_open(&file, path, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+    return false;
+  }
+  bool ok = (lv_fs_read(&file, buf, sizeof(lv_image_header_t), &br) ==
+             LV_FS_RES_OK);
+  while (ok && (lv_fs_read(&file, buf, sizeof buf, &br) == LV_FS_RES_OK) &&
+         br) {
+  }
+  return (lv_fs_close(&file) == LV_FS_RES_OK) && ok;
+}
+
+// Draws a streamed image top to bottom, band by band, as LvGL does
+static bool draw_image(const char *path) {
+  lv_image_decoder_dsc_t dsc;
+  if (lv_image_decoder_open(&dsc, path, NULL) != LV_RESULT_OK) {
+    return false;
+  }
+  lv_area_t full = {0, 0, BG_W - 1, BG_H - 1};
+  lv_area_t part = {LV_COORD_MIN, LV_COORD_MIN, LV_COORD_MIN, LV_COORD_MIN};
+  while ((part.y2 != full.y2) &&
+         (lv_image_decoder_get_area(&dsc, &full, &part) == LV_RESULT_OK)) {
+  }
+  lv_image_decoder_close(&dsc);
+  return part.y2 == full.y2;
+}
+
+// Icons, each read once per frame
+static Traffic run_icons(Adafruit_LvGL_Glue_SD &glue) {
+  Traffic start = traffic_now();
+  for (int frame = 0; frame < FRAMES; frame++) {
+    for (int i = 0; i < ICONS; i++) {
+      char path[24];
+      snprintf(path, sizeof path, "S:icons/i%d.bin", i);
+      CHECK(read_icon(path));
+    }
+  }
+  return traffic_since(start);
+}
+
+// A background, drawn once per frame
+static Traffic run_background(const char *path) {
+  Traffic start = traffic_now();
+  for (int frame = 0; frame < FRAMES; frame++) {
+    CHECK(draw_image(path));
+  }
+  return traffic_since(start);
+}
+
+static void put_files(void) {
+  host_sd_reset();
+  for (int i = 0; i < ICONS; i++) {
+    char path[24];
+    snprintf(path, sizeof path, "icons/i%d.bin", i);
+    Bytes icon = image_raw(image_pixels(25, 20), 25, 20); // 1012 bytes
+    host_sd_put(path, icon.data(), icon.size());
+  }
+  std::vector<uint16_t> bg = image_pixels(BG_W, BG_H);
+  Bytes raw = image_raw(bg, BG_W, BG_H);
+  Bytes rle = image_compressed(1, rle_encode(bg), BG_W, BG_H);
+  Bytes q565 = image_compressed(LVGL_COMPRESS_Q565, q565_encode(bg), BG_W,
+                                BG_H);
+  host_sd_put("bg.bin", raw.data(), raw.size());
+  host_sd_put("bg_rle.bin", rle.data(), rle.size());
+  host_sd_put("bg_q565.bin", q565.data(), q565.size());
+}
+
+static void test_reads(void) {
+  put_files();
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  SdFat sd;
+  LvGLConfig config = {};
+  config.sd_stream_rows = 8;
+  Traffic icons[2], raw[2], rle[2], q565[2];
+  for (int cached = 0; cached < 2; cached++) {
+    config.sd_cache_bytes = cached ? 8192 : 0;
+    Adafruit_LvGL_Glue_SD glue;
+    CHECK(glue.begin(&tft, &sd, config) == LVGL_OK);
+    printf("sd_cache_bytes %u\n", (unsigned)config.sd_cache_bytes);
+    icons[cached] = run_icons(glue);
+    report("  icons", icons[cached]);
+    LvGLSDStats icon_stats = glue.sd_stats;
+    printf("  %u LvGL reads: %u read-ahead hits, %u misses, %u file cache "
+           "hits\n",
+           (unsigned)icon_stats.reads, (unsigned)icon_stats.hits,
+           (unsigned)icon_stats.sd_reads, (unsigned)icon_stats.cache_hits);
+    raw[cached] = run_background("S:bg.bin");
+    report("  raw background", raw[cached]);
+    rle[cached] = run_background("S:bg_rle.bin");
+    report("  RLE background", rle[cached]);
+    q565[cached] = run_background("S:bg_q565.bin");
+    report("  Q565 background", q565[cached]);
+    glue.clearFileCache();
+
+    // The read-ahead cache reads whole sectors, far fewer times than LvGL
+    // asks
+    CHECK(icons[cached].small_reads == 0);
+    if (!cached) {
+      // Each icon: the header, four chunks and the read that finds the
+      // end, from two sectors
+      CHECK(icon_stats.reads == FRAMES * ICONS * 6);
+      CHECK(icon_stats.sd_reads == FRAMES * ICONS * 2);
+      CHECK(icon_stats.hits == FRAMES * ICONS * 4);
+      CHECK(icons[cached].reads == icon_stats.sd_reads);
+    }
+    // Streamed bands are read in sectors or more, RLE and Q565 through
+    // the read-ahead cache, and compressed images need fewer bytes: Q565
+    // fewest, its small steps taking a byte a pixel where RLE has literals
+    CHECK(raw[cached].small_reads == 0);
+    CHECK(rle[cached].small_reads == 0);
+    CHECK(q565[cached].small_reads == 0);
+    CHECK(raw[cached].bytes >= FRAMES * BG_W * BG_H * 2);
+    CHECK(rle[cached].bytes < raw[cached].bytes);
+    CHECK(q565[cached].bytes < rle[cached].bytes);
+    CHECK(raw[cached].reads <= FRAMES * (BG_H / 8 + 2));
+  }
+
+  // With the file cache, only the first frame reads the icons from the
+  // card; the backgrounds are too big for it and read the same
+  CHECK(icons[1].opens * FRAMES == icons[0].opens);
+  CHECK(icons[1].reads * FRAMES <= icons[0].reads);
+  CHECK(icons[1].bytes * FRAMES == icons[0].bytes);
+  CHECK(raw[1].reads == raw[0].reads);
+  CHECK(rle[1].reads == rle[0].reads);
+  CHECK(q565[1].reads == q565[0].reads);
+  CHECK(host_sd.opens == host_sd.closes);
+}
+
+int main(void) {
+  test_reads();
+  return host_result("test_sd_reads");
+}
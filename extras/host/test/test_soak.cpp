@@ -0,0 +1,67 @@
+// SD handle pool soak: a million opens, reads and closes through S:, with
+// and without idle handles kept open, must leave the heap where it was
+#include "host.h"
+#include <Adafruit_LvGL_Glue_SD.h>
+
+#define TFT_W 64
+#define TFT_H 48
+#define SOAK_CYCLES 1000000
+
+// Opens, reads from and closes the files in turn, SOAK_CYCLES times; false
+// as soon as anything fails
+static bool soak(const char *const *paths, size_t count) {
+  for (uint32_t i = 0; i < SOAK_CYCLES; i++) {
+    lv_fs_file_t file;
+    uint8_t buf[16];
+    uint32_t br;
+    if ((lv_fs_open(&file, paths[i % count], LV_FS_MODE_RD) !=
+         LV_FS_RES_OK) ||
+        (lv_fs_read(&file, buf, sizeof buf, &br) != LV_FS_RES_OK) ||
+        (br != sizeof buf) || (lv_fs_close(&file) != LV_FS_RES_OK)) {
+      fprintf(stderr, "cycle %u failed\n", (unsigned)i);
+      return false;
+    }
+  }
+  return true;
+}
+
+static void test_soak(bool keep_open) {
+  static const char *const paths[] = {"S:a.bin", "S:d/b.bin", "S:c.bin"};
+  uint8_t data[600] = {};
+  host_sd_reset();
+  host_sd_put("a.bin", data, sizeof data);
+  host_sd_put("d/b.bin", data, sizeof data);
+  host_sd_put("c.bin", data, sizeof data);
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  SdFat sd;
+  Adafruit_LvGL_Glue_SD glue;
+  LvGLConfig config = {};
+  config.sd_handles = 2; // Fewer than the files, so idle ones are given up
+  config.sd_keep_open = keep_open;
+  CHECK(glue.begin(&tft, &sd, config) == LVGL_OK);
+  CHECK(soak(paths, 3)); // Warm up anything set up on first use
+  size_t heap = host_heap_used();
+  CHECK(soak(paths, 3));
+  CHECK(host_heap_used() == heap);
+
+  // With every handle held, opens fail without touching the heap either
+  lv_fs_file_t a, b, c;
+  CHECK(lv_fs_open(&a, paths[0], LV_FS_MODE_RD) == LV_FS_RES_OK);
+  CHECK(lv_fs_open(&b, paths[1], LV_FS_MODE_RD) == LV_FS_RES_OK);
+  uint32_t fails = glue.sd_stats.handle_fails;
+  for (int i = 0; i < 1000; i++) {
+    CHECK(lv_fs_open(&c, paths[2], LV_FS_MODE_RD) != LV_FS_RES_OK);
+  }
+  CHECK(glue.sd_stats.handle_fails == fails + 1000);
+  CHECK(host_heap_used() == heap);
+  CHECK(lv_fs_close(&a) == LV_FS_RES_OK);
+  CHECK(lv_fs_close(&b) == LV_FS_RES_OK);
+  glue.clearFileCache();
+  CHECK(host_sd.opens == host_sd.closes);
+}
+
+int main(void) {
+  test_soak(false);
+  test_soak(true);
+  return host_result("test_soak");
+}
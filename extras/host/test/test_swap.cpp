@@ -0,0 +1,104 @@
+// swapPixels(): every length and alignment of source and destination, in
+// place and not, must match a pixel-at-a-time swap; then a rough timing
+// against that loop
+#include "host.h"
+#include <Adafruit_LvGL_Glue.h>
+#include <chrono>
+
+#define SWAP_MAX 40         // Longest run checked, past the 8 pixel passes
+#define BENCH_PIXELS 76800  // A 320x240 frame
+#define BENCH_ROUNDS 200
+
+// The reference: one pixel at a time
+static void swap_scalar(uint16_t *dest, const uint16_t *src, uint32_t len) {
+  for (uint32_t i = 0; i < len; i++) {
+    dest[i] = (uint16_t)((src[i] << 8) | (src[i] >> 8));
+  }
+}
+
+// Pixels that differ per position, with distinct high and low bytes
+static uint16_t pattern(uint32_t i) { return (uint16_t)(0x1234 + i * 0x0301); }
+
+// Offsets are in pixels from an 8-byte boundary, so 1 and 3 are off a word
+// boundary by 2 bytes, and 2 is word aligned but off the 64-bit boundary
+static void test_table(void) {
+  alignas(8) uint16_t src[SWAP_MAX + 8], dest[SWAP_MAX + 8],
+      expect[SWAP_MAX + 8];
+  for (uint32_t len = 0; len <= SWAP_MAX; len++) {
+    for (uint32_t so = 0; so < 4; so++) {
+      for (uint32_t d_o = 0; d_o < 4; d_o++) {
+        // Out of place; nothing around dest may change
+        for (uint32_t i = 0; i < SWAP_MAX + 8; i++) {
+          src[i] = pattern(i);
+          dest[i] = expect[i] = 0xA55A;
+        }
+        swap_scalar(expect + d_o, src + so, len);
+        Adafruit_LvGL_Glue::swapPixels(dest + d_o, src + so, len);
+        if (memcmp(dest, expect, sizeof dest)) {
+          fprintf(stderr, "len %u, src +%u, dest +%u\n", (unsigned)len,
+                  (unsigned)so, (unsigned)d_o);
+          CHECK(false);
+        }
+        for (uint32_t i = 0; i < SWAP_MAX + 8; i++) {
+          CHECK(src[i] == pattern(i)); // Source left alone
+        }
+      }
+      // In place
+      for (uint32_t i = 0; i < SWAP_MAX + 8; i++) {
+        dest[i] = expect[i] = pattern(i);
+      }
+      swap_scalar(expect + so, expect + so, len);
+      Adafruit_LvGL_Glue::swapPixels(dest + so, dest + so, len);
+      if (memcmp(dest, expect, sizeof dest)) {
+        fprintf(stderr, "len %u in place at +%u\n", (unsigned)len,
+                (unsigned)so);
+        CHECK(false);
+      }
+    }
+  }
+}
+
+// Swapping twice gives back the original, at a size that goes through the
+// widest passes
+static void test_round_trip(void) {
+  std::vector<uint16_t> buf(1001), orig(1001);
+  for (uint32_t i = 0; i < buf.size(); i++) {
+    buf[i] = orig[i] = pattern(i * 7);
+  }
+  Adafruit_LvGL_Glue::swapPixels(buf.data() + 1, buf.data() + 1, 1000);
+  CHECK(buf[0] == orig[0]);
+  CHECK(buf[1] == (uint16_t)((orig[1] << 8) | (orig[1] >> 8)));
+  Adafruit_LvGL_Glue::swapPixels(buf.data() + 1, buf.data() + 1, 1000);
+  CHECK(buf == orig);
+}
+
+// Times a frame's worth of swaps in place; ns per pixel
+template <typename F> static double time_swap(F swap, uint16_t *buf) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    swap(buf, buf, BENCH_PIXELS);
+  }
+  std::chrono::duration<double, std::nano> ns =
+      std::chrono::steady_clock::now() - start;
+  return ns.count() / ((double)BENCH_ROUNDS * BENCH_PIXELS);
+}
+
+// Only reports: host timings say little about the boards, where
+// examples/bench_flush does the same against real displays
+static void bench(void) {
+  std::vector<uint16_t> buf(BENCH_PIXELS);
+  for (uint32_t i = 0; i < buf.size(); i++) {
+    buf[i] = pattern(i);
+  }
+  double glue = time_swap(Adafruit_LvGL_Glue::swapPixels, buf.data());
+  double scalar = time_swap(swap_scalar, buf.data());
+  printf("swapPixels %.3f ns/pixel, scalar loop %.3f ns/pixel\n", glue,
+         scalar);
+}
+
+int main(void) {
+  test_table();
+  test_round_trip();
+  bench();
+  return host_result("test_swap");
+}
@@ -0,0 +1,273 @@
+// The ESP32 GUI task, built as for ESP32 against the FreeRTOS stand-in.
+// This takes in Adafruit_LvGL_Glue.cpp itself, to step the GUI and touch
+// tasks one run at a time on a virtual clock: an idle UI must sleep
+// LV_IDLE_MAX_MS at a time, a UI with a running timer wake once per
+// period, and touch, lvgl_release() and changes made without the lock
+// wake it early, once each. Its counters and settings are checked too.
+#include "host.h"
+#include <Adafruit_LvGL_Glue.cpp>
+#include <TouchScreen.h>
+
+#define TFT_W 64
+#define TFT_H 48
+#define TOUCH_POLL_MS 10
+
+// What the other tasks do in a millisecond, see run_gui()
+typedef void (*Tick)(uint32_t ms);
+
+static TickType_t gui_sleep; // Ticks left of the GUI task's sleep
+static uint32_t gui_runs;    // Runs so far
+
+// Runs the GUI task on for ms of virtual time, as FreeRTOS would: a run,
+// then asleep for the ticks it asked for, or until notified (at once, if
+// a notification is already waiting). Each tick, tick() (if any) has the
+// other tasks do their part, given the time so far. Returns the GUI
+// task's runs in that time, counting one at the start but not the end.
+static uint32_t run_gui(uint32_t ms, Tick tick = NULL) {
+  TaskHandle_t sketch = host_task_current, gui = g_lvgl_task_handle;
+  uint32_t runs = 0, elapsed = 0;
+  while (elapsed < ms) {
+    if (gui->notified || !gui_sleep) {
+      gui->notified = 0; // ulTaskNotifyTake(pdTRUE, ...)
+      host_task_current = gui;
+      gui_sleep = lv_gui_run();
+      host_task_current = sketch;
+      runs++;
+      gui_runs++;
+      continue;
+    }
+    host_advance(portTICK_PERIOD_MS);
+    elapsed += portTICK_PERIOD_MS;
+    gui_sleep--;
+    if (tick) {
+      tick(elapsed);
+    }
+  }
+  return runs;
+}
+
+// Time passes with the GUI task kept off the CPU, e.g. by a higher
+// priority task; it runs when it's next scheduled
+static void hog(uint32_t ms) {
+  host_advance(ms);
+  gui_sleep -= min(gui_sleep, (TickType_t)pdMS_TO_TICKS(ms));
+}
+
+// The plain rules, before any task exists and after
+static void test_rules(void) {
+  CHECK(!lv_wake_needed(host_task_current)); // No GUI task yet
+  CHECK(lv_gui_sleep_ticks(0, false) == 1);  // Due now: still a tick
+  CHECK(lv_gui_sleep_ticks(40, false) == pdMS_TO_TICKS(40));
+  CHECK(lv_gui_sleep_ticks(LV_IDLE_MAX_MS + 1, false) ==
+        pdMS_TO_TICKS(LV_IDLE_MAX_MS));
+  CHECK(lv_gui_sleep_ticks(LV_NO_TIMER_READY, false) ==
+        pdMS_TO_TICKS(LV_IDLE_MAX_MS));
+  CHECK(lv_gui_sleep_ticks(40, true) == 1); // Commands waiting
+}
+
+// lv_task_account(): totals and longest of the lock wait and the handler,
+// across micros() wrapping, and a run only missed when more than
+// LV_GUI_SLACK_MS late
+static void test_account(void) {
+  LvGLTaskStats stats = {};
+  lv_task_account(&stats, 100, 150, 1150, 0);
+  lv_task_account(&stats, 0xFFFFFF00, 0x100, 0x200, -20); // Woken early
+  CHECK(stats.runs == 2);
+  CHECK(stats.lock_wait_us == 50 + 0x200);
+  CHECK(stats.lock_wait_max_us == 0x200);
+  CHECK(stats.handler_us == 1000 + 0x100);
+  CHECK(stats.handler_max_us == 1000);
+  CHECK(stats.missed == 0);
+  lv_task_account(&stats, 0, 0, 10, LV_GUI_SLACK_MS); // Within the slack
+  CHECK(stats.missed == 0);
+  lv_task_account(&stats, 0, 0, 10, LV_GUI_SLACK_MS + 1);
+  CHECK(stats.missed == 1);
+  CHECK((stats.runs == 4) && (stats.handler_max_us == 1000));
+  CHECK(stats.stack_free == 0); // Left to getTaskStats()
+}
+
+// Settings the chip can't have are refused before any task starts: a
+// core it lacks, a priority past configMAX_PRIORITIES. Must run before
+// the first good begin(), since the GUI task then stays up.
+static void test_config(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  TouchScreen touch;
+  LvGLConfig config = {};
+  host_cores = 1; // An S2 or C3
+  config.gui_core = LVGL_CORE_1;
+  {
+    Adafruit_LvGL_Glue glue;
+    CHECK(glue.begin(&tft, &touch, config) == LVGL_ERR_CONFIG);
+    LvGLTaskStats counters;
+    glue.getTaskStats(&counters);
+    CHECK((counters.runs == 0) && (counters.stack_free == 0)); // No task
+  }
+  host_cores = 2;
+  config.gui_core = LVGL_CORE_AUTO;
+  config.gui_priority = configMAX_PRIORITIES;
+  {
+    Adafruit_LvGL_Glue glue;
+    CHECK(glue.begin(&tft, &touch, config) == LVGL_ERR_CONFIG);
+  }
+  CHECK(!host_task_find("lvgl_gui"));
+  CHECK(!g_lvgl_task_handle && !xGuiSemaphore && !lv_task_running);
+}
+
+static uint32_t timer_runs;
+static lv_obj_t *timer_obj;
+static void timer_cb(lv_timer_t *timer) {
+  timer_runs++;
+  if (timer_obj) {
+    lv_obj_invalidate(timer_obj); // From the GUI task: wakes nothing
+  }
+}
+
+static Adafruit_LvGL_Glue *touch_glue;
+static HostTask *touch_task_handle;
+static TouchScreen *touch_screen;
+static uint32_t touch_until; // Touched up to this ms of the run
+
+// The touch task, polling every TOUCH_POLL_MS
+static void touch_tick(uint32_t ms) {
+  if (ms % TOUCH_POLL_MS) {
+    return;
+  }
+  touch_screen->point =
+      TSPoint(ADC_XMIN + ms, ADC_YMIN, ms <= touch_until ? 300 : 0);
+  TaskHandle_t sketch = host_task_current;
+  host_task_current = touch_task_handle;
+  touch_task_poll(touch_glue);
+  host_task_current = sketch;
+}
+
+static void test_wakeups(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  TouchScreen touch;
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  config.touch_poll_ms = TOUCH_POLL_MS;
+  config.touch_release_count = 1;
+  CHECK(glue.begin(&tft, &touch, config) == LVGL_OK);
+  HostTask *gui = g_lvgl_task_handle;
+  CHECK(gui && (gui == host_task_find("lvgl_gui")));
+  HostTask *touch_task = host_task_find("lvgl_touch");
+  CHECK(touch_task && (touch_task->arg == &glue));
+  // Zero settings: the defaults, the GUI task on core 1 (WiFi has 0)
+  CHECK((gui->priority == 5) && (gui->stack == 8192) && (gui->core == 1));
+  CHECK((touch_task->priority == 5) && (touch_task->stack == 4096) &&
+        (touch_task->core == tskNO_AFFINITY));
+  CHECK(!lv_wake_needed(gui));
+  CHECK(lv_wake_needed(host_task_current));
+  touch_glue = &glue;
+  touch_task_handle = touch_task;
+  touch_screen = &touch;
+  lv_display_t *disp = glue.getLvDisplay();
+  HostDisplayStats *stats = host_display_stats(disp);
+  run_gui(LV_IDLE_MAX_MS); // The first frame, and settle
+
+  // Idle, the touch task polling an untouched screen: one run a second
+  uint32_t refreshes = stats->refreshes;
+  touch_until = 0;
+  CHECK(run_gui(10000, touch_tick) == 10);
+  CHECK(stats->refreshes == refreshes);
+  CHECK(gui->notifies == 0);
+  printf("idle: 10 runs in 10 s\n");
+
+  // A timer every 100 ms, made under the lock, which wakes the GUI task
+  // to see it: then one run per period, and a timer that invalidates
+  // redraws in that same run
+  glue.lvgl_acquire();
+  lv_timer_t *timer = lv_timer_create(timer_cb, 100, NULL);
+  glue.lvgl_release();
+  CHECK(gui->notifies == 1);
+  CHECK(run_gui(1) == 1);
+  timer_runs = 0;
+  uint32_t runs = run_gui(1000);
+  CHECK((timer_runs == 10) && (runs == 10));
+  timer_obj = lv_label_create(NULL);
+  timer_runs = 0;
+  refreshes = stats->refreshes;
+  runs = run_gui(1000);
+  CHECK((timer_runs == 10) && (runs == 10));
+  CHECK(stats->refreshes == refreshes + 10);
+  CHECK(gui->notifies == 1);
+  printf("timer: %u runs in 1 s\n", (unsigned)runs);
+  LvGLTaskStats counters;
+  glue.getTaskStats(&counters);
+  CHECK(counters.missed == 0);
+  hog(150); // Kept off past the next timer's deadline: a missed run
+  CHECK(run_gui(1) == 1);
+  glue.getTaskStats(&counters);
+  CHECK(counters.missed == 1);
+  glue.lvgl_acquire();
+  lv_timer_delete(timer);
+  lv_obj_delete(timer_obj);
+  timer_obj = NULL;
+  glue.lvgl_release();
+  CHECK(run_gui(1) == 1); // Back to idle
+
+  // A touch held for 200 ms, sampled every 10 ms: a run per sample queued
+  // (the last one the release), each reading that sample
+  lv_indev_t *indev = lv_indev_get_next(NULL); // The only one
+  size_t logged = host_indev_log(indev).size();
+  uint32_t notifies = gui->notifies;
+  touch_until = 200;
+  runs = run_gui(500, touch_tick);
+  uint32_t samples = 200 / TOUCH_POLL_MS + 1;
+  CHECK(gui->notifies - notifies == samples);
+  CHECK(runs == samples);
+  CHECK(host_indev_log(indev).size() == logged + samples);
+  CHECK(host_indev_log(indev).back().state == LV_INDEV_STATE_REL);
+  printf("touch: %u samples, %u runs\n", (unsigned)samples, (unsigned)runs);
+
+  // lvgl_release() from the sketch wakes the GUI task once; so does a
+  // change made without the lock, which is redrawn in that run
+  notifies = gui->notifies;
+  glue.lvgl_acquire();
+  glue.lvgl_release();
+  CHECK(gui->notifies == notifies + 1);
+  CHECK(run_gui(100) == 1);
+  refreshes = stats->refreshes;
+  host_invalidate(disp, 0, 0, 9, 9);
+  CHECK(gui->notifies == notifies + 2);
+  CHECK(run_gui(100) == 1);
+  CHECK(stats->refreshes == refreshes + 1);
+
+  // Posted commands wake it too
+#if LVGL_COMMAND_QUEUE
+  lv_obj_t *label = lv_label_create(NULL);
+  CHECK(glue.postText(label, "posted"));
+  CHECK(gui->notifies == notifies + 3);
+  CHECK(run_gui(100) == 1);
+  CHECK(!strcmp(lv_label_get_text(label), "posted"));
+  lv_obj_delete(label);
+#endif
+
+  // The counters saw every run; the stack low point is FreeRTOS's
+  glue.getTaskStats(&counters, true);
+  CHECK(counters.runs == gui_runs);
+  CHECK(counters.missed == 1);
+  CHECK(counters.stack_free == gui->stack_free);
+  glue.getTaskStats(&counters);
+  CHECK((counters.runs == 0) && (counters.missed == 0)); // Reset
+  CHECK(counters.stack_free == gui->stack_free);
+
+  // A touch task priority past the limit, once the GUI task is up
+  Adafruit_SPITFT tft2(TFT_W, TFT_H);
+  TouchScreen touch2;
+  Adafruit_LvGL_Glue glue2;
+  config.touch_priority = configMAX_PRIORITIES;
+  CHECK(glue2.begin(&tft2, &touch2, config) == LVGL_ERR_CONFIG);
+  CHECK(host_task_find("lvgl_touch") == touch_task);
+
+  CHECK(host_task_violations == 0);
+  CHECK(tft.violations == 0);
+}
+
+int main(void) {
+  test_rules();
+  test_account();
+  test_config();
+  test_wakeups();
+  return host_result("test_tasks");
+}
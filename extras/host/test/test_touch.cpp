@@ -0,0 +1,524 @@
+// Touch: raw readings must reach LvGL mapped, filtered and (with
+// touch_poll_ms) queued, without the STMPE610 getting on the bus while a
+// transfer to the display is in flight
+#include "host.h"
+#include "swipe_trace.h"
+#include <Adafruit_LvGL_Glue.h>
+#include <atomic>
+#include <math.h>
+#include <thread>
+
+#define TFT_W 64
+#define TFT_H 48
+
+// Built-in calibration ranges, as in Adafruit_LvGL_Glue.cpp
+#define TS_MINX 100
+#define TS_MAXX 3800
+#define TS_MINY 100
+#define TS_MAXY 3750
+#define ADC_XMIN 325
+#define ADC_XMAX 750
+#define ADC_YMIN 240
+#define ADC_YMAX 840
+#define RACE_SAMPLES 20000 // Touched polls in test_ring_threads()
+#define SWIPE_MAX_LAG 8    // Samples searched for the filter's lag
+
+// The glue's input device
+static lv_indev_t *touch_indev(Adafruit_LvGL_Glue &glue) {
+  for (lv_indev_t *indev = lv_indev_get_next(NULL); indev;
+       indev = lv_indev_get_next(indev)) {
+    if (lv_indev_get_user_data(indev) == &glue) {
+      return indev;
+    }
+  }
+  return NULL;
+}
+
+// Has LvGL read the touchscreen; returns its latest reading
+static lv_indev_data_t touch_read(Adafruit_LvGL_Glue &glue) {
+  lv_indev_t *indev = touch_indev(glue);
+  lv_indev_read(indev);
+  return host_indev_log(indev).back();
+}
+
+static bool is_at(const lv_indev_data_t &data, int32_t x, int32_t y) {
+  if ((data.state != LV_INDEV_STATE_PR) || (data.point.x != x) ||
+      (data.point.y != y)) {
+    fprintf(stderr, "touch %s at %d,%d, expected pressed at %d,%d\n",
+            data.state == LV_INDEV_STATE_PR ? "pressed" : "released",
+            (int)data.point.x, (int)data.point.y, (int)x, (int)y);
+    return false;
+  }
+  return true;
+}
+
+// STMPE610 with its built-in calibration: corners of the raw range land on
+// the panel's corners (X flipped on this size of panel), every point
+// waiting in the FIFO is read in one go, and an empty FIFO releases
+static void test_stmpe(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  Adafruit_STMPE610 touch;
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  CHECK(glue.begin(&tft, &touch, config) == LVGL_OK);
+  lv_indev_t *indev = touch_indev(glue);
+  CHECK(indev);
+  touch.fifo.push_back(TS_Point(TS_MAXX, TS_MINY, 50));
+  touch.fifo.push_back(TS_Point(TS_MINX, TS_MAXY, 50));
+  size_t logged = host_indev_log(indev).size();
+  CHECK(is_at(touch_read(glue), TFT_W - 1, TFT_H - 1));
+  CHECK(host_indev_log(indev).size() == logged + 2);
+  CHECK(is_at(host_indev_log(indev)[logged], 0, 0));
+  CHECK(touch.fifo.empty());
+  lv_indev_data_t data = touch_read(glue);
+  CHECK(data.state == LV_INDEV_STATE_REL);
+  CHECK((data.point.x == TFT_W - 1) && (data.point.y == TFT_H - 1));
+  CHECK(tft.violations == 0);
+}
+
+// A poll while DMA is sending a flush is put off, and done by finishFlush()
+// once the transfer ends -- never on the bus mid-transfer
+static void test_stmpe_deferred(void) {
+#if defined(USE_SPI_DMA)
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  Adafruit_STMPE610 touch;
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  CHECK(glue.begin(&tft, &touch, config) == LVGL_OK);
+  lv_display_t *disp = glue.getLvDisplay();
+  host_invalidate(disp, 0, 0, TFT_W - 1, TFT_H - 1);
+  lv_refr_now(disp);
+  CHECK(tft.dmaBusy()); // The last flush is still going
+  touch.fifo.push_back(TS_Point(TS_MAXX, TS_MINY, 50));
+  lv_indev_data_t data = touch_read(glue);
+  CHECK(touch.reads == 0);
+  CHECK(glue.bus_stats.deferred == 1);
+  CHECK(data.state == LV_INDEV_STATE_REL);
+  glue.waitForFlush(); // Reads the touchscreen as the bus comes free
+  CHECK(touch.reads == 1);
+  CHECK(is_at(touch_read(glue), 0, 0));
+  CHECK(touch.reads == 1); // That read was the one finishFlush() did
+  CHECK(tft.violations == 0);
+#endif
+}
+
+// ADC touchscreen: pressure below the threshold doesn't count, and it
+// takes a few untouched readings in a row to release
+static void test_adc(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  TouchScreen touch;
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  CHECK(glue.begin(&tft, &touch, config) == LVGL_OK);
+  touch.point = TSPoint(ADC_XMIN, ADC_YMAX, 5);
+  CHECK(touch_read(glue).state == LV_INDEV_STATE_REL);
+  touch.point = TSPoint(ADC_XMIN, ADC_YMAX, 300);
+  CHECK(is_at(touch_read(glue), 0, 0));
+  touch.point = TSPoint(ADC_XMAX, ADC_YMIN, 300);
+  CHECK(is_at(touch_read(glue), TFT_W - 1, TFT_H - 1));
+  touch.point = TSPoint(0, 0, 0);
+  for (int i = 0; i < 3; i++) {
+    CHECK(touch_read(glue).state == LV_INDEV_STATE_PR);
+  }
+  CHECK(touch_read(glue).state == LV_INDEV_STATE_REL);
+}
+
+// The same raw point, with the glue rotated: LvGL's coordinates are the
+// panel point turned the same way as the pixels
+static void test_rotation(void) {
+  for (uint8_t rotation = 0; rotation < 4; rotation++) {
+    Adafruit_SPITFT tft(TFT_W, TFT_H);
+    TouchScreen touch;
+    Adafruit_LvGL_Glue glue;
+    LvGLConfig config = {};
+    config.rotation = rotation;
+    CHECK(glue.begin(&tft, &touch, config) == LVGL_OK);
+    touch.point = TSPoint(ADC_XMIN, ADC_YMAX, 300); // Panel pixel 0,0
+    int32_t x = 0, y = 0;
+    switch (rotation) {
+    case 1:
+      x = 0, y = TFT_W - 1;
+      break;
+    case 2:
+      x = TFT_W - 1, y = TFT_H - 1;
+      break;
+    case 3:
+      x = TFT_H - 1, y = 0;
+      break;
+    }
+    CHECK(is_at(touch_read(glue), x, y));
+    tft.setRotation(1); // GFX turned later: the map follows
+    touch.point = TSPoint(ADC_XMAX, ADC_YMAX, 300); // Panel pixel 63,0
+    lv_indev_data_t data = touch_read(glue);
+    if (!rotation) {
+      CHECK(is_at(data, 0, 0)); // GFX rotation 1 puts panel 63,0 at 0,0
+    }
+  }
+}
+
+// Profiles: one for another panel size is refused, a valid one is used
+static void test_set_calibration(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  TouchScreen touch;
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  CHECK(glue.begin(&tft, &touch, config) == LVGL_OK);
+  LvGLTouchCalibration cal = glue.getTouchCalibration();
+  CHECK(cal.magic == LVGL_TOUCH_CAL_MAGIC);
+  cal.width = TFT_W + 1;
+  CHECK(!glue.setTouchCalibration(cal));
+  cal.width = TFT_W;
+  // Raw readings straight through, as pixels: x = raw x / 10, y = raw y / 10
+  int32_t straight[6] = {65536 / 10, 0, 0, 0, 65536 / 10, 0};
+  memcpy(cal.matrix, straight, sizeof straight);
+  CHECK(glue.setTouchCalibration(cal));
+  touch.point = TSPoint(300, 200, 300);
+  CHECK(is_at(touch_read(glue), 30, 20));
+  LvGLConfig bad = {};
+  cal.height = 1;
+  bad.touch_calibration = &cal;
+  Adafruit_LvGL_Glue glue2;
+  CHECK(glue2.begin(&tft, &touch, bad) == LVGL_ERR_CONFIG);
+}
+
+// calibrateTouch(): touches fed in as each crosshair goes up. The raw
+// readings are an affine map of the targets, which the solved profile
+// must then undo.
+static Adafruit_STMPE610 *cal_touch;
+static int32_t cal_targets[3][2];
+static int cal_step; // Delays so far
+static void cal_feed(void) {
+  int target = cal_step / 40, phase = cal_step % 40;
+  cal_step++;
+  if ((target < 3) && (phase < 20)) {
+    int32_t x = cal_targets[target][0], y = cal_targets[target][1];
+    cal_touch->fifo.push_back(TS_Point(3000 - x * 40, 200 + y * 60, 50));
+  }
+}
+
+static void test_calibrate(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  Adafruit_STMPE610 touch;
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  CHECK(glue.begin(&tft, &touch, config) == LVGL_OK);
+  int32_t w = TFT_W, h = TFT_H;
+  int32_t targets[3][2] = {
+      {w / 8, h / 8}, {w - 1 - w / 8, h / 2}, {w / 2, h - 1 - h / 8}};
+  memcpy(cal_targets, targets, sizeof targets);
+  cal_touch = &touch;
+  cal_step = 0;
+  host_on_delay = cal_feed;
+  CHECK(glue.calibrateTouch(1000));
+  host_on_delay = NULL;
+  touch.fifo.clear();
+  touch.fifo.push_back(TS_Point(3000 - 20 * 40, 200 + 30 * 60, 50));
+  CHECK(is_at(touch_read(glue), 20, 30));
+  CHECK(tft.violations == 0);
+
+  // No touch at all: times out, and the profile is kept
+  LvGLTouchCalibration before = glue.getTouchCalibration();
+  CHECK(!glue.calibrateTouch(100));
+  CHECK(!memcmp(&before, &glue.getTouchCalibration(), sizeof before));
+}
+
+// Filter: press_count readings make a press, the median drops a lone
+// outlier, and velocity follows the points over time
+static void test_filter(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  TouchScreen touch;
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  config.touch_press_count = 2;
+  config.touch_median = 3;
+  config.touch_release_count = 1;
+  CHECK(glue.begin(&tft, &touch, config) == LVGL_OK);
+  LvGLTouchCalibration cal = glue.getTouchCalibration();
+  int32_t straight[6] = {65536 / 10, 0, 0, 0, 65536 / 10, 0};
+  memcpy(cal.matrix, straight, sizeof straight);
+  CHECK(glue.setTouchCalibration(cal));
+
+  touch.point = TSPoint(100, 100, 300);
+  CHECK(touch_read(glue).state == LV_INDEV_STATE_REL); // One isn't a press
+  CHECK(is_at(touch_read(glue), 10, 10));
+  host_advance(10);
+  touch.point = TSPoint(600, 400, 300); // Outlier
+  CHECK(is_at(touch_read(glue), 10, 10));
+  host_advance(10);
+  touch.point = TSPoint(120, 100, 300);
+  CHECK(is_at(touch_read(glue), 12, 10)); // Median of 10, 60, 12
+  int32_t vx, vy;
+  glue.getTouchVelocity(&vx, &vy);
+  CHECK((vx > 0) && (vy == 0));
+  touch.point = TSPoint(0, 0, 0);
+  CHECK(touch_read(glue).state == LV_INDEV_STATE_REL);
+
+  // The next touch starts afresh, not from the last one's history
+  touch.point = TSPoint(500, 300, 300);
+  touch_read(glue);
+  CHECK(is_at(touch_read(glue), 50, 30));
+}
+
+// Glue on an ADC touchscreen, calibrated to take readings as pixels
+static void begin_straight(Adafruit_LvGL_Glue &glue, Adafruit_SPITFT &tft,
+                           TouchScreen &touch, const LvGLConfig &config) {
+  CHECK(glue.begin(&tft, &touch, config) == LVGL_OK);
+  LvGLTouchCalibration cal = glue.getTouchCalibration();
+  int32_t straight[6] = {65536, 0, 0, 0, 65536, 0};
+  memcpy(cal.matrix, straight, sizeof straight);
+  CHECK(glue.setTouchCalibration(cal));
+}
+
+// How well a filter setting follows the swipe: the lag, in samples, that
+// best lines its points up with the finger, and the RMS distance left
+typedef struct {
+  int lag;
+  double jitter;
+} SwipeFit;
+
+static SwipeFit replay_swipe(uint8_t median, uint8_t smooth) {
+  const int n = sizeof swipe_trace / sizeof swipe_trace[0];
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  TouchScreen touch;
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  config.touch_median = median;
+  config.touch_smooth = smooth;
+  begin_straight(glue, tft, touch, config);
+  std::vector<lv_indev_data_t> out;
+  for (int i = 0; i < n; i++) {
+    touch.point = TSPoint(swipe_trace[i].x, swipe_trace[i].y, 300);
+    host_advance(SWIPE_MS);
+    out.push_back(touch_read(glue));
+    CHECK(out.back().state == LV_INDEV_STATE_PR);
+  }
+  SwipeFit fit = {0, HUGE_VAL};
+  for (int lag = 0; lag <= SWIPE_MAX_LAG; lag++) {
+    double sum = 0;
+    for (int i = SWIPE_MAX_LAG; i < n; i++) {
+      double dx = out[i].point.x - swipe_trace[i - lag].true_x;
+      double dy = out[i].point.y - swipe_trace[i - lag].true_y;
+      sum += dx * dx + dy * dy;
+    }
+    double rms = sqrt(sum / (n - SWIPE_MAX_LAG));
+    if (rms < fit.jitter) {
+      fit.lag = lag;
+      fit.jitter = rms;
+    }
+  }
+  printf("median %u, smooth %3u: lag %d samples, jitter %.2f pixels\n",
+         (unsigned)median, (unsigned)smooth, fit.lag, fit.jitter);
+  return fit;
+}
+
+// The recorded swipe through LvGL's read, at each median window with
+// smoothing off and on: the median takes out the wild readings at a
+// sample or two of lag, smoothing takes out more of the noise at more lag
+static void test_swipe(void) {
+  SwipeFit raw = replay_swipe(1, 0), m3 = replay_swipe(3, 0),
+           m5 = replay_swipe(5, 0), ema = replay_swipe(1, 128),
+           m3_ema = replay_swipe(3, 128), m5_ema = replay_swipe(5, 128);
+  CHECK(raw.lag == 0);
+  CHECK(raw.jitter > 4.0); // The wild readings dominate
+  // A window of n is (n - 1) / 2 samples behind
+  CHECK((m3.lag == 1) && (m3.jitter < raw.jitter / 2) && (m3.jitter < 2.5));
+  CHECK((m5.lag == 2) && (m5.jitter < raw.jitter / 2) && (m5.jitter < 2.5));
+  CHECK((ema.lag >= 1) && (ema.lag <= 2) && (ema.jitter < raw.jitter));
+  CHECK((m3_ema.lag <= 3) && (m3_ema.jitter < m3.jitter));
+  CHECK((m5_ema.lag <= 4) && (m5_ema.jitter < m5.jitter));
+  CHECK(m3_ema.jitter < 2.0);
+}
+
+// Smoothing's fixed point: each reading moves the point (256 - smooth)/256
+// of the way to itself, rounded to the nearest pixel
+static void test_smooth(void) {
+  const uint8_t smooths[] = {0, 64, 128, 192, 255};
+  for (uint8_t smooth : smooths) {
+    Adafruit_SPITFT tft(TFT_W, TFT_H);
+    TouchScreen touch;
+    Adafruit_LvGL_Glue glue;
+    LvGLConfig config = {};
+    config.touch_smooth = smooth;
+    begin_straight(glue, tft, touch, config);
+    touch.point = TSPoint(0, 0, 300);
+    CHECK(is_at(touch_read(glue), 0, 0)); // A new touch starts where it is
+    touch.point = TSPoint(256, 0, 300);
+    double expect = 0;
+    for (int i = 0; i < 8; i++) {
+      expect += (256 - expect) * (256 - smooth) / 256;
+      CHECK(is_at(touch_read(glue), (int32_t)floor(expect + 0.5), 0));
+    }
+  }
+}
+
+// Settings past their ranges are brought in: a median window over
+// LVGL_TOUCH_MEDIAN_MAX is that long, 0 is off, and 0 readings to press
+// is one
+static void test_filter_limits(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  TouchScreen touch;
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  config.touch_median = 200;
+  begin_straight(glue, tft, touch, config);
+  CHECK(glue.touch_filter.median == LVGL_TOUCH_MEDIAN_MAX);
+  CHECK(glue.touch_filter.press_count == 1);
+  // A window of 5: two wild readings in a row are outvoted by three good
+  const int32_t xs[] = {10, 10, 10, 90, 90};
+  for (int32_t x : xs) {
+    touch.point = TSPoint(x, 10, 300);
+    CHECK(is_at(touch_read(glue), 10, 10));
+  }
+
+  Adafruit_LvGL_Glue glue2;
+  config.touch_median = 0;
+  config.touch_press_count = 0;
+  begin_straight(glue2, tft, touch, config);
+  CHECK(glue2.touch_filter.median == 1);
+  CHECK(glue2.touch_filter.press_count == 1);
+  touch.point = TSPoint(10, 10, 300);
+  CHECK(is_at(touch_read(glue2), 10, 10)); // First reading presses
+  touch.point = TSPoint(90, 10, 300);
+  CHECK(is_at(touch_read(glue2), 90, 10)); // Unfiltered
+}
+
+// touch_poll_ms: pollTouch() samples on its own schedule into the ring,
+// which LvGL's read drains; a full ring drops samples, and the release
+// still gets through
+static void test_ring(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  TouchScreen touch;
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  config.touch_poll_ms = 5;
+  CHECK(glue.begin(&tft, &touch, config) == LVGL_OK);
+  lv_indev_t *indev = touch_indev(glue);
+  touch.point = TSPoint(ADC_XMIN, ADC_YMAX, 300);
+  glue.pollTouch();
+  uint32_t reads = touch.reads;
+  glue.pollTouch(); // Too soon
+  CHECK(touch.reads == reads);
+  for (int i = 1; i < LVGL_TOUCH_RING + 4; i++) {
+    host_advance(5);
+    glue.pollTouch();
+  }
+  CHECK(glue.touch_dropped == 4);
+  size_t logged = host_indev_log(indev).size();
+  CHECK(is_at(touch_read(glue), 0, 0));
+  CHECK(host_indev_log(indev).size() == logged + LVGL_TOUCH_RING);
+
+  touch.point = TSPoint(0, 0, 0);
+  for (int i = 0; i < 4; i++) { // ADC release count
+    host_advance(5);
+    glue.pollTouch();
+  }
+  CHECK(touch_read(glue).state == LV_INDEV_STATE_REL);
+  host_advance(5);
+  glue.pollTouch(); // Release is queued once only
+  logged = host_indev_log(indev).size();
+  touch_read(glue);
+  CHECK(host_indev_log(indev).size() == logged + 1);
+}
+
+// The ring across threads, as pollTouch() from another task than LvGL's:
+// a thread polls a touch that moves every sample, then lifts, while this
+// one drains through LvGL's read. Every touched sample must arrive once
+// and in order or be counted in touch_dropped, and the release arrive
+// once, last. Build with HOST_SANITIZE=thread to have ThreadSanitizer
+// check the ring's ordering as well.
+static void test_ring_threads(void) {
+  Adafruit_SPITFT tft(TFT_W, TFT_H);
+  TouchScreen touch;
+  Adafruit_LvGL_Glue glue;
+  LvGLConfig config = {};
+  config.touch_poll_ms = 1;
+  config.touch_release_count = 1; // Else the first untouched polls repeat
+  CHECK(glue.begin(&tft, &touch, config) == LVGL_OK);
+  LvGLTouchCalibration cal = glue.getTouchCalibration();
+  int32_t straight[6] = {65536, 0, 0, 0, 65536, 0}; // Raw reading as is
+  memcpy(cal.matrix, straight, sizeof straight);
+  CHECK(glue.setTouchCalibration(cal));
+  lv_indev_t *indev = touch_indev(glue);
+
+  // Sample i is raw i % 4096, i / 4096: 12 bits each, as touch_map() needs
+  std::atomic<bool> done(false);
+  uint32_t release_polls = 0;
+  std::thread poller([&] {
+    for (uint32_t i = 1; i <= RACE_SAMPLES; i++) {
+      touch.point = TSPoint(i % 4096, i / 4096, 300);
+      host_advance(1);
+      glue.pollTouch();
+      std::this_thread::yield(); // Give the reader a chance
+    }
+    touch.point = TSPoint(0, 0, 0);
+    do { // Until the release is in the ring
+      host_advance(1);
+      glue.pollTouch();
+      release_polls++;
+      std::this_thread::yield();
+    } while (glue.touch_queued_pressed);
+    done = true;
+  });
+
+  uint32_t received = 0, releases = 0, last = 0, pause_at = 1000;
+  bool ordered = true, release_last = true;
+  while (true) {
+    bool finished = done; // Before the read, so nothing queued is missed
+    const std::vector<lv_indev_data_t> &log = host_indev_log(indev);
+    size_t logged = log.size();
+    uint8_t tail = glue.touch_tail;
+    lv_indev_read(indev);
+    // Only the samples taken from the ring are new; a read of an empty
+    // ring repeats the latest one
+    uint8_t taken = glue.touch_tail - tail;
+    for (size_t i = logged; i < logged + taken; i++) {
+      if (log[i].state == LV_INDEV_STATE_REL) {
+        releases++;
+        continue;
+      }
+      release_last &= !releases;
+      uint32_t id = log[i].point.x + log[i].point.y * 4096;
+      ordered &= (id > last);
+      last = id;
+      received++;
+    }
+    if (finished && !taken) {
+      break;
+    }
+    if (received >= pause_at) { // Fall behind now and then: fill the ring
+      pause_at += 1000;
+      while (!done && ((uint8_t)(glue.touch_head - glue.touch_tail) <
+                       LVGL_TOUCH_RING)) {
+        std::this_thread::yield();
+      }
+      for (int i = 0; i < 100; i++) {
+        std::this_thread::yield();
+      }
+    }
+  }
+  poller.join();
+  printf("%u samples: %u received, %u dropped, %u release polls\n",
+         (unsigned)RACE_SAMPLES, (unsigned)received,
+         (unsigned)glue.touch_dropped, (unsigned)release_polls);
+  CHECK(ordered);
+  CHECK(releases == 1);
+  CHECK(release_last);
+  // A release that found the ring full is dropped and retried next poll
+  CHECK(received + glue.touch_dropped == RACE_SAMPLES + release_polls - 1);
+}
+
+int main(void) {
+  test_stmpe();
+  test_stmpe_deferred();
+  test_adc();
+  test_rotation();
+  test_set_calibration();
+  test_calibrate();
+  test_filter();
+  test_swipe();
+  test_smooth();
+  test_filter_limits();
+  test_ring();
+  test_ring_threads();
+  return host_result("test_touch");
+}
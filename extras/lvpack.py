@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""Pack a directory of LittlevGL assets (.bin images, fonts...) into one
+asset pack for Adafruit_LvGL_Assets (flash) or Adafruit_LvGL_Glue_SD (SD
+card). The format is described in Adafruit_LvGL_Glue_Assets.h.
+
+  lvpack.py images/ assets.lvpk               # Binary pack
+  lvpack.py --align 512 images/ assets.lvpk   # Sector-aligned, for SD
+  lvpack.py --c-array assets images/ assets.h # const array for flash
+
+Asset paths are relative to the directory, with '/' separators, e.g.
+"icons/cloudy.bin", and are opened in LittlevGL as "M:icons/cloudy.bin"
+(or whatever drive letter the pack is served on).
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = 0x4B50564C  # "LVPK"
+VERSION = 1
+HEADER = struct.Struct("<IHHII")
+ENTRY = struct.Struct("<IIII")
+
+
+def hash_path(path):
+    """FNV-1a, as Adafruit_LvGL_Assets::hashPath()"""
+    h = 2166136261
+    for b in path.encode("utf-8"):
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def build(root, align):
+    """Returns the pack for all files under root, as bytes"""
+    paths = []
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for name in sorted(filenames):
+            full = os.path.join(dirpath, name)
+            paths.append(os.path.relpath(full, root).replace(os.sep, "/"))
+    paths.sort(key=lambda p: (hash_path(p), p))
+
+    names = b""
+    name_offsets = []
+    for path in paths:
+        name_offsets.append(len(names))
+        names += path.encode("utf-8") + b"\0"
+
+    names_at = HEADER.size + ENTRY.size * len(paths)
+    data_at = names_at + len(names)
+    index = b""
+    payload = b""
+    for path, name in zip(paths, name_offsets):
+        with open(os.path.join(root, path), "rb") as f:
+            data = f.read()
+        pad = -(data_at + len(payload)) % align
+        payload += b"\0" * pad
+        index += ENTRY.pack(hash_path(path), name, data_at + len(payload),
+                            len(data))
+        payload += data
+
+    header = HEADER.pack(MAGIC, VERSION, align, len(paths), names_at)
+    return header + index + names + payload
+
+
+def c_array(pack, name):
+    """Returns the pack as C source for a 4-byte aligned const array"""
+    lines = ["// Made by lvpack.py, see Adafruit_LvGL_Glue_Assets.h",
+             "#include <stdint.h>",
+             "__attribute__((aligned(4))) const uint8_t %s[%d] = {" %
+             (name, len(pack))]
+    for i in range(0, len(pack), 16):
+        lines.append("  " + ", ".join("0x%02X" % b for b in pack[i:i + 16])
+                     + ",")
+    lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("root", help="directory of assets to pack")
+    parser.add_argument("output", help="pack file to write")
+    parser.add_argument("--align", type=int, default=4,
+                        help="alignment of asset data (power of 2), "
+                        "default 4; use 512 for SD card packs")
+    parser.add_argument("--c-array", metavar="NAME",
+                        help="write C source for a const array NAME")
+    args = parser.parse_args()
+    if args.align < 4 or args.align & (args.align - 1):
+        sys.exit("--align must be a power of 2, at least 4")
+
+    pack = build(args.root, args.align)
+    if args.c_array:
+        with open(args.output, "w") as f:
+            f.write(c_array(pack, args.c_array))
+    else:
+        with open(args.output, "wb") as f:
+            f.write(pack)
+    count = HEADER.unpack_from(pack)[3]
+    print("%s: %d assets, %d bytes" % (args.output, count, len(pack)))
+
+
+if __name__ == "__main__":
+    main()
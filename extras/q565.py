@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""Compress an RGB565 image into a Q565 .bin for Adafruit_LvGL_Glue_SD. The
+format is described in Adafruit_LvGL_Glue_SD.h.
+
+  q565.py cloudy.bin cloudy_q.bin   # Raw RGB565 .bin from LVGLImage.py
+  q565.py cloudy.png cloudy_q.bin   # Any image Pillow can read
+
+Copy the output to the SD card and draw it as usual, e.g.
+lv_image_set_src(img, "S:cloudy_q.bin"). Every file written is decoded
+again here and checked against the input.
+"""
+
+import argparse
+import struct
+import sys
+
+HEADER = struct.Struct("<BBHHHHH")  # lv_image_header_t
+COMPRESSED = struct.Struct("<III")  # method, compressed, decompressed size
+MAGIC = 0x19  # LV_IMAGE_HEADER_MAGIC
+CF_RGB565 = 0x12  # LV_COLOR_FORMAT_RGB565
+FLAG_COMPRESSED = 0x0008  # LV_IMAGE_FLAGS_COMPRESSED
+METHOD_Q565 = 15  # LVGL_COMPRESS_Q565
+
+
+def wrap(value, bits):
+    """value as a signed number of the given width, wrapping around"""
+    value &= (1 << bits) - 1
+    return value - (1 << bits) if value >> (bits - 1) else value
+
+
+def channels(p):
+    return p >> 11, (p >> 5) & 0x3F, p & 0x1F
+
+
+def encode(pixels):
+    """Returns the Q565 ops for a list of RGB565 pixels, as bytes"""
+    out = bytearray()
+    literal = []
+    prev = 0
+
+    def flush():
+        if literal:
+            out.append(0xC0 | (len(literal) - 1))
+            for p in literal:
+                out.extend(struct.pack("<H", p))
+            literal.clear()
+
+    i = 0
+    while i < len(pixels):
+        p = pixels[i]
+        if p == prev:
+            run = 1
+            while i + run < len(pixels) and pixels[i + run] == p and run < 64:
+                run += 1
+            flush()
+            out.append(run - 1)
+            i += run
+            continue
+        (r, g, b), (pr, pg, pb) = channels(p), channels(prev)
+        dr, dg, db = wrap(r - pr, 5), wrap(g - pg, 6), wrap(b - pb, 5)
+        lr, lb = wrap(dr - (dg >> 1), 5), wrap(db - (dg >> 1), 5)
+        if -2 <= dr <= 1 and -2 <= dg <= 1 and -2 <= db <= 1:
+            flush()
+            out.append(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2))
+        elif -8 <= lr <= 7 and -8 <= lb <= 7:
+            flush()
+            out.append(0x80 | (dg + 32))
+            out.append((lr + 8) << 4 | (lb + 8))
+        else:
+            literal.append(p)
+            if len(literal) == 64:
+                flush()
+        prev = p
+        i += 1
+    flush()
+    return bytes(out)
+
+
+def decode(data, count):
+    """Returns count RGB565 pixels decoded from Q565 ops, as the glue does"""
+    pixels = []
+    prev = 0
+    i = 0
+    while len(pixels) < count:
+        op = data[i]
+        i += 1
+        kind, n = op >> 6, (op & 0x3F) + 1
+        if kind == 0:
+            pixels.extend([prev] * n)
+            continue
+        if kind == 3:
+            pixels.extend(struct.unpack_from("<%dH" % n, data, i))
+            i += n * 2
+            prev = pixels[-1]
+            continue
+        if kind == 1:
+            dr, dg, db = (op >> 4 & 3) - 2, (op >> 2 & 3) - 2, (op & 3) - 2
+        else:
+            dg = (op & 0x3F) - 32
+            dr = (dg >> 1) + (data[i] >> 4) - 8
+            db = (dg >> 1) + (data[i] & 0xF) - 8
+            i += 1
+        r, g, b = channels(prev)
+        prev = ((r + dr) & 0x1F) << 11 | ((g + dg) & 0x3F) << 5 | (b + db) & 0x1F
+        pixels.append(prev)
+    return pixels[:count]
+
+
+def load(path):
+    """Returns (header fields, pixels) of a raw RGB565 .bin or an image"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:1] == bytes([MAGIC]):
+        magic, cf, flags, w, h, stride, _ = HEADER.unpack_from(data)
+        if cf != CF_RGB565 or flags & FLAG_COMPRESSED:
+            sys.exit("%s: not a raw RGB565 .bin" % path)
+        stride = stride or w * 2
+        body = data[HEADER.size:HEADER.size + stride * h]
+        if len(body) != stride * h:
+            sys.exit("%s: too short" % path)
+        return (flags, w, h, stride), list(struct.unpack("<%dH" % (len(body) // 2), body))
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit("Reading %s needs Pillow (pip install pillow)" % path)
+    img = Image.open(path).convert("RGB")
+    pixels = [(r >> 3) << 11 | (g >> 2) << 5 | b >> 3 for r, g, b in img.getdata()]
+    return (0, img.width, img.height, img.width * 2), pixels
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("input", help="raw RGB565 .bin, or an image file")
+    parser.add_argument("output", help="Q565 .bin file to write")
+    args = parser.parse_args()
+
+    (flags, w, h, stride), pixels = load(args.input)
+    ops = encode(pixels)
+    if decode(ops, len(pixels)) != pixels:
+        sys.exit("Internal error: %s doesn't decode back" % args.output)
+    with open(args.output, "wb") as f:
+        f.write(HEADER.pack(MAGIC, CF_RGB565, flags | FLAG_COMPRESSED, w, h,
+                            stride, 0))
+        f.write(COMPRESSED.pack(METHOD_Q565, len(ops), len(pixels) * 2))
+        f.write(ops)
+    print("%s: %dx%d, %d bytes of pixels in %d (%.0f%%)" %
+          (args.output, w, h, len(pixels) * 2, len(ops),
+           100.0 * len(ops) / (len(pixels) * 2)))
+
+
+if __name__ == "__main__":
+    main()